@@ -1,15 +1,49 @@
 #version 330
 
+// Shader program variant, defined by the image prop:
+//  NUMBER_OF_CHANNELS       Number of active channels (1: color mapped, 2: two-dimensional color mapped, 3: color space)
+//  COLOR_SPACE              Color space of three channel images (2: RGB, 3: HSL, 4: LAB)
+//  COLOR_SPACE_LOOKUP       HSL and LAB are converted with a trilinear fetch from the color space lookup texture instead of analytically
+//  COLOR_SPACE_LOOKUP_SIZE  Number of lattice points along each axis of the color space lookup texture (defined with COLOR_SPACE_LOOKUP)
+//  MASKED                   The mask excludes pixels
+//  CONSTANT_COLOR           The pixel color is constant and the alpha is modulated by the intensity of the first channel
+//  LABEL_MAP                The pixel color, visibility and selection are looked up per integer label (cluster index) in the label properties buffer
+#ifndef NUMBER_OF_CHANNELS
+#define NUMBER_OF_CHANNELS 1
+#endif
+
+#ifndef COLOR_SPACE
+#define COLOR_SPACE 2
+#endif
+
 uniform vec2 textureSize;                   // Size of the textures in pixels
-uniform sampler2D colorMapTexture;			// Colormap texture sampler
-uniform sampler2DArray channelTextures;		// Texture samplers (0: Scalar channel 1, 1: Scalar channel 2, 2: Scalar channel 3)
+uniform sampler2DArray colorMapTexture;     // Color map atlas texture sampler
+uniform float colorMapLayer;                // Color map atlas layer of the color map
+uniform vec2 colorMapSize;                  // Size of the color map in texels
+uniform vec2 colorMapAtlasSize;             // Size of a color map atlas slice in texels
+uniform bool colorMapNearest;               // Whether the color map is sampled with nearest neighbor interpolation
+uniform sampler2D channel1Texture;          // Scalar channel 1 texture sampler
+uniform sampler2D channel2Texture;          // Scalar channel 2 texture sampler
+uniform sampler2D channel3Texture;          // Scalar channel 3 texture sampler
+uniform vec2 channelDenormalizations[3];    // Reconstructs the channel value from the (compact) texture sample (x: scale, y: offset)
+uniform sampler2DArray dimensionsTexture;   // Resident dimensions texture sampler (one layer per dimension)
+uniform float channelLayers[3];             // Resident dimensions layer per channel (negative: sample the channel texture)
 uniform usampler2DArray maskTexture;        // Mask texture sampler
 uniform vec2 displayRanges[3];				// Display ranges for each channel
-uniform int noChannels;						// Number of active channels
-uniform bool useConstantColor;				// Whether the pixel color is constant and the alpha is modulated by the intensity of the selected channel
 uniform vec4 constantColor;					// Constant color
-uniform int colorSpace;						// Color space (2: RGB, 3: HSL, 3: LAB)
 uniform float opacity;						// Layer opacity
+uniform bool tiled;                         // Whether the channels and mask are sampled from a streamed tile
+uniform sampler2DArray tileTextures;        // Tile cache texture sampler (rgb: scalar channels, a: mask)
+uniform vec4 tileTransform;                 // Maps texture coordinates into the tile (xy: scale, zw: offset)
+uniform float tileLayer;                    // Tile cache layer of the tile
+uniform bool showSelection;                 // Whether the selection overlay is blended over the image
+uniform sampler2D selectionTexture;         // Selection texture sampler (non-zero: selected)
+uniform vec4 overlayColor;                  // Selection overlay color
+uniform float overlayOpacity;               // Selection overlay opacity
+uniform sampler3D colorSpaceLookupTexture;  // Color space lookup texture sampler (channels to RGB)
+uniform usampler2D labelTexture;            // Integer label texture sampler
+uniform samplerBuffer labelPropertiesTexture; // Label properties buffer texture sampler (two texels per label, rgba: color and opacity, r: visible, g: selected)
+uniform int numberOfLabels;                 // Number of labels in the label properties buffer
 in vec2 uv;									// Input texture coordinates
 out vec4 fragmentColor;						// Output fragment
 
@@ -22,6 +56,58 @@ float toneMapChannel(float minPixelValue, float maxPixelValue, float pixelValue)
     return clamp(fraction / range, 0.0, 1.0);
 }
 
+// Sample scalar channel from the channel texture, the resident dimensions texture or from the tile
+float sampleChannel(int channel)
+{
+    if (tiled)
+        return texture(tileTextures, vec3(uv * tileTransform.xy + tileTransform.zw, tileLayer))[channel];
+
+    float value = 0.0f;
+
+    // Changing the dimension of a resident channel only changes its layer
+    if (channelLayers[channel] >= 0.0f)
+        return texture(dimensionsTexture, vec3(uv, channelLayers[channel])).r * channelDenormalizations[channel].x + channelDenormalizations[channel].y;
+
+    switch (channel) {
+        case 0:
+            value = texture(channel1Texture, uv).r;
+            break;
+
+        case 1:
+            value = texture(channel2Texture, uv).r;
+            break;
+
+        case 2:
+            value = texture(channel3Texture, uv).r;
+            break;
+    }
+
+    return value * channelDenormalizations[channel].x + channelDenormalizations[channel].y;
+}
+
+// Sample mask from the mask texture or from the tile
+float sampleMask()
+{
+    if (tiled)
+        return texture(tileTextures, vec3(uv * tileTransform.xy + tileTransform.zw, tileLayer)).a > 0.0f ? 1.0f : 0.0f;
+
+    return texelFetch(maskTexture, ivec3(uv  * textureSize, 0), 0).r > 0u ? 1.0f : 0.0f;
+}
+
+// Sample the color map from its color map atlas slice
+vec4 sampleColorMap(vec2 coordinates)
+{
+    vec2 texel = coordinates * colorMapSize;
+
+    if (colorMapNearest)
+        return texelFetch(colorMapTexture, ivec3(clamp(ivec2(texel), ivec2(0), ivec2(colorMapSize) - 1), int(colorMapLayer)), 0);
+
+    // Clamp to the texel centers of the color map, so bilinear filtering does not bleed into the rest of the slice
+    texel = clamp(texel, vec2(0.5f), colorMapSize - vec2(0.5f));
+
+    return texture(colorMapTexture, vec3(texel / colorMapAtlasSize, colorMapLayer));
+}
+
 // Floating point modulo
 float fmodf(float x, float y)
 {
@@ -122,70 +208,85 @@ vec3 labToRgb(vec3 lab)
 
 void main(void)
 {
-    switch (noChannels) {
-        case 1:
-        {
-            // Grab channel(s)
-            float channel = toneMapChannel(displayRanges[0].x, displayRanges[0].y, texture(channelTextures, vec3(uv, 0)).r);
+#if defined(LABEL_MAP)
+    // Labels are never interpolated, pixels without a valid label are transparent
+    uint label = texelFetch(labelTexture, ivec2(uv * textureSize), 0).r;
 
-            fragmentColor = texture(colorMapTexture, vec2(channel, 0));
+    vec4 labelFlags = vec4(0.0f);
 
-            break;
-        }
-
-        case 2:
-        {
-            // Grab channel(s)
-            float channel1 = toneMapChannel(displayRanges[0].x, displayRanges[0].y, texture(channelTextures, vec3(uv, 0)).r);
-            float channel2 = toneMapChannel(displayRanges[1].x, displayRanges[1].y, texture(channelTextures, vec3(uv, 1)).r);
-            
-            // Color mapping
-            fragmentColor = texture(colorMapTexture, vec2(channel1, channel2));
-        }
-
-        case 3:
-        {
-            // Channels before color space conversion
-            vec3 channels;
-
-            // Grab channel(s)
-            channels.r = toneMapChannel(displayRanges[0].x, displayRanges[0].y, texture(channelTextures, vec3(uv, 0)).r);
-            channels.g = toneMapChannel(displayRanges[1].x, displayRanges[1].y, texture(channelTextures, vec3(uv, 1)).r);
-            channels.b = toneMapChannel(displayRanges[2].x, displayRanges[2].y, texture(channelTextures, vec3(uv, 2)).r);
-
-            switch (colorSpace) {
-                case 2:
-                {
-                    fragmentColor.rgb = channels;
-                    break;
-                }
-
-                case 3:
-                {
-                    fragmentColor.rgb = hslToRgb(360.0f * channels.r, channels.g, channels.b);
-                    break;
-                }
-
-                case 4:
-                {
-                    fragmentColor.rgb = labToRgb(channels);
-                    break;
-                }
-                
-                default:
-                    break;
-            }
-
-            break;
-        }
-    }
-
-    float mask = texelFetch(maskTexture, ivec3(uv  * textureSize, 0), 0).r > 0u ? 1.0f : 0.0f;
-
-    if (useConstantColor) {
-        fragmentColor = constantColor;
-        fragmentColor.a = mask * opacity * toneMapChannel(displayRanges[0].x, displayRanges[0].y, texture(channelTextures, vec3(uv, 0)).r);
+    if (label < uint(numberOfLabels)) {
+        labelFlags         = texelFetch(labelPropertiesTexture, 2 * int(label) + 1);
+        fragmentColor      = texelFetch(labelPropertiesTexture, 2 * int(label));
+        fragmentColor.a    = opacity * fragmentColor.a * labelFlags.r;
     } else {
-        fragmentColor.a = mask * opacity;
+        fragmentColor = vec4(0.0f);
+    }
+#elif defined(CONSTANT_COLOR)
+    fragmentColor      = constantColor;
+    fragmentColor.a    = opacity * toneMapChannel(displayRanges[0].x, displayRanges[0].y, sampleChannel(0));
+#elif NUMBER_OF_CHANNELS == 1
+    // Grab channel
+    float channel = toneMapChannel(displayRanges[0].x, displayRanges[0].y, sampleChannel(0));
+
+    // Color mapping
+    fragmentColor      = sampleColorMap(vec2(channel, 0));
+    fragmentColor.a    = opacity;
+#elif NUMBER_OF_CHANNELS == 2
+    // Grab channels
+    float channel1 = toneMapChannel(displayRanges[0].x, displayRanges[0].y, sampleChannel(0));
+    float channel2 = toneMapChannel(displayRanges[1].x, displayRanges[1].y, sampleChannel(1));
+
+    // Color mapping
+    fragmentColor      = sampleColorMap(vec2(channel1, channel2));
+    fragmentColor.a    = opacity;
+#else
+    // Channels before color space conversion
+    vec3 channels;
+
+    // Grab channels
+    channels.r = toneMapChannel(displayRanges[0].x, displayRanges[0].y, sampleChannel(0));
+    channels.g = toneMapChannel(displayRanges[1].x, displayRanges[1].y, sampleChannel(1));
+    channels.b = toneMapChannel(displayRanges[2].x, displayRanges[2].y, sampleChannel(2));
+
+#if defined(COLOR_SPACE_LOOKUP) && (COLOR_SPACE == 3 || COLOR_SPACE == 4)
+    // Map the channels onto the texel centers of the lookup table lattice
+    const float lookupSize = float(COLOR_SPACE_LOOKUP_SIZE);
+
+    fragmentColor.rgb = texture(colorSpaceLookupTexture, channels * ((lookupSize - 1.0f) / lookupSize) + 0.5f / lookupSize).rgb;
+#elif COLOR_SPACE == 3
+    fragmentColor.rgb = hslToRgb(360.0f * channels.r, channels.g, channels.b);
+#elif COLOR_SPACE == 4
+    fragmentColor.rgb = labToRgb(channels);
+#else
+    fragmentColor.rgb = channels;
+#endif
+
+    fragmentColor.a = opacity;
+#endif
+
+    float mask = 1.0f;
+
+#ifdef MASKED
+    mask = sampleMask();
+
+    fragmentColor.a *= mask;
+#endif
+
+#if defined(LABEL_MAP)
+    // Selected labels are flagged in the label properties (hidden labels are never highlighted)
+    bool selected = labelFlags.r > 0.0f && labelFlags.g > 0.0f;
+#else
+    // The overlay of streamed images might have a lower resolution than the image, so it is sampled with normalized coordinates (nearest filtering)
+    bool selected = showSelection && texture(selectionTexture, uv).r > 0.0f;
+#endif
+
+    // Blend the selection overlay over the image (equivalent to drawing it in a separate pass with source-over blending)
+    if (showSelection && mask > 0.0f && selected) {
+        float alpha = overlayOpacity + fragmentColor.a * (1.0f - overlayOpacity);
+
+        if (alpha > 0.0f)
+            fragmentColor.rgb = (overlayColor.rgb * overlayOpacity + fragmentColor.rgb * fragmentColor.a * (1.0f - overlayOpacity)) / alpha;
+
+        fragmentColor.a = alpha;
     }
 }
@@ -6,11 +6,24 @@ layout(location = 1) in vec2 texCoord;
 out vec2 uv;
 
 uniform mat4 transform;
+uniform vec2 textureSize;                   // Size of the image in pixels
+uniform bool tiled;                         // Whether the quad is drawn tile by tile
+uniform vec4 tileBounds;                    // Texture coordinates of the tile being drawn (xy: minimum, zw: maximum)
 
 void main(void)
 {
-    gl_Position = transform * vertex;
-
     // Flip the uv x-axis
     uv = vec2(1.0f - texCoord.x, texCoord.y);
+
+    vec4 position = vertex;
+
+    // Shrink the quad to the tile
+    if (tiled) {
+        vec2 tileUV = mix(tileBounds.xy, tileBounds.zw, uv);
+
+        position.xy += (tileUV - uv) * textureSize;
+        uv          = tileUV;
+    }
+
+    gl_Position = transform * position;
 }
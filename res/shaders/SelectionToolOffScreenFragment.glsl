@@ -1,6 +1,5 @@
 #version 330
 
-uniform sampler2D pixelSelectionTexture;
 uniform int selectionType;
 uniform vec2 previousBrushCenter;
 uniform vec2 currentBrushCenter;
@@ -126,8 +125,8 @@ void main(void)
         // Brush
         case 1:
         {
-            bool inBrush        = length(P - currentBrushCenter) < brushRadius;
-            bool prevInBrush    = texture(pixelSelectionTexture, vec2(1.0f - uv.x, uv.y)).r > 0;
+            // Strokes accumulate through max blending with the existing selection buffer content
+            bool inBrush = length(P - currentBrushCenter) < brushRadius;
             
             if (currentBrushCenter != previousBrushCenter) {
                 vec2 A      = currentBrushCenter - previousBrushCenter;
@@ -143,7 +142,7 @@ void main(void)
                 }
             }
 
-            fragmentColor = (inBrush || prevInBrush) ? vec4(1) : vec4(vec3(0), 1);
+            fragmentColor = inBrush ? vec4(1) : vec4(vec3(0), 1);
             break;
         }
 
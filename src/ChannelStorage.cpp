@@ -0,0 +1,282 @@
+#include "ChannelStorage.h"
+
+#include <QFloat16>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+ChannelStorage::ChannelStorage(const QVector<float>& scalarData, const QSize& size, bool allowCompression) :
+    _format(Format::Float32),
+    _size(size),
+    _scale(1.0f),
+    _offset(0.0f),
+    _data()
+{
+    if (scalarData.isEmpty())
+        return;
+
+    auto minimum    = std::numeric_limits<float>::max();
+    auto maximum    = std::numeric_limits<float>::lowest();
+    auto integral   = true;
+
+    for (const auto& value : scalarData) {
+        if (!std::isfinite(value))
+            return;
+
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+
+        if (integral && value != std::floor(value))
+            integral = false;
+    }
+
+    const auto range = maximum - minimum;
+
+    _offset = minimum;
+
+    // Integral data that fits in eight bits
+    if (integral && range <= 255.0f) {
+        _format = Format::UInt8;
+        _scale  = 255.0f;
+
+        _data.resize(scalarData.size());
+
+        auto texels = reinterpret_cast<std::uint8_t*>(_data.data());
+
+        for (qsizetype index = 0; index < scalarData.size(); index++)
+            texels[index] = static_cast<std::uint8_t>(scalarData[index] - minimum);
+
+        return;
+    }
+
+    // Lossy block compression of the data quantized to eight bits (the user accepted the loss)
+    if (allowCompression && _size.width() > 0 && _size.height() > 0) {
+        _format = Format::BC4;
+        _scale  = range > 0.0f ? range : 1.0f;
+
+        encodeBC4(scalarData);
+
+        return;
+    }
+
+    // Integral data that fits in sixteen bits
+    if (integral && range <= 65535.0f) {
+        _format = Format::UInt16;
+        _scale  = 65535.0f;
+
+        _data.resize(scalarData.size() * sizeof(std::uint16_t));
+
+        auto texels = reinterpret_cast<std::uint16_t*>(_data.data());
+
+        for (qsizetype index = 0; index < scalarData.size(); index++)
+            texels[index] = static_cast<std::uint16_t>(scalarData[index] - minimum);
+
+        return;
+    }
+
+    // Half precision when the conversion error stays well below the display quantization of the range
+    if (range <= 65504.0f) {
+        const auto tolerance = range / 4096.0f;
+
+        QByteArray data(scalarData.size() * sizeof(qfloat16), Qt::Uninitialized);
+
+        auto texels = reinterpret_cast<qfloat16*>(data.data());
+
+        for (qsizetype index = 0; index < scalarData.size(); index++) {
+            texels[index] = qfloat16(scalarData[index] - minimum);
+
+            if (std::abs(static_cast<float>(texels[index]) + minimum - scalarData[index]) > tolerance) {
+                _offset = 0.0f;
+                return;
+            }
+        }
+
+        _format = Format::Float16;
+        _data   = data;
+
+        return;
+    }
+
+    _offset = 0.0f;
+}
+
+ChannelStorage::ChannelStorage(const QSize& size) :
+    _format(Format::Float32),
+    _size(size),
+    _scale(1.0f),
+    _offset(0.0f),
+    _data()
+{
+}
+
+ChannelStorage ChannelStorage::createUInt16(const QVector<float>& scalarData, const QSize& size)
+{
+    ChannelStorage channelStorage(size);
+
+    channelStorage._format = Format::UInt16;
+
+    if (scalarData.isEmpty())
+        return channelStorage;
+
+    auto minimum    = std::numeric_limits<float>::max();
+    auto maximum    = std::numeric_limits<float>::lowest();
+    auto integral   = true;
+
+    for (const auto& value : scalarData) {
+        if (!std::isfinite(value))
+            continue;
+
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+
+        if (integral && value != std::floor(value))
+            integral = false;
+    }
+
+    if (minimum > maximum)
+        minimum = maximum = 0.0f;
+
+    const auto range = maximum - minimum;
+
+    // Integral data is stored exactly when it fits, everything else is quantized over its range
+    channelStorage._offset  = minimum;
+    channelStorage._scale   = (integral && range <= 65535.0f) ? 65535.0f : std::max(range, std::numeric_limits<float>::min());
+
+    channelStorage._data.resize(scalarData.size() * sizeof(std::uint16_t));
+
+    auto texels = reinterpret_cast<std::uint16_t*>(channelStorage._data.data());
+
+    const auto factor = 65535.0f / channelStorage._scale;
+
+    for (qsizetype index = 0; index < scalarData.size(); index++) {
+        const auto value = std::isfinite(scalarData[index]) ? scalarData[index] : minimum;
+
+        texels[index] = static_cast<std::uint16_t>(std::clamp(std::lround((value - minimum) * factor), 0l, 65535l));
+    }
+
+    return channelStorage;
+}
+
+float ChannelStorage::getBytesPerTexel() const
+{
+    switch (_format)
+    {
+        case Format::Float32:
+            return 4.0f;
+
+        case Format::Float16:
+        case Format::UInt16:
+            return 2.0f;
+
+        case Format::UInt8:
+            return 1.0f;
+
+        case Format::BC4:
+            return 0.5f;
+
+        default:
+            break;
+    }
+
+    return 4.0f;
+}
+
+QString ChannelStorage::getFormatName(const Format& format)
+{
+    switch (format)
+    {
+        case Format::Float32:
+            return "R32F";
+
+        case Format::Float16:
+            return "R16F";
+
+        case Format::UInt16:
+            return "R16";
+
+        case Format::UInt8:
+            return "R8";
+
+        case Format::BC4:
+            return "BC4";
+
+        default:
+            break;
+    }
+
+    return {};
+}
+
+void ChannelStorage::encodeBC4(const QVector<float>& scalarData)
+{
+    const auto width            = _size.width();
+    const auto height           = _size.height();
+    const auto numberOfBlocksX  = (width + 3) / 4;
+    const auto numberOfBlocksY  = (height + 3) / 4;
+
+    _data.resize(static_cast<qsizetype>(numberOfBlocksX) * numberOfBlocksY * 8);
+
+    auto block = reinterpret_cast<std::uint8_t*>(_data.data());
+
+    // Quantize a scalar to eight bits
+    const auto quantize = [this](float value) -> std::uint8_t {
+        return static_cast<std::uint8_t>(std::clamp(std::lround(255.0f * (value - _offset) / _scale), 0l, 255l));
+    };
+
+    std::array<std::uint8_t, 16> texels{};
+    std::array<std::int32_t, 8> palette{};
+
+    for (std::int32_t blockY = 0; blockY < numberOfBlocksY; blockY++) {
+        for (std::int32_t blockX = 0; blockX < numberOfBlocksX; blockX++, block += 8) {
+
+            // Gather the block texels (edges are clamped)
+            for (std::int32_t texelIndex = 0; texelIndex < 16; texelIndex++) {
+                const auto pixelX = std::min(blockX * 4 + texelIndex % 4, width - 1);
+                const auto pixelY = std::min(blockY * 4 + texelIndex / 4, height - 1);
+
+                texels[texelIndex] = quantize(scalarData[static_cast<qsizetype>(pixelY) * width + pixelX]);
+            }
+
+            const auto [minimumTexel, maximumTexel] = std::minmax_element(texels.begin(), texels.end());
+
+            // Endpoints in eight-value interpolation mode (red0 > red1)
+            const auto red0 = *maximumTexel;
+            const auto red1 = *minimumTexel;
+
+            palette[0] = red0;
+            palette[1] = red1;
+
+            for (std::int32_t paletteIndex = 2; paletteIndex < 8; paletteIndex++)
+                palette[paletteIndex] = ((8 - paletteIndex) * red0 + (paletteIndex - 1) * red1) / 7;
+
+            std::uint64_t indices = 0;
+
+            // Pick the closest palette entry for each texel (all zero when the block is uniform)
+            if (red0 != red1) {
+                for (std::int32_t texelIndex = 0; texelIndex < 16; texelIndex++) {
+                    std::uint64_t closestIndex  = 0;
+                    std::int32_t closestError   = 256;
+
+                    for (std::int32_t paletteIndex = 0; paletteIndex < 8; paletteIndex++) {
+                        const auto error = std::abs(palette[paletteIndex] - texels[texelIndex]);
+
+                        if (error < closestError) {
+                            closestError = error;
+                            closestIndex = static_cast<std::uint64_t>(paletteIndex);
+                        }
+                    }
+
+                    indices |= closestIndex << (3 * texelIndex);
+                }
+            }
+
+            block[0] = red0;
+            block[1] = red1;
+
+            for (std::int32_t byteIndex = 0; byteIndex < 6; byteIndex++)
+                block[2 + byteIndex] = static_cast<std::uint8_t>((indices >> (8 * byteIndex)) & 0xFF);
+        }
+    }
+}
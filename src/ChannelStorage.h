@@ -0,0 +1,101 @@
+#pragma once
+
+#include <QByteArray>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+#include <cstdint>
+
+/**
+ * Channel storage class
+ *
+ * Packs channel scalar data into the most compact GPU texture format that preserves it:
+ *  - integral data with a range of at most 255 is stored as R8 (unsigned normalized)
+ *  - integral data with a range of at most 65535 is stored as R16 (unsigned normalized)
+ *  - data that survives conversion to half precision (after subtracting the minimum) is stored as R16F
+ *  - everything else remains R32F
+ * Optionally, data that is not stored exactly as R8 is block-compressed with RGTC1 (BC4), this is lossy (eight bits per channel at most)
+ *
+ * The shader reconstructs the original value with: value = sample * scale + offset
+ */
+class ChannelStorage
+{
+public:
+
+    /** Texture storage formats */
+    enum class Format {
+        Float32,        /** 32-bit floating point (R32F) */
+        Float16,        /** 16-bit floating point (R16F) */
+        UInt16,         /** 16-bit unsigned normalized (R16) */
+        UInt8,          /** 8-bit unsigned normalized (R8) */
+        BC4             /** RGTC1 block compressed unsigned normalized (four bits per texel) */
+    };
+
+public: // Construction
+
+    /**
+     * Construct from \p scalarData
+     * @param scalarData Scalar data in row-column order
+     * @param size Image size
+     * @param allowCompression Whether lossy block compression may be used (integral data with a range of at most 255 is stored exactly regardless)
+     */
+    ChannelStorage(const QVector<float>& scalarData, const QSize& size, bool allowCompression);
+
+    /**
+     * Create sixteen bit storage for \p scalarData (exact for integral data with a range of at most 65535, quantized to 65536 levels otherwise)
+     * Used where all channels have to share one texture format (e.g. a texture array with all dimensions)
+     * @param scalarData Scalar data in row-column order
+     * @param size Image size
+     * @return Channel storage in UInt16 format
+     */
+    static ChannelStorage createUInt16(const QVector<float>& scalarData, const QSize& size);
+
+public: // Getters
+
+    /** Get the storage format */
+    Format getFormat() const { return _format; }
+
+    /** Get the image size */
+    QSize getSize() const { return _size; }
+
+    /** Get the scale with which the normalized texture sample is multiplied */
+    float getScale() const { return _scale; }
+
+    /** Get the offset that is added to the scaled texture sample */
+    float getOffset() const { return _offset; }
+
+    /** Get the packed texel data (empty for Float32, the scalar data is uploaded directly) */
+    const QByteArray& getData() const { return _data; }
+
+    /** Get the number of bytes per texel in GPU memory (fractional for block compressed formats) */
+    float getBytesPerTexel() const;
+
+    /**
+     * Get the format name
+     * @param format Storage format
+     * @return Human readable format name
+     */
+    static QString getFormatName(const Format& format);
+
+private:
+
+    /**
+     * Construct empty storage with \p size
+     * @param size Image size
+     */
+    explicit ChannelStorage(const QSize& size);
+
+    /**
+     * Encode \p scalarData quantized to eight bits into RGTC1 blocks
+     * @param scalarData Scalar data in row-column order
+     */
+    void encodeBC4(const QVector<float>& scalarData);
+
+private:
+    Format          _format;    /** Storage format */
+    QSize           _size;      /** Image size */
+    float           _scale;     /** Denormalization scale */
+    float           _offset;    /** Denormalization offset */
+    QByteArray      _data;      /** Packed texel data */
+};
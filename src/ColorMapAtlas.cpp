@@ -0,0 +1,195 @@
+#include "ColorMapAtlas.h"
+
+#include <QCryptographicHash>
+#include <QOpenGLPixelTransferOptions>
+
+#include <algorithm>
+#include <stdexcept>
+
+ColorMapAtlas::ColorMapAtlas() :
+    _entries(),
+    _layers(),
+    _texture(),
+    _sliceSize(),
+    _numberOfLayers(0)
+{
+}
+
+ColorMapAtlas::SliceHandle ColorMapAtlas::acquire(const QImage& colorMapImage)
+{
+    if (colorMapImage.isNull())
+        return nullptr;
+
+    // Texture rows are bottom to top
+    const auto image    = colorMapImage.mirrored().convertToFormat(QImage::Format_RGBA8888);
+    const auto key      = getKey(image);
+
+    // Share the slice of an identical color map
+    if (_layers.contains(key)) {
+        if (auto slice = _entries[_layers[key]]._slice.lock())
+            return slice;
+
+        _layers.remove(key);
+    }
+
+    // Reuse the first free layer or append one
+    auto layer = static_cast<std::int32_t>(std::find_if(_entries.begin(), _entries.end(), [](const Entry& entry) -> bool {
+        return entry._slice.expired();
+    }) - _entries.begin());
+
+    if (layer == static_cast<std::int32_t>(_entries.size()))
+        _entries.emplace_back();
+
+    auto& entry = _entries[layer];
+
+    // Forget the color map that previously occupied the layer
+    if (!entry._image.isNull()) {
+        const auto previousKey = getKey(entry._image);
+
+        if (_layers.value(previousKey, -1) == layer)
+            _layers.remove(previousKey);
+    }
+
+    auto slice = std::make_shared<Slice>(Slice{ layer, image.size(), key });
+
+    entry._slice    = slice;
+    entry._image    = image;
+
+    _layers[key] = layer;
+
+    upload(layer);
+
+    return slice;
+}
+
+ColorMapAtlas::SliceHandle ColorMapAtlas::update(const SliceHandle& slice, const QImage& colorMapImage)
+{
+    if (colorMapImage.isNull())
+        return slice;
+
+    if (slice == nullptr)
+        return acquire(colorMapImage);
+
+    const auto image    = colorMapImage.mirrored().convertToFormat(QImage::Format_RGBA8888);
+    const auto key      = getKey(image);
+
+    // Unchanged
+    if (slice->_key == key)
+        return slice;
+
+    const auto shared = _layers.contains(key) && !_entries[_layers[key]]._slice.expired();
+
+    // Other layers use the current slice or the color map exists already
+    if (slice.use_count() > 1 || shared)
+        return acquire(colorMapImage);
+
+    // Overwrite the slice of the caller in place
+    auto& entry = _entries[slice->_layer];
+    auto mutableSlice = entry._slice.lock();
+
+    _layers.remove(mutableSlice->_key);
+
+    mutableSlice->_size = image.size();
+    mutableSlice->_key  = key;
+
+    entry._image = image;
+
+    _layers[key] = mutableSlice->_layer;
+
+    upload(mutableSlice->_layer);
+
+    return slice;
+}
+
+bool ColorMapAtlas::bind()
+{
+    if (_entries.empty())
+        return false;
+
+    if (!_texture)
+        reallocate();
+
+    _texture->bind();
+
+    return true;
+}
+
+void ColorMapAtlas::release()
+{
+    if (_texture)
+        _texture->release();
+}
+
+std::int32_t ColorMapAtlas::getNumberOfColorMaps() const
+{
+    return static_cast<std::int32_t>(std::count_if(_entries.begin(), _entries.end(), [](const Entry& entry) -> bool {
+        return !entry._slice.expired();
+    }));
+}
+
+void ColorMapAtlas::destroy()
+{
+    _texture.reset();
+}
+
+void ColorMapAtlas::upload(std::int32_t layer)
+{
+    const auto& image = _entries[layer]._image;
+
+    // Grow the atlas when the color map does not fit
+    if (!_texture || layer >= _numberOfLayers || image.width() > _sliceSize.width() || image.height() > _sliceSize.height()) {
+        reallocate();
+        return;
+    }
+
+    QOpenGLPixelTransferOptions pixelTransferOptions;
+
+    pixelTransferOptions.setAlignment(4);
+
+    _texture->setData(0, 0, 0, image.width(), image.height(), 1, 0, layer, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, image.constBits(), &pixelTransferOptions);
+}
+
+void ColorMapAtlas::reallocate()
+{
+    QSize sliceSize(1, 1);
+
+    for (const auto& entry : _entries)
+        sliceSize = sliceSize.expandedTo(entry._image.size());
+
+    // Leave room for a few more layers, so adding a color map does not re-create the texture every time
+    _sliceSize      = sliceSize;
+    _numberOfLayers = std::max(8, 2 * static_cast<std::int32_t>(_entries.size()));
+
+    _texture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2DArray);
+
+    _texture->setSize(_sliceSize.width(), _sliceSize.height());
+    _texture->setLayers(_numberOfLayers);
+    _texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    _texture->setMipLevels(1);
+    _texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+
+    if (!_texture->isStorageAllocated())
+        throw std::runtime_error("Unable to allocate the color map atlas texture");
+
+    // Color maps are sampled with bilinear filtering (nearest neighbor is resolved in the shader)
+    _texture->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
+    _texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+
+    for (std::int32_t layer = 0; layer < static_cast<std::int32_t>(_entries.size()); layer++)
+        if (!_entries[layer]._image.isNull())
+            upload(layer);
+}
+
+QByteArray ColorMapAtlas::getKey(const QImage& colorMapImage)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    const std::int32_t size[2] = { colorMapImage.width(), colorMapImage.height() };
+
+    hash.addData(QByteArrayView(reinterpret_cast<const char*>(size), sizeof(size)));
+
+    for (std::int32_t y = 0; y < colorMapImage.height(); y++)
+        hash.addData(QByteArrayView(reinterpret_cast<const char*>(colorMapImage.constScanLine(y)), 4 * colorMapImage.width()));
+
+    return hash.result();
+}
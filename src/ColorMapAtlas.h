@@ -0,0 +1,112 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QOpenGLTexture>
+#include <QSize>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Color map atlas class
+ *
+ * Two-dimensional texture array in which the (one- and two-dimensional) color maps of all layers are stored, one color map per slice
+ * Slices are keyed by color map content, so layers with identical color maps share a slice
+ *
+ * Layers hold reference-counted handles to their slice, a slice is reused once no layer references it anymore
+ * Changing a color map that only one layer uses overwrites its slice in place (glTexSubImage3D), the texture is only reallocated when the atlas grows
+ *
+ * All functions expect the viewer OpenGL context to be bound
+ */
+class ColorMapAtlas
+{
+public:
+
+    /** Color map slice */
+    struct Slice {
+        std::int32_t    _layer;     /** Texture array layer */
+        QSize           _size;      /** Size of the color map in texels (the rest of the slice is unused) */
+        QByteArray      _key;       /** Content key */
+    };
+
+    /** Handle to a color map slice */
+    using SliceHandle = std::shared_ptr<const Slice>;
+
+public: // Construction
+
+    /** Default constructor */
+    ColorMapAtlas();
+
+public: // Color maps
+
+    /**
+     * Get a slice that holds \p colorMapImage, an existing slice is shared when it holds the same color map
+     * @param colorMapImage Color map image (rows top to bottom)
+     * @return Handle to the slice (nullptr when the image is invalid)
+     */
+    SliceHandle acquire(const QImage& colorMapImage);
+
+    /**
+     * Replace the color map of \p slice with \p colorMapImage
+     * The slice is overwritten in place when \p slice is the only reference to it and no other slice holds the color map already
+     * @param slice Handle to the current slice of the caller (might be nullptr)
+     * @param colorMapImage Color map image (rows top to bottom)
+     * @return Handle to the slice that holds \p colorMapImage
+     */
+    SliceHandle update(const SliceHandle& slice, const QImage& colorMapImage);
+
+public: // Texture
+
+    /**
+     * Bind the atlas texture to the active texture unit (it is re-created when the context was destroyed)
+     * @return Whether the texture is bound
+     */
+    bool bind();
+
+    /** Release the atlas texture from the active texture unit */
+    void release();
+
+    /** Get the size of a slice in texels */
+    QSize getSliceSize() const { return _sliceSize; }
+
+    /** Get the number of color maps that are referenced by layers */
+    std::int32_t getNumberOfColorMaps() const;
+
+    /** Destroy the atlas texture (the color maps are kept and uploaded again on the next bind) */
+    void destroy();
+
+protected:
+
+    /**
+     * Upload the color map of the slice at \p layer (re-creates the texture when the slice does not fit)
+     * @param layer Texture array layer
+     */
+    void upload(std::int32_t layer);
+
+    /** Re-create the texture with room for all slices and upload all color maps */
+    void reallocate();
+
+    /**
+     * Get the content key of \p colorMapImage
+     * @param colorMapImage Color map image in RGBA8888 format
+     * @return Content key (hash of the size and texels)
+     */
+    static QByteArray getKey(const QImage& colorMapImage);
+
+private:
+
+    /** Atlas entry (one per texture array layer) */
+    struct Entry {
+        std::weak_ptr<Slice>    _slice;     /** Weak reference to the slice (layers own it), expired when the layer is free */
+        QImage                  _image;     /** Color map in texture orientation (kept to upload again when the texture grows) */
+    };
+
+    std::vector<Entry>                  _entries;               /** Entries by texture array layer */
+    QHash<QByteArray, std::int32_t>     _layers;                /** Texture array layer by content key */
+    std::unique_ptr<QOpenGLTexture>     _texture;               /** Atlas texture (two-dimensional texture array) */
+    QSize                               _sliceSize;             /** Allocated slice size in texels */
+    std::int32_t                        _numberOfLayers;        /** Allocated number of texture array layers */
+};
@@ -0,0 +1,120 @@
+#include "ColorSpaceLookupTable.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace mv::util;
+
+ColorSpaceLookupTable::ColorSpaceLookupTable(const ColorSpaceType& colorSpaceType) :
+    _colorSpaceType(colorSpaceType),
+    _data(4 * size * size * size, Qt::Uninitialized)
+{
+    auto texel = reinterpret_cast<std::uint8_t*>(_data.data());
+
+    // Lattice points lie on the texel centers, so normalized channel values map onto them exactly
+    const auto toNormalized = [](std::int32_t index) -> float {
+        return static_cast<float>(index) / static_cast<float>(size - 1);
+    };
+
+    const auto toUnsignedByte = [](float value) -> std::uint8_t {
+        return static_cast<std::uint8_t>(std::lround(255.0f * std::clamp(value, 0.0f, 1.0f)));
+    };
+
+    for (std::int32_t z = 0; z < size; z++) {
+        for (std::int32_t y = 0; y < size; y++) {
+            for (std::int32_t x = 0; x < size; x++) {
+                const auto channels = QVector3D(toNormalized(x), toNormalized(y), toNormalized(z));
+
+                QVector3D rgb;
+
+                switch (_colorSpaceType)
+                {
+                    // The last hue lattice point wraps around to red, so interpolation towards it does not fade to black
+                    case ColorSpaceType::HSL:
+                        rgb = hslToRgb(std::fmod(360.0f * channels.x(), 360.0f), channels.y(), channels.z());
+                        break;
+
+                    case ColorSpaceType::LAB:
+                        rgb = labToRgb(channels);
+                        break;
+
+                    default:
+                        rgb = channels;
+                        break;
+                }
+
+                texel[0] = toUnsignedByte(rgb.x());
+                texel[1] = toUnsignedByte(rgb.y());
+                texel[2] = toUnsignedByte(rgb.z());
+                texel[3] = 255;
+
+                texel += 4;
+            }
+        }
+    }
+}
+
+const ColorSpaceLookupTable& ColorSpaceLookupTable::get(const ColorSpaceType& colorSpaceType)
+{
+    static const ColorSpaceLookupTable hslLookupTable(ColorSpaceType::HSL);
+    static const ColorSpaceLookupTable labLookupTable(ColorSpaceType::LAB);
+
+    return colorSpaceType == ColorSpaceType::LAB ? labLookupTable : hslLookupTable;
+}
+
+QVector3D ColorSpaceLookupTable::hslToRgb(float hue, float saturation, float lightness)
+{
+    const auto chroma   = (1.0f - std::abs(2.0f * lightness - 1.0f)) * saturation;
+    const auto h1       = hue / 60.0f;
+    const auto x        = chroma * (1.0f - std::abs(h1 - 2.0f * std::floor(h1 / 2.0f) - 1.0f));
+
+    QVector3D rgb1;
+
+    if (0.0f <= h1 && h1 < 1.0f)
+        rgb1 = QVector3D(chroma, x, 0.0f);
+    else if (1.0f <= h1 && h1 < 2.0f)
+        rgb1 = QVector3D(x, chroma, 0.0f);
+    else if (2.0f <= h1 && h1 < 3.0f)
+        rgb1 = QVector3D(0.0f, chroma, x);
+    else if (3.0f <= h1 && h1 < 4.0f)
+        rgb1 = QVector3D(0.0f, x, chroma);
+    else if (4.0f <= h1 && h1 < 5.0f)
+        rgb1 = QVector3D(x, 0.0f, chroma);
+    else if (5.0f <= h1 && h1 < 6.0f)
+        rgb1 = QVector3D(chroma, 0.0f, x);
+    else
+        rgb1 = QVector3D(0.0f, 0.0f, 0.0f);
+
+    const auto m = lightness - 0.5f * chroma;
+
+    return rgb1 + QVector3D(m, m, m);
+}
+
+QVector3D ColorSpaceLookupTable::labToRgb(const QVector3D& lab)
+{
+    const auto scaledLab = 255.0f * lab;
+
+    auto y = (scaledLab.x() + 16.0f) / 116.0f;
+    auto x = scaledLab.y() / 500.0f + y;
+    auto z = y - scaledLab.z() / 200.0f;
+
+    const auto toLinear = [](float value) -> float {
+        return (value * value * value > 0.008856f) ? value * value * value : (value - 16.0f / 116.0f) / 7.787f;
+    };
+
+    x = 0.95047f * toLinear(x);
+    y = 1.00000f * toLinear(y);
+    z = 1.08883f * toLinear(z);
+
+    const auto toGammaCorrected = [](float value) -> float {
+        value = (value > 0.0031308f) ? (1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f) : 12.92f * value;
+
+        return std::clamp(value, 0.0f, 1.0f);
+    };
+
+    return {
+        toGammaCorrected(x *  3.2406f + y * -1.5372f + z * -0.4986f),
+        toGammaCorrected(x * -0.9689f + y *  1.8758f + z *  0.0415f),
+        toGammaCorrected(x *  0.0557f + y * -0.2040f + z *  1.0570f)
+    };
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <util/ColorSpace.h>
+
+#include <QByteArray>
+#include <QVector3D>
+
+#include <cstdint>
+
+/**
+ * Color space lookup table class
+ *
+ * Three-dimensional RGBA8 lookup table that maps normalized channel values (the axes) to RGB colors
+ * Replaces the per-fragment HSL and LAB conversions with a single trilinear texture fetch, at the cost of eight bit precision and interpolation error near hue sector boundaries
+ *
+ * The tables are generated once per color space and shared by all layers
+ */
+class ColorSpaceLookupTable
+{
+public:
+
+    /** Number of lattice points along each axis */
+    static constexpr std::int32_t size = 64;
+
+public: // Construction
+
+    /**
+     * Get the (lazily generated) lookup table for \p colorSpaceType
+     * @param colorSpaceType Color space of the channels (HSL or LAB)
+     * @return Reference to the lookup table
+     */
+    static const ColorSpaceLookupTable& get(const mv::util::ColorSpaceType& colorSpaceType);
+
+public: // Getters
+
+    /** Get the color space of the channels */
+    mv::util::ColorSpaceType getColorSpaceType() const { return _colorSpaceType; }
+
+    /** Get the RGBA8 texel data (the first channel varies fastest, the third slowest) */
+    const QByteArray& getData() const { return _data; }
+
+public: // Conversion
+
+    /**
+     * Convert from HSL to RGB color space (identical to the image fragment shader)
+     * @param hue Hue in degrees [0, 360]
+     * @param saturation Saturation [0, 1]
+     * @param lightness Lightness [0, 1]
+     * @return RGB color
+     */
+    static QVector3D hslToRgb(float hue, float saturation, float lightness);
+
+    /**
+     * Convert from LAB to RGB color space (identical to the image fragment shader)
+     * @param lab Normalized LAB color
+     * @return RGB color
+     */
+    static QVector3D labToRgb(const QVector3D& lab);
+
+private:
+
+    /**
+     * Generate the lookup table for \p colorSpaceType
+     * @param colorSpaceType Color space of the channels (HSL or LAB)
+     */
+    explicit ColorSpaceLookupTable(const mv::util::ColorSpaceType& colorSpaceType);
+
+private:
+    mv::util::ColorSpaceType    _colorSpaceType;    /** Color space of the channels */
+    QByteArray                  _data;              /** RGBA8 texel data */
+};
@@ -0,0 +1,89 @@
+#include "DimensionCache.h"
+
+DimensionCache::DimensionCache(std::uint64_t budget /*= 0*/) :
+    _budget(budget),
+    _numberOfBytes(0),
+    _entries(),
+    _lookup()
+{
+}
+
+void DimensionCache::setBudget(std::uint64_t budget)
+{
+    _budget = budget;
+
+    evict();
+}
+
+void DimensionCache::clear()
+{
+    _entries.clear();
+    _lookup.clear();
+
+    _numberOfBytes = 0;
+}
+
+void DimensionCache::remove(const QString& datasetId)
+{
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        if (it->_key._datasetId == datasetId) {
+            _numberOfBytes -= it->_entry.getNumberOfBytes();
+
+            _lookup.remove(it->_key.toString());
+
+            it = _entries.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+bool DimensionCache::find(const Key& key, Entry& entry)
+{
+    const auto it = _lookup.find(key.toString());
+
+    if (it == _lookup.end())
+        return false;
+
+    // Move to the front of the recency list
+    _entries.splice(_entries.begin(), _entries, it.value());
+
+    entry = it.value()->_entry;
+
+    return true;
+}
+
+void DimensionCache::insert(const Key& key, const Entry& entry)
+{
+    const auto keyString = key.toString();
+
+    // Replace the existing entry
+    if (_lookup.contains(keyString)) {
+        const auto it = _lookup.take(keyString);
+
+        _numberOfBytes -= it->_entry.getNumberOfBytes();
+
+        _entries.erase(it);
+    }
+
+    if (entry.getNumberOfBytes() > _budget)
+        return;
+
+    _entries.push_front({ key, entry });
+    _lookup[keyString] = _entries.begin();
+
+    _numberOfBytes += entry.getNumberOfBytes();
+
+    evict();
+}
+
+void DimensionCache::evict()
+{
+    while (_numberOfBytes > _budget && !_entries.empty()) {
+        _numberOfBytes -= _entries.back()._entry.getNumberOfBytes();
+
+        _lookup.remove(_entries.back()._key.toString());
+        _entries.pop_back();
+    }
+}
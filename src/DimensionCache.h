@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+#include <cstdint>
+#include <list>
+
+/**
+ * Dimension cache class
+ *
+ * Least-recently-used cache of extracted dimension images (scalar data and scalar data range) under a byte budget
+ * Entries are keyed by images dataset, dimension index and subsample factor
+ */
+class DimensionCache
+{
+public:
+
+    /** Cache key */
+    struct Key {
+        QString         _datasetId;         /** Globally unique identifier of the images dataset */
+        std::int32_t    _dimensionIndex;    /** Dimension index */
+        std::int32_t    _subsampleFactor;   /** Subsample factor */
+
+        /** Get the key as string for hashing */
+        QString toString() const {
+            return QString("%1/%2/%3").arg(_datasetId, QString::number(_dimensionIndex), QString::number(_subsampleFactor));
+        }
+    };
+
+    /** Cached dimension image */
+    struct Entry {
+        QVector<float>          _scalarData;        /** Scalar data */
+        QPair<float, float>     _scalarDataRange;   /** Scalar data range */
+
+        /** Get the number of bytes occupied by the entry */
+        std::uint64_t getNumberOfBytes() const {
+            return static_cast<std::uint64_t>(_scalarData.size()) * sizeof(float);
+        }
+    };
+
+public: // Construction
+
+    /**
+     * Construct with \p budget
+     * @param budget Memory budget in bytes
+     */
+    explicit DimensionCache(std::uint64_t budget = 0);
+
+public: // Budget
+
+    /** Get the memory budget in bytes */
+    std::uint64_t getBudget() const { return _budget; }
+
+    /**
+     * Set the memory budget (evicts least recently used entries that no longer fit)
+     * @param budget Memory budget in bytes
+     */
+    void setBudget(std::uint64_t budget);
+
+    /** Get the number of bytes occupied by the cached entries */
+    std::uint64_t getNumberOfBytes() const { return _numberOfBytes; }
+
+    /** Get the number of cached entries */
+    std::int32_t getNumberOfEntries() const { return static_cast<std::int32_t>(_entries.size()); }
+
+public: // Entries
+
+    /** Remove all entries */
+    void clear();
+
+    /**
+     * Remove all entries of the images dataset with \p datasetId
+     * @param datasetId Globally unique identifier of the images dataset
+     */
+    void remove(const QString& datasetId);
+
+    /**
+     * Find the entry for \p key and mark it as most recently used
+     * @param key Cache key
+     * @param entry Entry that is assigned when found
+     * @return Whether the entry was found
+     */
+    bool find(const Key& key, Entry& entry);
+
+    /**
+     * Insert (or replace) the entry for \p key, entries that exceed the budget on their own are not cached
+     * @param key Cache key
+     * @param entry Entry
+     */
+    void insert(const Key& key, const Entry& entry);
+
+private:
+
+    /** Evict least recently used entries until the cache fits in the budget */
+    void evict();
+
+private:
+
+    /** Cached entry in the recency list */
+    struct Item {
+        Key     _key;       /** Cache key */
+        Entry   _entry;     /** Cached entry */
+    };
+
+    using Items = std::list<Item>;
+
+    std::uint64_t                       _budget;            /** Memory budget in bytes */
+    std::uint64_t                       _numberOfBytes;     /** Number of bytes occupied by the cached entries */
+    Items                               _entries;           /** Cached entries, most recently used first */
+    QHash<QString, Items::iterator>     _lookup;            /** Key to entry lookup */
+};
@@ -152,7 +152,7 @@ EditLayersAction::Widget::Widget(QWidget* parent, EditLayersAction* editLayersAc
         editLayersAction->getMoveLayerDownAction().setEnabled(!multiSelection && selectedRowIndex >= 0 ? selectedRowIndex < _hierarchyWidget.getModel().rowCount() - 1 : false);
         editLayersAction->getMoveLayerToBottomAction().setEnabled(!multiSelection && hasSelection && selectedRowIndex < _hierarchyWidget.getModel().rowCount() - 1);
 
-        imageViewerPlugin.getImageViewerWidget().update();
+        imageViewerPlugin.getImageViewerWidget().getRenderer().render();
     };
 
     connect(&imageViewerPlugin.getSelectionModel(), &QItemSelectionModel::selectionChanged, this, updateButtons);
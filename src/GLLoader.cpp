@@ -0,0 +1,110 @@
+#include "GLLoader.h"
+
+#include <QDebug>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QPointer>
+
+GLLoader::GLLoader(QObject* parent /*= nullptr*/) :
+    QObject(parent),
+    _thread(),
+    _surface(nullptr),
+    _context(nullptr),
+    _worker(nullptr)
+{
+    _thread.setObjectName("GLLoader");
+}
+
+GLLoader::~GLLoader()
+{
+    destroy();
+}
+
+void GLLoader::initialize(QOpenGLContext* shareContext)
+{
+    if (shareContext == nullptr)
+        return;
+
+    // Already sharing with this context (e.g. when the viewer re-initializes)
+    if (isInitialized() && _context->shareContext() == shareContext)
+        return;
+
+    destroy();
+
+    _surface = new QOffscreenSurface();
+
+    _surface->setFormat(shareContext->format());
+    _surface->create();
+
+    _context = new QOpenGLContext();
+
+    _context->setFormat(shareContext->format());
+    _context->setShareContext(shareContext);
+
+    if (!_context->create() || !_surface->isValid()) {
+        qWarning() << "Unable to create the OpenGL loader context, resources are loaded on the GUI thread";
+
+        destroy();
+        return;
+    }
+
+    _worker = new QObject();
+
+    _context->moveToThread(&_thread);
+    _worker->moveToThread(&_thread);
+
+    _thread.start(QThread::LowPriority);
+}
+
+void GLLoader::destroy()
+{
+    if (_thread.isRunning()) {
+        _thread.quit();
+        _thread.wait();
+    }
+
+    delete _worker;
+    delete _context;
+    delete _surface;
+
+    _worker     = nullptr;
+    _context    = nullptr;
+    _surface    = nullptr;
+}
+
+bool GLLoader::isInitialized() const
+{
+    return _worker != nullptr && _thread.isRunning();
+}
+
+bool GLLoader::enqueue(QObject* receiver, const Job& job, const Job& finished)
+{
+    if (!isInitialized())
+        return false;
+
+    QPointer<QObject> guardedReceiver(receiver);
+
+    QMetaObject::invokeMethod(_worker, [this, guardedReceiver, job, finished]() -> void {
+        if (_context->makeCurrent(_surface)) {
+            job();
+
+            // The objects have to be complete before the viewer context uses them
+            _context->functions()->glFinish();
+            _context->doneCurrent();
+        }
+        else {
+            qWarning() << "Unable to make the OpenGL loader context current, the job did not run";
+        }
+
+        // Hand over to the GUI thread, where the receiver can be checked safely
+        QMetaObject::invokeMethod(this, [guardedReceiver, finished]() -> void {
+            if (guardedReceiver.isNull())
+                return;
+
+            finished();
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+
+    return true;
+}
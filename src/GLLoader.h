@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QObject>
+#include <QThread>
+
+#include <functional>
+
+class QOpenGLContext;
+class QOffscreenSurface;
+
+/**
+ * OpenGL loader class
+ *
+ * Runs resource creation jobs (e.g. shader compilation) on a background thread with an OpenGL context that shares its objects with the viewer context
+ *
+ * Shared objects (shader programs, textures and buffers) that are created by a job can be used by the viewer once the job finished
+ * Container objects (vertex array and framebuffer objects) are not shared between contexts and have to be created by the viewer itself
+ */
+class GLLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    /** Loader job */
+    using Job = std::function<void()>;
+
+public: // Construction/destruction
+
+    /**
+     * Construct with \p parent object
+     * @param parent Pointer to parent object
+     */
+    explicit GLLoader(QObject* parent = nullptr);
+
+    /** Stops the loader thread */
+    ~GLLoader() override;
+
+public: // Thread management
+
+    /**
+     * Start the loader thread with a context that shares its objects with \p shareContext (call on the GUI thread once the share context is created)
+     * @param shareContext Pointer to the viewer context
+     */
+    void initialize(QOpenGLContext* shareContext);
+
+    /** Stop the loader thread and destroy its context, jobs that did not run yet are discarded */
+    void destroy();
+
+    /** Get whether the loader thread is running */
+    bool isInitialized() const;
+
+public: // Jobs
+
+    /**
+     * Run \p job on the loader thread with the shared context current and invoke \p finished on the GUI thread once the GPU completed the commands of the job
+     * \p finished is also invoked when the job could not run (the loader context could not be made current), but not when \p receiver was destroyed in the meantime
+     * @param receiver Pointer to receiver object (lives in the GUI thread)
+     * @param job Job to run on the loader thread
+     * @param finished Invoked on the GUI thread when the job finished
+     * @return Whether the job was queued (false when the loader is not initialized, the caller runs the job itself in that case)
+     */
+    bool enqueue(QObject* receiver, const Job& job, const Job& finished);
+
+private:
+    QThread                 _thread;        /** Loader thread */
+    QOffscreenSurface*      _surface;       /** Off-screen surface on which the loader context is made current (created on the GUI thread) */
+    QOpenGLContext*         _context;       /** Loader context, shares its objects with the viewer context (lives in the loader thread) */
+    QObject*                _worker;        /** Lives in the loader thread, jobs are invoked on it */
+};
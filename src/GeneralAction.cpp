@@ -52,7 +52,7 @@ void GeneralAction::initialize(Layer* layer)
     _nameAction.setString(_layer->getImagesDataset()->text());
 
     const auto render = [this]() {
-        _layer->getImageViewerPlugin().getImageViewerWidget().update();
+        _layer->invalidateOverlays();
     };
 
     render();
@@ -1,31 +1,92 @@
 #include "ImageProp.h"
 #include "QuadShape.h"
 #include "LayersRenderer.h"
+#include "ColorSpaceLookupTable.h"
+#include "LabelIndex.h"
 
 #include <util/FileUtil.h>
 #include <util/Interpolation.h>
 #include <util/Exception.h>
 
+#include <ClusterData/ClusterData.h>
+
 #include <QDebug>
 #include <QOpenGLContext>
 #include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include <QOpenGLPixelTransferOptions>
-
+#include <QOpenGLWidget>
+#include <QPolygonF>
+#include <QPointer>
+#include <QCoreApplication>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <stdexcept>
 
 ImageProp::ImageProp(Layer& layer, const QString& name) :
     Prop(layer, name),
     _layer(layer),
-    _displayRanges({ {0.0f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.0f} })
+    _displayRanges({ {0.0f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.0f} }),
+    _channelGenerations{ 0, 0, 0 },
+    _channelCompressions{ false, false, false },
+    _channelDenormalizations{ QVector2D(1.0f, 0.0f), QVector2D(1.0f, 0.0f), QVector2D(1.0f, 0.0f) },
+    _channelPresentations{ false, false, false },
+    _tiled(false),
+    _imageSize(),
+    _selectionReduction(1),
+    _pyramids(),
+    _pyramidGenerations{ 0, 0, 0, 0 },
+    _tileCache(),
+    _tileData(),
+    _streaming(false),
+    _pixelUnpackBuffers{},
+    _uploadFences{},
+    _uploadIndex(-1),
+    _channelSlots{ -1, -1, -1 },
+    _residentDimensions(),
+    _residentDenormalizations(),
+    _residentRanges(),
+    _channelLayers{ -1, -1, -1 },
+    _uploadThreadPool(),
+    _uploadRequests{ 0, 0, 0, 0 },
+    _pendingUploads(),
+    _retiredUploads(),
+    _vertexShaderSource(),
+    _fragmentShaderSource(),
+    _masked(false),
+    _colorSpaceLookupType(-1),
+    _colorMapSlice(),
+    _colorMapInterpolationType(InterpolationType::Bilinear),
+    _labels(),
+    _labelProperties(),
+    _selectedLabels(),
+    _selectedLabelsOnly(false),
+    _labelPropertiesBuffer(0),
+    _labelPropertiesTexture(0),
+    _numberOfLabels(0)
 {
-    // Add quad shape and shader program
+    // Add quad shape (shader program variants are added on demand)
     addShape<QuadShape>("Quad");
-    addShaderProgram("Quad");
 
-    // Add color map and channels texture
-    addTexture("ColorMap", QOpenGLTexture::Target2D);
-    addTexture("Channels", QOpenGLTexture::Target2DArray);
+    // Add color map and channel textures
+    addTexture("Channel1", QOpenGLTexture::Target2D);
+    addTexture("Channel2", QOpenGLTexture::Target2D);
+    addTexture("Channel3", QOpenGLTexture::Target2D);
     addTexture("Mask", QOpenGLTexture::Target2DArray);
+    addTexture("Tiles", QOpenGLTexture::Target2DArray);
+    addTexture("Dimensions", QOpenGLTexture::Target2DArray);
+    addTexture("Selection", QOpenGLTexture::Target2D);
+    addTexture("ColorSpaceLookup", QOpenGLTexture::Target3D);
+    addTexture("Labels", QOpenGLTexture::Target2D);
+
+    // Add channel texture slots for streamed uploads
+    for (std::int32_t channelIndex = 0; channelIndex < 3; channelIndex++)
+        for (std::int32_t slot = 0; slot < numberOfStreamingSlots; slot++)
+            addTexture(QString("Channel%1Slot%2").arg(QString::number(channelIndex + 1), QString::number(slot)), QOpenGLTexture::Target2D);
 
     // Initialize the prop
     initialize();
@@ -37,34 +98,29 @@ void ImageProp::initialize()
     {
         Prop::initialize();
 
-        getRenderer().bindOpenGLContext();
-        {
-            const auto shaderProgram = getShaderProgramByName("Quad");
-
-            // Load vertex/fragment shaders from resources
-            const auto vertexShader     = loadFileContents(":Shaders/ImageVertex.glsl");
-            const auto fragmentShader   = loadFileContents(":Shaders/ImageFragment.glsl");
+        // Load vertex/fragment shaders from resources
+        _vertexShaderSource     = loadFileContents(":Shaders/ImageVertex.glsl");
+        _fragmentShaderSource   = loadFileContents(":Shaders/ImageFragment.glsl");
 
-            // Assign vertex shader to shader program
-            if (!shaderProgram->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader))
-                throw std::runtime_error("Unable to compile quad vertex shader");
+        // Variants share the vertex layout, so the variant for the initial settings is used to configure the quad vertex array
+        const auto defines      = getShaderDefines();
+        const auto variantName  = getShaderProgramVariantName("Quad", defines);
 
-            // Assign fragment shader to shader program
-            if (!shaderProgram->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader))
-                throw std::runtime_error("Unable to compile quad fragment shader");
-
-            // Link the shader program
-            if (!shaderProgram->link())
-                throw std::runtime_error("Unable to link quad shader program");
+        // Compile and link in the background (unless another layer uses the variant already), the layer is drawn as a placeholder in the meantime
+        loadShaderProgram(variantName, _vertexShaderSource, _fragmentShaderSource, [this, variantName]() -> void {
+            const auto shaderProgram = getShaderProgramByName(variantName);
 
+            // Number of bytes per stride
             const auto stride = 5 * sizeof(GLfloat);
 
+            // Get quad shape
             auto shape = getShapeByName<QuadShape>("Quad");
 
             // Bind shader program
             if (!shaderProgram->bind())
                 throw std::runtime_error("Unable to bind quad shader program");
-            
+
+            // Vertex array objects are not shared between contexts, so they are configured in the viewer context
             shape->getVAO().bind();
             {
                 shape->getVBO().bind();
@@ -81,8 +137,7 @@ void ImageProp::initialize()
             shape->getVBO().release();
 
             _initialized = true;
-        }
-        getRenderer().releaseOpenGLContext();
+        }, defines);
     }
     catch (std::exception& e)
     {
@@ -93,49 +148,169 @@ void ImageProp::initialize()
     }
 }
 
+void ImageProp::destroy()
+{
+    Prop::destroy();
+
+    auto functions = getRenderer().getOpenGLContext()->extraFunctions();
+
+    for (auto& uploadFence : _uploadFences) {
+        if (uploadFence != nullptr)
+            functions->glDeleteSync(uploadFence);
+
+        uploadFence = nullptr;
+    }
+
+    if (_pixelUnpackBuffers[0] != 0)
+        functions->glDeleteBuffers(static_cast<GLsizei>(_pixelUnpackBuffers.size()), _pixelUnpackBuffers.data());
+
+    _pixelUnpackBuffers.fill(0);
+
+    // Workers might still be writing into mapped pixel unpack buffers
+    _uploadThreadPool.waitForDone();
+
+    for (auto& pendingUpload : _pendingUploads) {
+        functions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pendingUpload._pixelUnpackBuffer);
+        functions->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        functions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        functions->glDeleteBuffers(1, &pendingUpload._pixelUnpackBuffer);
+    }
+
+    for (auto& retiredUpload : _retiredUploads) {
+        functions->glDeleteSync(retiredUpload.second);
+        functions->glDeleteBuffers(1, &retiredUpload.first);
+    }
+
+    _pendingUploads.clear();
+    _retiredUploads.clear();
+
+    if (_labelPropertiesTexture != 0)
+        functions->glDeleteTextures(1, &_labelPropertiesTexture);
+
+    if (_labelPropertiesBuffer != 0)
+        functions->glDeleteBuffers(1, &_labelPropertiesBuffer);
+
+    _labelPropertiesTexture = 0;
+    _labelPropertiesBuffer  = 0;
+    _numberOfLabels         = 0;
+}
+
 void ImageProp::render(const QMatrix4x4& modelViewProjectionMatrix)
 {
     try {
 
+        // Issue the texture updates that were staged since the previous frame
+        finishUploads();
+
         if (!canRender())
             return;
+
+        const auto labelMap = isLabelMap();
+
+        // The first channel of a label map is uploaded as labels, together with the label properties
+        const auto firstChannelUploaded = labelMap ? getTextureByName("Labels")->isCreated() && _labelPropertiesTexture != 0 : getTextureByName(getChannelTextureName(0))->isCreated() || _channelLayers[0] >= 0;
+
+        // Nothing to render until the first channel and the mask are uploaded (their uploads might still be staged)
+        if (!_tiled && (!firstChannelUploaded || !getTextureByName("Mask")->isCreated()))
+            return;
         
         const auto shape            = getShapeByName<QuadShape>("Quad");
-        const auto shaderProgram    = getShaderProgramByName("Quad");
+        const auto shaderDefines    = getShaderDefines();
+        const auto shaderProgram    = getShaderProgramVariant("Quad", shaderDefines, _vertexShaderSource, _fragmentShaderSource);
+
+        // The variant for the current settings is still being compiled by another layer (or failed to link)
+        if (shaderProgram.isNull())
+            return;
+
+        auto& colorMapAtlas = getRenderer().getColorMapAtlas();
 
-        // Activate and bind color map texture
-        if (getTextureByName("ColorMap")->isCreated()) {
+        // Activate and bind color map atlas texture (label maps are colored per label instead)
+        if (!labelMap) {
             getRenderer().getOpenGLContext()->functions()->glActiveTexture(GL_TEXTURE0);
-            getTextureByName("ColorMap")->bind();
-        }
-        else {
-            throw std::runtime_error("Color map texture is not created.");
+
+            if (!_colorMapSlice || !colorMapAtlas.bind())
+                throw std::runtime_error("Color map texture is not created.");
         }
 
-        // Activate and bind channels texture
-        if (getTextureByName("Channels")->isCreated()) {
-            getRenderer().getOpenGLContext()->functions()->glActiveTexture(GL_TEXTURE1);
-            getTextureByName("Channels")->bind();
+        if (_tiled) {
+
+            // Activate and bind tiles texture
+            if (getTextureByName("Tiles")->isCreated()) {
+                getRenderer().getOpenGLContext()->functions()->glActiveTexture(GL_TEXTURE5);
+                getTextureByName("Tiles")->bind();
+            }
+            else {
+                throw std::runtime_error("Tiles texture is not created.");
+            }
         }
         else {
-            throw std::runtime_error("Channels texture is not created.");
+
+            // Activate and bind channel textures (the first channel is always present, unless it samples the resident dimensions or the labels)
+            if (!firstChannelUploaded)
+                throw std::runtime_error("Channel 1 texture is not created.");
+
+            // Activate and bind labels texture and label properties buffer texture
+            if (labelMap) {
+                getRenderer().getOpenGLContext()->functions()->glActiveTexture(GL_TEXTURE9);
+                getTextureByName("Labels")->bind();
+
+                getRenderer().getOpenGLContext()->functions()->glActiveTexture(GL_TEXTURE10);
+                getRenderer().getOpenGLContext()->functions()->glBindTexture(GL_TEXTURE_BUFFER, _labelPropertiesTexture);
+            }
+
+            for (std::uint32_t channelIndex = 0; channelIndex < 3; channelIndex++) {
+                auto& texture = getTextureByName(getChannelTextureName(channelIndex));
+
+                if (!texture->isCreated())
+                    continue;
+
+                getRenderer().getOpenGLContext()->functions()->glActiveTexture(GL_TEXTURE1 + channelIndex);
+                texture->bind();
+            }
+
+            // Activate and bind resident dimensions texture
+            if (getTextureByName("Dimensions")->isCreated()) {
+                getRenderer().getOpenGLContext()->functions()->glActiveTexture(GL_TEXTURE6);
+                getTextureByName("Dimensions")->bind();
+            }
+
+            // Activate and bind mask texture
+            if (getTextureByName("Mask")->isCreated()) {
+                getRenderer().getOpenGLContext()->functions()->glActiveTexture(GL_TEXTURE4);
+                getTextureByName("Mask")->bind();
+            }
+            else {
+                throw std::runtime_error("Mask texture is not created.");
+            }
         }
 
-        // Activate and bind mask texture
-        if (getTextureByName("Mask")->isCreated()) {
-            getRenderer().getOpenGLContext()->functions()->glActiveTexture(GL_TEXTURE2);
-            getTextureByName("Mask")->bind();
+        auto& pixelSelectionAction = _layer.getSelectionAction().getPixelSelectionAction();
+
+        // The selection overlay is not shown in ROI selection mode (label maps read the selection from the label properties)
+        const auto showSelection = (labelMap || getTextureByName("Selection")->isCreated()) && pixelSelectionAction.getTypeAction().getCurrentIndex() != static_cast<std::int32_t>(PixelSelectionType::ROI);
+
+        // Activate and bind selection texture
+        if (showSelection && !labelMap) {
+            getRenderer().getOpenGLContext()->functions()->glActiveTexture(GL_TEXTURE7);
+            getTextureByName("Selection")->bind();
         }
-        else {
-            throw std::runtime_error("Mask texture is not created.");
+
+        auto& imageAction = _layer.getImageSettingsAction();
+
+        // Activate and bind color space lookup texture (replaces the per-fragment HSL/LAB conversion)
+        const auto useColorSpaceLookup = shaderDefines.contains("COLOR_SPACE_LOOKUP");
+
+        if (useColorSpaceLookup) {
+            updateColorSpaceLookupTexture(static_cast<ColorSpaceType>(imageAction.getColorSpaceAction().getCurrentIndex()));
+
+            getRenderer().getOpenGLContext()->functions()->glActiveTexture(GL_TEXTURE8);
+            getTextureByName("ColorSpaceLookup")->bind();
         }
 
         // Bind shader program
         if (!shaderProgram->bind())
             throw std::runtime_error("Unable to bind quad shader program");
 
-        auto& imageAction = _layer.getImageSettingsAction();
-
         // Convert display ranges
         const QVector2D displayRanges[3] = {
             QVector2D(_displayRanges[0].first, _displayRanges[0].second),
@@ -143,29 +318,102 @@ void ImageProp::render(const QMatrix4x4& modelViewProjectionMatrix)
             QVector2D(_displayRanges[2].first, _displayRanges[2].second)
         };
 
+        // Channels that sample the resident dimensions use the denormalization of their dimension
+        QVector2D channelDenormalizations[3];
+        GLfloat channelLayers[3];
+
+        for (std::int32_t channelIndex = 0; channelIndex < 3; channelIndex++) {
+            const auto channelLayer = _tiled ? -1 : _channelLayers[channelIndex];
+
+            channelDenormalizations[channelIndex]   = channelLayer >= 0 ? _residentDenormalizations[channelLayer] : _channelDenormalizations[channelIndex];
+            channelLayers[channelIndex]             = static_cast<GLfloat>(channelLayer);
+        }
+
         // Configure shader program
         shaderProgram->setUniformValue("textureSize", shape->getImageSize());
         shaderProgram->setUniformValue("colorMapTexture", 0);
-        shaderProgram->setUniformValue("channelTextures", 1);
-        shaderProgram->setUniformValue("maskTexture", 2);
-        shaderProgram->setUniformValue("noChannels", imageAction.getNumberOfActiveScalarChannels());
-        shaderProgram->setUniformValue("useConstantColor", imageAction.getUseConstantColorAction().isChecked());
+        shaderProgram->setUniformValue("labelTexture", 9);
+        shaderProgram->setUniformValue("labelPropertiesTexture", 10);
+        shaderProgram->setUniformValue("numberOfLabels", _numberOfLabels);
+
+        if (_colorMapSlice) {
+            shaderProgram->setUniformValue("colorMapLayer", static_cast<GLfloat>(_colorMapSlice->_layer));
+            shaderProgram->setUniformValue("colorMapSize", QVector2D(_colorMapSlice->_size.width(), _colorMapSlice->_size.height()));
+            shaderProgram->setUniformValue("colorMapAtlasSize", QVector2D(colorMapAtlas.getSliceSize().width(), colorMapAtlas.getSliceSize().height()));
+            shaderProgram->setUniformValue("colorMapNearest", _colorMapInterpolationType == InterpolationType::NearestNeighbor);
+        }
+
+        shaderProgram->setUniformValue("channel1Texture", 1);
+        shaderProgram->setUniformValue("channel2Texture", 2);
+        shaderProgram->setUniformValue("channel3Texture", 3);
+        shaderProgram->setUniformValue("maskTexture", 4);
+        shaderProgram->setUniformValue("tileTextures", 5);
+        shaderProgram->setUniformValue("dimensionsTexture", 6);
+        shaderProgram->setUniformValue("selectionTexture", 7);
+        shaderProgram->setUniformValue("colorSpaceLookupTexture", 8);
+        shaderProgram->setUniformValueArray("channelDenormalizations", channelDenormalizations, 3);
+        shaderProgram->setUniformValueArray("channelLayers", channelLayers, 3, 1);
+        shaderProgram->setUniformValue("tiled", _tiled);
         shaderProgram->setUniformValue("constantColor", imageAction.getConstantColorAction().getColor());
-        shaderProgram->setUniformValue("colorSpace", imageAction.getColorSpaceAction().getCurrentIndex());
         shaderProgram->setUniformValueArray("displayRanges", displayRanges, 3);
         shaderProgram->setUniformValue("opacity", 0.01f * imageAction.getOpacityAction().getValue());
+        shaderProgram->setUniformValue("showSelection", showSelection);
+        shaderProgram->setUniformValue("overlayColor", pixelSelectionAction.getOverlayColorAction().getColor());
+        shaderProgram->setUniformValue("overlayOpacity", 0.01f * pixelSelectionAction.getOverlayOpacityAction().getValue());
         shaderProgram->setUniformValue("transform", modelViewProjectionMatrix * _renderable.getModelMatrix() * getModelMatrix());
 
-        // Render the quad
-        shape->render();
+        // Render the quad (or the visible tiles when streaming)
+        if (_tiled)
+            renderTiles(*shaderProgram, modelViewProjectionMatrix * _renderable.getModelMatrix() * getModelMatrix());
+        else
+            shape->render();
 
         // Release the shader program
         shaderProgram->release();
 
         // Release textures
-        getTextureByName("Channels")->release();
-        getTextureByName("ColorMap")->release();
-        getTextureByName("Mask")->release();
+        if (_tiled) {
+            getTextureByName("Tiles")->release();
+        }
+        else {
+            for (std::uint32_t channelIndex = 0; channelIndex < 3; channelIndex++) {
+                auto& texture = getTextureByName(getChannelTextureName(channelIndex));
+
+                if (texture->isCreated())
+                    texture->release();
+            }
+
+            if (getTextureByName("Dimensions")->isCreated())
+                getTextureByName("Dimensions")->release();
+
+            if (labelMap) {
+                getTextureByName("Labels")->release();
+
+                getRenderer().getOpenGLContext()->functions()->glActiveTexture(GL_TEXTURE10);
+                getRenderer().getOpenGLContext()->functions()->glBindTexture(GL_TEXTURE_BUFFER, 0);
+            }
+
+            getTextureByName("Mask")->release();
+        }
+
+        if (showSelection && !labelMap)
+            getTextureByName("Selection")->release();
+
+        if (useColorSpaceLookup)
+            getTextureByName("ColorSpaceLookup")->release();
+
+        if (!labelMap)
+            colorMapAtlas.release();
+
+        // Report the channel frames that were painted for the first time
+        for (std::uint32_t channelIndex = 0; channelIndex < 3; channelIndex++) {
+            if (!_channelPresentations[channelIndex])
+                continue;
+
+            _channelPresentations[channelIndex] = false;
+
+            emit _layer.channelFramePresented(channelIndex);
+        }
     }
     catch (std::exception& e)
     {
@@ -205,7 +453,9 @@ QRectF ImageProp::getWorldBoundingRectangle() const
 void ImageProp::setGeometry(const QRectF& imageRectangle)
 {
     try {
+#if _DEBUG
         qDebug() << "Set image prop geometry:" << imageRectangle;
+#endif
 
         // Assign the rectangle to the quad shape
         getShapeByName<QuadShape>("Quad")->setRectangle(imageRectangle);
@@ -221,6 +471,62 @@ void ImageProp::setGeometry(const QRectF& imageRectangle)
 
         // Assign model matrix
         setModelMatrix(modelMatrix);
+
+        _imageSize = imageRectangle.size().toSize();
+
+        getRenderer().bindOpenGLContext();
+        {
+            auto functions = getRenderer().getOpenGLContext()->functions();
+
+            GLint maximumTextureSize = 0, maximumArrayTextureLayers = 0;
+
+            functions->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maximumTextureSize);
+            functions->glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maximumArrayTextureLayers);
+
+            // Stream the image in tiles when it does not fit in a single texture or when three full resolution channels exceed the memory budget
+            const auto numberOfChannelBytes = 3ull * sizeof(float) * static_cast<std::uint64_t>(_imageSize.width()) * static_cast<std::uint64_t>(_imageSize.height());
+
+            _tiled = _imageSize.width() > maximumTextureSize || _imageSize.height() > maximumTextureSize || numberOfChannelBytes > tileCacheBudget;
+
+            // The selection overlay of a streamed image is reduced by an integer factor until it fits in a texture and in the overlay budget
+            _selectionReduction = 1;
+
+            if (_tiled) {
+                const auto getReducedSize = [this](std::int32_t reduction) -> QSize {
+                    return { (_imageSize.width() + reduction - 1) / reduction, (_imageSize.height() + reduction - 1) / reduction };
+                };
+
+                while (getReducedSize(_selectionReduction).width() > maximumTextureSize || getReducedSize(_selectionReduction).height() > maximumTextureSize || static_cast<std::uint64_t>(getReducedSize(_selectionReduction).width()) * getReducedSize(_selectionReduction).height() > selectionOverlayBudget)
+                    _selectionReduction++;
+            }
+
+            if (_tiled) {
+
+                // Each slot holds one tile with the three channels and the mask interleaved
+                const auto numberOfSlotBytes    = static_cast<std::uint64_t>(ImagePyramid::tileTexels) * ImagePyramid::tileTexels * numberOfPyramids * sizeof(float);
+                const auto numberOfSlots        = static_cast<std::int32_t>(std::min<std::uint64_t>(tileCacheBudget / numberOfSlotBytes, static_cast<std::uint64_t>(maximumArrayTextureLayers)));
+
+                auto& texture = getTextureByName("Tiles");
+
+                if (texture->isCreated())
+                    texture->destroy();
+
+                texture->create();
+                texture->setLayers(numberOfSlots);
+                texture->setSize(ImagePyramid::tileTexels, ImagePyramid::tileTexels);
+                texture->setFormat(QOpenGLTexture::RGBA32F);
+                texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::Float32);
+                texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+
+                _tileCache.setNumberOfSlots(numberOfSlots);
+                _tileData.resize(static_cast<std::size_t>(ImagePyramid::tileTexels) * ImagePyramid::tileTexels * numberOfPyramids);
+
+#if _DEBUG
+                qDebug() << "Image prop streams" << _imageSize << "image in tiles with" << numberOfSlots << "cache slots";
+#endif
+            }
+        }
+        getRenderer().releaseOpenGLContext();
     }
     catch (std::exception& e)
     {
@@ -240,18 +546,8 @@ void ImageProp::setColorMapImage(const QImage& colorMapImage)
             if (colorMapImage.isNull())
                 return;
 
-            // Get color map texture
-            auto& texture = getTextureByName("ColorMap");
-
-            // Reset and assign the texture
-            texture.reset(new QOpenGLTexture(colorMapImage.mirrored()));
-
-            // Create the texture if not created
-            if (!texture->isCreated())
-                texture->create();
-
-            // Set appropriate wrapping
-            texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+            // Only the slice of this layer is updated (or a slice with the same color map is shared)
+            _colorMapSlice = getRenderer().getColorMapAtlas().update(_colorMapSlice, colorMapImage);
         }
         getRenderer().releaseOpenGLContext();
     }
@@ -264,7 +560,7 @@ void ImageProp::setColorMapImage(const QImage& colorMapImage)
     }
 }
 
-void ImageProp::setChannelScalarData(const std::uint32_t& channelIndex, const QVector<float>& scalarData, const DisplayRange& displayRange)
+void ImageProp::setChannelScalarData(const std::uint32_t& channelIndex, const QVector<float>& scalarData, const std::uint64_t& generation, const DisplayRange& displayRange)
 {
     try {
         if (channelIndex >= 3)
@@ -282,32 +578,144 @@ void ImageProp::setChannelScalarData(const std::uint32_t& channelIndex, const QV
             // Assign display range
             _displayRanges[channelIndex] = displayRange;
 
-            // Get channels texture
-            auto texture = getTextureByName("Channels");
+            const auto compress = _layer.getImageSettingsAction().getCompressChannelsAction().isChecked();
+
+            // Cluster indices are uploaded as integer labels
+            if (channelIndex == 0 && isLabelMap()) {
+                if (generation == 0 || generation != _channelGenerations[channelIndex])
+                    setLabels(scalarData, imageSize.toSize());
+
+                _channelGenerations[channelIndex]   = generation;
+                _channelPresentations[channelIndex] = true;
+                return;
+            }
+
+            // The channel samples the resident dimensions texture array, so there is nothing to upload
+            if (!_tiled && _channelLayers[channelIndex] >= 0)
+                return;
+
+            // The scalar data did not change since the last upload
+            if (generation != 0 && generation == _channelGenerations[channelIndex] && (_tiled || compress == _channelCompressions[channelIndex]))
+                return;
+
+            // The same scalar data is already being staged (the generation is only recorded once the texture is updated)
+            const auto staged = std::any_of(_pendingUploads.begin(), _pendingUploads.end(), [this, channelIndex, generation, compress](const PendingUpload& pendingUpload) -> bool {
+                return pendingUpload._target == static_cast<std::int32_t>(channelIndex) && pendingUpload._request == _uploadRequests[channelIndex] && pendingUpload._generation == generation && pendingUpload._compression == compress;
+            });
+
+            if (generation != 0 && staged)
+                return;
+
+            // Build the channel pyramid when streaming in tiles
+            if (_tiled) {
+                _channelGenerations[channelIndex] = generation;
+
+                buildPyramid(static_cast<std::int32_t>(channelIndex), scalarData);
+                return;
+            }
+
+            const auto numberOfBytes = static_cast<std::uint64_t>(scalarData.size()) * sizeof(float);
+
+            // Stream into the next texture slot during playback, the frame is dropped (before any packing) when the upload ring is full
+            if (_streaming) {
+                const auto streamingBuffer = acquireStreamingBuffer();
+
+                if (streamingBuffer < 0) {
+                    emit _layer.channelFrameDropped(channelIndex);
+                    return;
+                }
+
+                // Supersede uploads to this channel that are still staged
+                const auto uploadRequest = ++_uploadRequests[channelIndex];
+
+                if (auto mappedData = stageUpload(static_cast<std::int32_t>(channelIndex), uploadRequest, imageSize.toSize(), numberOfBytes, generation, compress, streamingBuffer))
+                    packChannelUpload(channelIndex, uploadRequest, scalarData, imageSize.toSize(), compress, mappedData);
+                else
+                    emit _layer.channelFrameDropped(channelIndex);
+
+                return;
+            }
+
+            // Supersede uploads to this channel that are still staged
+            const auto uploadRequest = ++_uploadRequests[channelIndex];
+
+            // Pack large channels into a pixel unpack buffer on a worker thread, the texture is updated at the next frame
+            if (numberOfBytes >= asynchronousUploadThreshold) {
+                if (auto mappedData = stageUpload(static_cast<std::int32_t>(channelIndex), uploadRequest, imageSize.toSize(), numberOfBytes, generation, compress)) {
+                    packChannelUpload(channelIndex, uploadRequest, scalarData, imageSize.toSize(), compress, mappedData);
+                    return;
+                }
+            }
+
+            // Pick the most compact storage format for the scalar data
+            const ChannelStorage channelStorage(scalarData, imageSize.toSize(), compress);
+
+            // Display the base channel texture again
+            _channelSlots[channelIndex] = -1;
+
+            const auto textureFormat = getTextureFormat(channelStorage.getFormat());
+
+            // Get channel texture
+            auto texture = getTextureByName(QString("Channel%1").arg(channelIndex + 1));
 
             // Create the texture if not created
             if (!texture->isCreated())
                 texture->create();
 
-            // Re-configure when the image size has changed
-            if (imageSize != QSize(texture->width(), texture->height())) {
+            // Re-configure when the image size or the storage format has changed
+            if (imageSize != QSize(texture->width(), texture->height()) || texture->format() != textureFormat) {
                 texture->destroy();
                 texture->create();
-                texture->setLayers(3);
-                texture->setSize(imageSize.width(), imageSize.height(), 1);
-                texture->setSize(imageSize.width(), imageSize.height(), 2);
-                texture->setSize(imageSize.width(), imageSize.height(), 3);
-                texture->setSize(imageSize.width(), imageSize.height(), 4);
-                texture->setFormat(QOpenGLTexture::R32F);
-                texture->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::Float32);
+                texture->setSize(imageSize.width(), imageSize.height());
+                texture->setFormat(textureFormat);
+                texture->allocateStorage();
                 texture->setWrapMode(QOpenGLTexture::ClampToBorder);
             }
 
             // Set the interpolation type
             setInterpolationType(static_cast<InterpolationType>(_layer.getImageSettingsAction().getInterpolationTypeAction().getCurrentIndex()));
 
-            // Assign the scalar data to the texture 
-            texture->setData(0, channelIndex, QOpenGLTexture::PixelFormat::Red, QOpenGLTexture::PixelType::Float32, scalarData.data());
+            QOpenGLPixelTransferOptions options;
+
+            // Rows of eight and sixteen bit texels are not necessarily four byte aligned
+            options.setAlignment(1);
+
+            // Assign the (packed) scalar data to the texture
+            switch (channelStorage.getFormat())
+            {
+                case ChannelStorage::Format::Float32:
+                    texture->setData(QOpenGLTexture::PixelFormat::Red, QOpenGLTexture::PixelType::Float32, scalarData.data(), &options);
+                    break;
+
+                case ChannelStorage::Format::Float16:
+                    texture->setData(QOpenGLTexture::PixelFormat::Red, QOpenGLTexture::PixelType::Float16, channelStorage.getData().constData(), &options);
+                    break;
+
+                case ChannelStorage::Format::UInt16:
+                    texture->setData(QOpenGLTexture::PixelFormat::Red, QOpenGLTexture::PixelType::UInt16, channelStorage.getData().constData(), &options);
+                    break;
+
+                case ChannelStorage::Format::UInt8:
+                    texture->setData(QOpenGLTexture::PixelFormat::Red, QOpenGLTexture::PixelType::UInt8, channelStorage.getData().constData(), &options);
+                    break;
+
+                case ChannelStorage::Format::BC4:
+                    texture->setCompressedData(static_cast<int>(channelStorage.getData().size()), channelStorage.getData().constData(), &options);
+                    break;
+
+                default:
+                    break;
+            }
+
+            _channelDenormalizations[channelIndex]  = QVector2D(channelStorage.getScale(), channelStorage.getOffset());
+            _channelCompressions[channelIndex]      = compress;
+
+#if _DEBUG
+            qDebug() << "Channel" << channelIndex + 1 << "stored as" << ChannelStorage::getFormatName(channelStorage.getFormat()) << "(" << channelStorage.getBytesPerTexel() << "bytes per texel)";
+#endif
+
+            _channelGenerations[channelIndex]   = generation;
+            _channelPresentations[channelIndex] = true;
         }
         getRenderer().releaseOpenGLContext();
     }
@@ -320,6 +728,14 @@ void ImageProp::setChannelScalarData(const std::uint32_t& channelIndex, const QV
     }
 }
 
+void ImageProp::setChannelDisplayRange(const std::uint32_t& channelIndex, const DisplayRange& displayRange)
+{
+    if (channelIndex >= 3)
+        return;
+
+    _displayRanges[channelIndex] = displayRange;
+}
+
 void ImageProp::setMaskData(const std::vector<std::uint8_t>& maskData)
 {
     try {
@@ -332,6 +748,40 @@ void ImageProp::setMaskData(const std::vector<std::uint8_t>& maskData)
             if (!imageSize.isValid())
                 return;
 
+            // Unmasked images use shader program variants that do not sample the mask
+            _masked = std::any_of(maskData.begin(), maskData.end(), [](std::uint8_t maskValue) -> bool {
+                return maskValue == 0;
+            });
+
+            // Build the mask pyramid when streaming in tiles
+            if (_tiled) {
+                buildPyramid(3, QVector<float>(maskData.begin(), maskData.end()));
+                return;
+            }
+
+            // Supersede a mask upload that is still staged
+            const auto uploadRequest = ++_uploadRequests[3];
+
+            // Copy large masks into a pixel unpack buffer on a worker thread, the texture is updated at the next frame
+            if (maskData.size() >= asynchronousUploadThreshold) {
+                if (auto mappedData = stageUpload(3, uploadRequest, imageSize.toSize(), maskData.size())) {
+                    QPointer<Layer> guardedLayer(&_layer);
+
+                    _uploadThreadPool.start([this, guardedLayer, uploadRequest, maskData, mappedData]() -> void {
+                        std::memcpy(mappedData, maskData.data(), maskData.size());
+
+                        QMetaObject::invokeMethod(QCoreApplication::instance(), [this, guardedLayer, uploadRequest, numberOfBytes = static_cast<std::uint64_t>(maskData.size())]() -> void {
+                            if (guardedLayer.isNull())
+                                return;
+
+                            markUploadReady(3, uploadRequest, ChannelStorage::Format::UInt8, QVector2D(1.0f, 0.0f), numberOfBytes);
+                        }, Qt::QueuedConnection);
+                    });
+
+                    return;
+                }
+            }
+
             // Get channels texture
             auto texture = getTextureByName("Mask");
 
@@ -365,62 +815,168 @@ void ImageProp::setMaskData(const std::vector<std::uint8_t>& maskData)
     }
 }
 
-void ImageProp::setInterpolationType(const InterpolationType& interpolationType)
+QStringList ImageProp::getShaderDefines() const
 {
-    try {
+    auto& imageAction = _layer.getImageSettingsAction();
+
+    QStringList defines;
+
+    // Label maps are colored per label
+    if (isLabelMap()) {
+        defines << "LABEL_MAP";
+    }
+    // The constant color variant only uses the first channel
+    else if (imageAction.getUseConstantColorAction().isChecked()) {
+        defines << "CONSTANT_COLOR";
+    }
+    else {
+        const auto numberOfChannels = std::clamp(static_cast<std::int32_t>(imageAction.getNumberOfActiveScalarChannels()), 1, 3);
+
+        defines << QString("NUMBER_OF_CHANNELS %1").arg(QString::number(numberOfChannels));
+
+        if (numberOfChannels == 3) {
+            const auto colorSpaceType = static_cast<ColorSpaceType>(imageAction.getColorSpaceAction().getCurrentIndex());
+
+            defines << QString("COLOR_SPACE %1").arg(QString::number(static_cast<std::int32_t>(colorSpaceType)));
+
+            // RGB needs no conversion, so only HSL and LAB benefit from the lookup table
+            if ((colorSpaceType == ColorSpaceType::HSL || colorSpaceType == ColorSpaceType::LAB) && imageAction.getColorConversionAction().getCurrentIndex() == 1) {
+                defines << "COLOR_SPACE_LOOKUP";
+
+                // The built-in textureSize() is hidden by the textureSize uniform, so the lattice size is passed as a constant
+                defines << QString("COLOR_SPACE_LOOKUP_SIZE %1").arg(QString::number(ColorSpaceLookupTable::size));
+            }
+        }
+    }
 
-        // Get channels texture
-        auto texture = getTextureByName("Channels");
+    if (_masked)
+        defines << "MASKED";
 
-        // Except when texture is not created
-        if (!texture->isCreated())
-            throw std::runtime_error("Channels texture is not created.");
+    return defines;
+}
 
-        // Configure interpolation
-        switch (interpolationType)
+void ImageProp::setSelectionData(const std::vector<std::uint8_t>& selectionData, const QRect& region)
+{
+    try {
+        getRenderer().bindOpenGLContext();
         {
-            case InterpolationType::Bilinear :
-                texture->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
-                break;
+            // Get image size from quad shape
+            const auto imageSize = getShapeByName<QuadShape>("Quad")->getImageSize();
+
+            // Only proceed if the image size is valid (non-zero in x/y)
+            if (!imageSize.isValid() || selectionData.size() < static_cast<std::size_t>(imageSize.width()) * imageSize.height())
+                return;
+
+            auto texture = getTextureByName("Selection");
+
+            const auto imageRectangle = QRect(QPoint(0, 0), imageSize);
+
+            // Streamed images might exceed the maximum texture size, a texel of their overlay is selected when any of its pixels is
+            const auto reduction    = _selectionReduction;
+            const auto overlaySize  = QSize((imageSize.width() + reduction - 1) / reduction, (imageSize.height() + reduction - 1) / reduction);
 
-            case InterpolationType::NearestNeighbor :
+            // Re-configure when the overlay size has changed
+            const auto reconfigure = !texture->isCreated() || overlaySize != QSize(texture->width(), texture->height());
+
+            if (reconfigure) {
+                texture->destroy();
+                texture->create();
+                texture->setSize(overlaySize.width(), overlaySize.height());
+                texture->setFormat(QOpenGLTexture::R8_UNorm);
+                texture->setWrapMode(QOpenGLTexture::ClampToEdge);
                 texture->setMinMagFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
-                break;
+                texture->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::UInt8);
+            }
 
-            default:
-                break;
+            // Only the changed region is uploaded (a newly allocated texture is filled completely)
+            const auto uploadRectangle = reconfigure ? imageRectangle : region.intersected(imageRectangle);
+
+            if (!uploadRectangle.isEmpty() && reduction == 1) {
+                QOpenGLPixelTransferOptions options;
+
+                options.setAlignment(1);
+                options.setRowLength(imageSize.width());
+
+                // Assign the selection data of the region to the texture
+                texture->setData(uploadRectangle.left(), uploadRectangle.top(), 0, uploadRectangle.width(), uploadRectangle.height(), 1, QOpenGLTexture::PixelFormat::Red, QOpenGLTexture::PixelType::UInt8, selectionData.data() + static_cast<std::size_t>(uploadRectangle.top()) * imageSize.width() + uploadRectangle.left(), &options);
+            }
+
+            if (!uploadRectangle.isEmpty() && reduction > 1) {
+
+                // Overlay texels that cover the changed region
+                const auto texelRectangle = QRect(QPoint(uploadRectangle.left() / reduction, uploadRectangle.top() / reduction), QPoint(uploadRectangle.right() / reduction, uploadRectangle.bottom() / reduction));
+
+                std::vector<std::uint8_t> overlayData(static_cast<std::size_t>(texelRectangle.width()) * texelRectangle.height(), 0);
+
+                const auto lastPixelY = std::min((texelRectangle.bottom() + 1) * reduction, imageSize.height()) - 1;
+                const auto lastPixelX = std::min((texelRectangle.right() + 1) * reduction, imageSize.width()) - 1;
+
+                for (auto pixelY = texelRectangle.top() * reduction; pixelY <= lastPixelY; pixelY++) {
+                    const auto scanLine         = selectionData.data() + static_cast<std::size_t>(pixelY) * imageSize.width();
+                    const auto overlayScanLine  = overlayData.data() + static_cast<std::size_t>(pixelY / reduction - texelRectangle.top()) * texelRectangle.width();
+
+                    for (auto pixelX = texelRectangle.left() * reduction; pixelX <= lastPixelX; pixelX++)
+                        if (scanLine[pixelX] != 0)
+                            overlayScanLine[pixelX / reduction - texelRectangle.left()] = 255;
+                }
+
+                QOpenGLPixelTransferOptions options;
+
+                options.setAlignment(1);
+
+                // Assign the reduced selection data of the region to the texture
+                texture->setData(texelRectangle.left(), texelRectangle.top(), 0, texelRectangle.width(), texelRectangle.height(), 1, QOpenGLTexture::PixelFormat::Red, QOpenGLTexture::PixelType::UInt8, overlayData.data(), &options);
+            }
         }
+        getRenderer().releaseOpenGLContext();
     }
     catch (std::exception& e)
     {
-        exceptionMessageBox("Unable to set channel color map interpolation type in layer image prop", e.what());
+        exceptionMessageBox("Unable to set selection data in layer image prop", e);
     }
     catch (...) {
-        exceptionMessageBox("Unable to set channel color map interpolation type in layer image prop");
+        exceptionMessageBox("Unable to set selection data in layer image prop");
     }
 }
 
-void ImageProp::setColorMapInterpolationType(const InterpolationType& interpolationType)
+void ImageProp::setInterpolationType(const InterpolationType& interpolationType)
 {
     try {
 
-        getRenderer().bindOpenGLContext();
-        {
-            // Get color map texture
-            auto texture = getTextureByName("ColorMap");
+        // Get channel textures and their streaming slots (or tiles texture when streaming tiles)
+        QStringList textureNames({ _tiled ? QString("Tiles") : getChannelTextureName(0) });
+
+        // Except when the tiles texture is not created (channel textures are configured when their staged upload is issued)
+        if (_tiled && !getTextureByName(textureNames.first())->isCreated())
+            throw std::runtime_error("Tiles texture is not created.");
+
+        if (!_tiled) {
+            textureNames << "Dimensions";
+
+            for (std::int32_t channelIndex = 0; channelIndex < 3; channelIndex++) {
+                textureNames << QString("Channel%1").arg(channelIndex + 1);
+
+                for (std::int32_t slot = 0; slot < numberOfStreamingSlots; slot++)
+                    textureNames << QString("Channel%1Slot%2").arg(QString::number(channelIndex + 1), QString::number(slot));
+            }
+
+            textureNames.removeDuplicates();
+        }
+
+        for (const auto& textureName : textureNames) {
+            auto texture = getTextureByName(textureName);
 
-            // Except when texture is not created
             if (!texture->isCreated())
-                throw std::runtime_error("Color map texture is not created.");
+                continue;
 
             // Configure interpolation
             switch (interpolationType)
             {
-                case InterpolationType::Bilinear:
+                case InterpolationType::Bilinear :
                     texture->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
                     break;
 
-                case InterpolationType::NearestNeighbor:
+                case InterpolationType::NearestNeighbor :
                     texture->setMinMagFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
                     break;
 
@@ -428,13 +984,892 @@ void ImageProp::setColorMapInterpolationType(const InterpolationType& interpolat
                     break;
             }
         }
-        getRenderer().releaseOpenGLContext();
     }
     catch (std::exception& e)
     {
-        exceptionMessageBox("Unable to set channel interpolation type in layer image prop", e.what());
+        exceptionMessageBox("Unable to set channel color map interpolation type in layer image prop", e.what());
     }
     catch (...) {
-        exceptionMessageBox("Unable to set channel interpolation type in layer image prop");
+        exceptionMessageBox("Unable to set channel color map interpolation type in layer image prop");
     }
 }
+
+void ImageProp::setColorMapInterpolationType(const InterpolationType& interpolationType)
+{
+    // The atlas is shared by all layers, so nearest neighbor interpolation is resolved in the shader
+    _colorMapInterpolationType = interpolationType;
+}
+
+bool ImageProp::isTiled() const
+{
+    return _tiled;
+}
+
+void ImageProp::setStreaming(bool streaming)
+{
+    _streaming = streaming;
+}
+
+std::uint64_t ImageProp::getResidentDimensionsCost(std::int32_t numberOfDimensions) const
+{
+    return static_cast<std::uint64_t>(_imageSize.width()) * static_cast<std::uint64_t>(_imageSize.height()) * static_cast<std::uint64_t>(std::max(0, numberOfDimensions)) * sizeof(std::uint16_t);
+}
+
+bool ImageProp::allocateResidentDimensions(std::int32_t numberOfDimensions)
+{
+    releaseResidentDimensions();
+
+    try {
+
+        // Tiled images are too large to keep all dimensions resident
+        if (_tiled || numberOfDimensions <= 0 || !_imageSize.isValid())
+            return false;
+
+        const auto cost = getResidentDimensionsCost(numberOfDimensions);
+
+        if (cost > residentDimensionsBudget) {
+#if _DEBUG
+            qDebug() << "Resident dimensions require" << cost / (1024 * 1024) << "MB, which exceeds the budget, channels are uploaded on demand";
+#endif
+            return false;
+        }
+
+        auto allocated = false;
+
+        getRenderer().bindOpenGLContext();
+        {
+            GLint maximumArrayTextureLayers = 0;
+
+            getRenderer().getOpenGLContext()->functions()->glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maximumArrayTextureLayers);
+
+            if (numberOfDimensions <= maximumArrayTextureLayers) {
+                auto& texture = getTextureByName("Dimensions");
+
+                texture->create();
+                texture->setLayers(numberOfDimensions);
+                texture->setSize(_imageSize.width(), _imageSize.height());
+                texture->setFormat(QOpenGLTexture::R16_UNorm);
+                texture->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::UInt16);
+                texture->setWrapMode(QOpenGLTexture::ClampToBorder);
+
+                allocated = true;
+            }
+        }
+        getRenderer().releaseOpenGLContext();
+
+        if (!allocated) {
+#if _DEBUG
+            qDebug() << "Resident dimensions exceed the maximum number of array texture layers, channels are uploaded on demand";
+#endif
+            return false;
+        }
+
+        _residentDimensions.assign(numberOfDimensions, false);
+        _residentDenormalizations.assign(numberOfDimensions, QVector2D(1.0f, 0.0f));
+        _residentRanges.assign(numberOfDimensions, DisplayRange(0.0f, 0.0f));
+
+        setInterpolationType(static_cast<InterpolationType>(_layer.getImageSettingsAction().getInterpolationTypeAction().getCurrentIndex()));
+
+#if _DEBUG
+        qDebug() << "Allocated" << numberOfDimensions << "resident dimensions (" << cost / (1024 * 1024) << "MB )";
+#endif
+
+        return true;
+    }
+    catch (std::exception& e)
+    {
+        exceptionMessageBox("Unable to allocate resident dimensions in layer image prop", e);
+    }
+    catch (...) {
+        exceptionMessageBox("Unable to allocate resident dimensions in layer image prop");
+    }
+
+    return false;
+}
+
+void ImageProp::releaseResidentDimensions()
+{
+    getRenderer().bindOpenGLContext();
+    {
+        auto& texture = getTextureByName("Dimensions");
+
+        if (texture->isCreated())
+            texture->destroy();
+    }
+    getRenderer().releaseOpenGLContext();
+
+    _residentDimensions.clear();
+    _residentDenormalizations.clear();
+    _residentRanges.clear();
+
+    _channelLayers.fill(-1);
+}
+
+void ImageProp::setResidentDimension(std::int32_t dimensionIndex, const ChannelStorage& channelStorage, const DisplayRange& scalarDataRange)
+{
+    try {
+        if (dimensionIndex < 0 || dimensionIndex >= static_cast<std::int32_t>(_residentDimensions.size()))
+            return;
+
+        if (channelStorage.getFormat() != ChannelStorage::Format::UInt16 || channelStorage.getSize() != _imageSize)
+            throw std::runtime_error("Resident dimension storage does not match the texture array");
+
+        getRenderer().bindOpenGLContext();
+        {
+            QOpenGLPixelTransferOptions options;
+
+            // Rows of sixteen bit texels are not necessarily four byte aligned
+            options.setAlignment(1);
+
+            getTextureByName("Dimensions")->setData(0, dimensionIndex, QOpenGLTexture::Red, QOpenGLTexture::UInt16, channelStorage.getData().constData(), &options);
+        }
+        getRenderer().releaseOpenGLContext();
+
+        _residentDimensions[dimensionIndex]         = true;
+        _residentDenormalizations[dimensionIndex]   = QVector2D(channelStorage.getScale(), channelStorage.getOffset());
+        _residentRanges[dimensionIndex]             = scalarDataRange;
+    }
+    catch (std::exception& e)
+    {
+        exceptionMessageBox("Unable to set resident dimension in layer image prop", e);
+    }
+    catch (...) {
+        exceptionMessageBox("Unable to set resident dimension in layer image prop");
+    }
+}
+
+bool ImageProp::isDimensionResident(std::int32_t dimensionIndex) const
+{
+    if (dimensionIndex < 0 || dimensionIndex >= static_cast<std::int32_t>(_residentDimensions.size()))
+        return false;
+
+    return _residentDimensions[dimensionIndex];
+}
+
+ImageProp::DisplayRange ImageProp::getResidentDimensionRange(std::int32_t dimensionIndex) const
+{
+    if (!isDimensionResident(dimensionIndex))
+        return {};
+
+    return _residentRanges[dimensionIndex];
+}
+
+void ImageProp::setChannelDimension(std::uint32_t channelIndex, std::int32_t dimensionIndex)
+{
+    if (channelIndex >= 3)
+        return;
+
+    _channelLayers[channelIndex] = isDimensionResident(dimensionIndex) ? dimensionIndex : -1;
+
+    // Switching between resident dimensions presents a new frame without an upload
+    if (_channelLayers[channelIndex] >= 0)
+        _channelPresentations[channelIndex] = true;
+}
+
+void ImageProp::buildPyramid(std::int32_t pyramidIndex, const QVector<float>& scalarData)
+{
+    const auto generation   = ++_pyramidGenerations[pyramidIndex];
+    const auto imageSize    = _imageSize;
+
+    // The layer (which owns the prop) might be removed before the pyramid is built
+    QPointer<Layer> guardedLayer(&_layer);
+
+    // Build the pyramid on a worker thread and hand it to the prop on the GUI thread
+    QThreadPool::globalInstance()->start([this, guardedLayer, pyramidIndex, generation, scalarData, imageSize]() -> void {
+        try {
+            const auto pyramid = QSharedPointer<const ImagePyramid>(new ImagePyramid(scalarData, imageSize));
+
+            // The worker does not touch the prop, it is only dereferenced on the GUI thread once the layer is known to be alive
+            QMetaObject::invokeMethod(QCoreApplication::instance(), [this, guardedLayer, pyramidIndex, generation, pyramid]() -> void {
+
+                // Discard when the layer was removed or a newer build was started in the meantime
+                if (guardedLayer.isNull() || generation != _pyramidGenerations[pyramidIndex])
+                    return;
+
+                _pyramids[pyramidIndex] = pyramid;
+
+                if (pyramidIndex < 3)
+                    _channelPresentations[pyramidIndex] = true;
+
+                // Tiles interleave all pyramids, so every cached tile is out of date
+                _tileCache.clear();
+
+                _layer.invalidate();
+            }, Qt::QueuedConnection);
+        }
+        catch (std::exception& e)
+        {
+            qWarning() << "Unable to build image pyramid:" << e.what();
+        }
+        catch (...) {
+            qWarning() << "Unable to build image pyramid";
+        }
+    });
+}
+
+void ImageProp::renderTiles(QOpenGLShaderProgram& shaderProgram, const QMatrix4x4& transform)
+{
+    // Nothing to show until at least one channel pyramid is built
+    if (_pyramids[0].isNull() && _pyramids[1].isNull() && _pyramids[2].isNull())
+        return;
+
+    const auto shape            = getShapeByName<QuadShape>("Quad");
+    const auto quadRectangle    = shape->getRectangle();
+    const auto parentWidget     = getRenderer().getParentWidget();
+
+    // Tiles are chosen per device pixel, the widget size is in logical pixels
+    const auto viewSize         = parentWidget->size() * parentWidget->devicePixelRatio();
+
+    if (!quadRectangle.isValid() || viewSize.isEmpty())
+        return;
+
+    bool invertible = false;
+
+    const auto inverseTransform = transform.inverted(&invertible);
+
+    if (!invertible)
+        return;
+
+    // Map the viewport corners back onto the quad to establish the visible region
+    QPolygonF visiblePolygon;
+
+    for (const auto& corner : { QVector3D(-1.0f, -1.0f, 0.0f), QVector3D(1.0f, -1.0f, 0.0f), QVector3D(1.0f, 1.0f, 0.0f), QVector3D(-1.0f, 1.0f, 0.0f) })
+        visiblePolygon << inverseTransform.map(corner).toPointF();
+
+    const auto visibleRectangle = visiblePolygon.boundingRect();
+
+    // Visible region in texture coordinates
+    const auto visibleUV = QRectF((visibleRectangle.left() - quadRectangle.left()) / quadRectangle.width(), (visibleRectangle.top() - quadRectangle.top()) / quadRectangle.height(), visibleRectangle.width() / quadRectangle.width(), visibleRectangle.height() / quadRectangle.height()).intersected(QRectF(0.0, 0.0, 1.0, 1.0));
+
+    if (visibleUV.isEmpty())
+        return;
+
+    // Choose the level at which one texel covers (at least) one screen pixel
+    const auto imagePixelsPerScreenPixel    = std::max(visibleRectangle.width() / viewSize.width(), visibleRectangle.height() / viewSize.height());
+    const auto numberOfLevels               = ImagePyramid::getNumberOfLevels(_imageSize);
+
+    auto level = std::clamp(static_cast<std::int32_t>(std::floor(std::log2(std::max(1.0, imagePixelsPerScreenPixel)))), 0, numberOfLevels - 1);
+
+    // Establish the range of visible tiles, moving to a coarser level when they would not fit in the cache
+    QRect tileRange;
+
+    for (; level < numberOfLevels; level++) {
+        const auto levelSize        = ImagePyramid::getLevelSize(_imageSize, level);
+        const auto numberOfTiles    = ImagePyramid::getNumberOfTiles(_imageSize, level);
+        const auto left             = static_cast<std::int32_t>(std::floor(visibleUV.left() * levelSize.width() / ImagePyramid::tileSize));
+        const auto right            = static_cast<std::int32_t>(std::floor(visibleUV.right() * levelSize.width() / ImagePyramid::tileSize));
+        const auto top              = static_cast<std::int32_t>(std::floor(visibleUV.top() * levelSize.height() / ImagePyramid::tileSize));
+        const auto bottom           = static_cast<std::int32_t>(std::floor(visibleUV.bottom() * levelSize.height() / ImagePyramid::tileSize));
+
+        tileRange = QRect(QPoint(left, top), QPoint(right, bottom)).intersected(QRect(QPoint(0, 0), numberOfTiles));
+
+        if (tileRange.width() * tileRange.height() <= _tileCache.getNumberOfSlots() / 2 || level == numberOfLevels - 1)
+            break;
+    }
+
+    std::int32_t numberOfUploads    = 0;
+    bool pendingTiles               = false;
+
+    for (std::int32_t tileY = tileRange.top(); tileY <= tileRange.bottom(); tileY++) {
+        for (std::int32_t tileX = tileRange.left(); tileX <= tileRange.right(); tileX++) {
+            TileCache::Tile tile{ level, tileX, tileY };
+
+            auto slot = _tileCache.find(tile);
+
+            // Stream in the tile when the upload budget for this frame allows it
+            if (slot < 0 && numberOfUploads < maximumNumberOfTileUploadsPerFrame) {
+                slot = _tileCache.insert(tile);
+
+                uploadTile(tile, slot);
+
+                numberOfUploads++;
+            }
+
+            // Otherwise fall back to the closest coarser tile that is resident
+            auto sourceTile = tile;
+
+            if (slot < 0) {
+                pendingTiles = true;
+
+                for (std::int32_t coarserLevel = level + 1; coarserLevel < numberOfLevels && slot < 0; coarserLevel++) {
+                    const auto levelShift = coarserLevel - level;
+
+                    sourceTile  = TileCache::Tile{ coarserLevel, tileX >> levelShift, tileY >> levelShift };
+                    slot        = _tileCache.find(sourceTile);
+                }
+            }
+
+            if (slot < 0)
+                continue;
+
+            // Region of the quad covered by the tile in texture coordinates
+            const auto tileRectangle    = ImagePyramid::getTileRectangle(_imageSize, level, tileX, tileY);
+            const auto levelSize        = ImagePyramid::getLevelSize(_imageSize, level);
+            const auto tileBounds       = QVector4D(static_cast<float>(tileRectangle.left()) / levelSize.width(), static_cast<float>(tileRectangle.top()) / levelSize.height(), static_cast<float>(tileRectangle.left() + tileRectangle.width()) / levelSize.width(), static_cast<float>(tileRectangle.top() + tileRectangle.height()) / levelSize.height());
+
+            // Map texture coordinates into the (bordered) source tile
+            const auto sourceScale      = QVector2D(_imageSize.width(), _imageSize.height()) / static_cast<float>(1 << sourceTile._level);
+            const auto tileTransform    = QVector4D(sourceScale.x() / ImagePyramid::tileTexels, sourceScale.y() / ImagePyramid::tileTexels, static_cast<float>(ImagePyramid::tileBorder - sourceTile._x * ImagePyramid::tileSize) / ImagePyramid::tileTexels, static_cast<float>(ImagePyramid::tileBorder - sourceTile._y * ImagePyramid::tileSize) / ImagePyramid::tileTexels);
+
+            shaderProgram.setUniformValue("tileBounds", tileBounds);
+            shaderProgram.setUniformValue("tileTransform", tileTransform);
+            shaderProgram.setUniformValue("tileLayer", static_cast<float>(slot));
+
+            shape->render();
+        }
+    }
+
+    // Keep streaming in the next frame
+    if (pendingTiles)
+        _layer.invalidate();
+}
+
+QString ImageProp::getChannelTextureName(std::uint32_t channelIndex) const
+{
+    if (channelIndex >= 3 || _channelSlots[channelIndex] < 0)
+        return QString("Channel%1").arg(channelIndex + 1);
+
+    return QString("Channel%1Slot%2").arg(QString::number(channelIndex + 1), QString::number(_channelSlots[channelIndex]));
+}
+
+std::int32_t ImageProp::acquireStreamingBuffer()
+{
+    auto functions = getRenderer().getOpenGLContext()->extraFunctions();
+
+    if (_pixelUnpackBuffers[0] == 0)
+        functions->glGenBuffers(static_cast<GLsizei>(_pixelUnpackBuffers.size()), _pixelUnpackBuffers.data());
+
+    const auto uploadIndex = (_uploadIndex + 1) % numberOfStreamingSlots;
+
+    // A worker thread is still packing the previous upload into this buffer
+    const auto packing = std::any_of(_pendingUploads.begin(), _pendingUploads.end(), [uploadIndex](const PendingUpload& pendingUpload) -> bool {
+        return pendingUpload._streamingBuffer == uploadIndex;
+    });
+
+    if (packing)
+        return -1;
+
+    // The GPU has not finished reading the previous upload from this buffer
+    if (_uploadFences[uploadIndex] != nullptr) {
+        if (functions->glClientWaitSync(_uploadFences[uploadIndex], 0, 0) == GL_TIMEOUT_EXPIRED)
+            return -1;
+
+        functions->glDeleteSync(_uploadFences[uploadIndex]);
+
+        _uploadFences[uploadIndex] = nullptr;
+    }
+
+    _uploadIndex = uploadIndex;
+
+    return uploadIndex;
+}
+
+void ImageProp::packChannelUpload(std::uint32_t channelIndex, std::uint64_t request, const QVector<float>& scalarData, const QSize& size, bool compress, void* mappedData)
+{
+    QPointer<Layer> guardedLayer(&_layer);
+
+    _uploadThreadPool.start([this, guardedLayer, channelIndex, request, scalarData, size, compress, mappedData]() -> void {
+        auto format             = ChannelStorage::Format::Float32;
+        auto denormalization    = QVector2D(1.0f, 0.0f);
+        auto numberOfBytes      = std::uint64_t{ 0 };
+
+        try {
+            const ChannelStorage channelStorage(scalarData, size, compress);
+
+            const auto isFloat32 = channelStorage.getFormat() == ChannelStorage::Format::Float32;
+
+            numberOfBytes = isFloat32 ? static_cast<std::uint64_t>(scalarData.size()) * sizeof(float) : static_cast<std::uint64_t>(channelStorage.getData().size());
+
+            std::memcpy(mappedData, isFloat32 ? static_cast<const void*>(scalarData.constData()) : static_cast<const void*>(channelStorage.getData().constData()), static_cast<std::size_t>(numberOfBytes));
+
+            format          = channelStorage.getFormat();
+            denormalization = QVector2D(channelStorage.getScale(), channelStorage.getOffset());
+        }
+        catch (std::exception& e)
+        {
+            qWarning() << "Unable to stage channel upload:" << e.what();
+        }
+        catch (...) {
+            qWarning() << "Unable to stage channel upload";
+        }
+
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [this, guardedLayer, channelIndex, request, format, denormalization, numberOfBytes]() -> void {
+            if (guardedLayer.isNull())
+                return;
+
+            markUploadReady(static_cast<std::int32_t>(channelIndex), request, format, denormalization, numberOfBytes);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void* ImageProp::stageUpload(std::int32_t target, std::uint64_t request, const QSize& size, std::uint64_t numberOfBytes, std::uint64_t generation, bool compression, std::int32_t streamingBuffer)
+{
+    auto functions = getRenderer().getOpenGLContext()->extraFunctions();
+
+    PendingUpload pendingUpload{ target, request, 0, nullptr, false, ChannelStorage::Format::Float32, size, QVector2D(1.0f, 0.0f), 0, generation, compression, streamingBuffer };
+
+    // Streamed uploads reuse the buffers of the upload ring
+    if (streamingBuffer >= 0)
+        pendingUpload._pixelUnpackBuffer = _pixelUnpackBuffers[streamingBuffer];
+    else
+        functions->glGenBuffers(1, &pendingUpload._pixelUnpackBuffer);
+
+    functions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pendingUpload._pixelUnpackBuffer);
+    functions->glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(numberOfBytes), nullptr, GL_STREAM_DRAW);
+
+    // The mapping stays valid (and may be written from any thread) until it is unmapped at the next frame
+    pendingUpload._mappedData = functions->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(numberOfBytes), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+    functions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Fall back to a synchronous upload
+    if (pendingUpload._mappedData == nullptr) {
+        if (streamingBuffer < 0)
+            functions->glDeleteBuffers(1, &pendingUpload._pixelUnpackBuffer);
+
+        return nullptr;
+    }
+
+    _pendingUploads.push_back(pendingUpload);
+
+    return pendingUpload._mappedData;
+}
+
+void ImageProp::markUploadReady(std::int32_t target, std::uint64_t request, const ChannelStorage::Format& format, const QVector2D& denormalization, std::uint64_t numberOfBytes)
+{
+    for (auto& pendingUpload : _pendingUploads) {
+        if (pendingUpload._target != target || pendingUpload._request != request)
+            continue;
+
+        pendingUpload._ready            = true;
+        pendingUpload._format           = format;
+        pendingUpload._denormalization  = denormalization;
+        pendingUpload._numberOfBytes    = numberOfBytes;
+    }
+
+    // Issue the texture update at the next frame
+    _layer.invalidate();
+}
+
+void ImageProp::finishUploads()
+{
+    auto functions = getRenderer().getOpenGLContext()->extraFunctions();
+
+    // Delete pixel unpack buffers that the GPU finished reading from
+    for (auto it = _retiredUploads.begin(); it != _retiredUploads.end();) {
+        if (functions->glClientWaitSync(it->second, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            ++it;
+            continue;
+        }
+
+        functions->glDeleteSync(it->second);
+        functions->glDeleteBuffers(1, &it->first);
+
+        it = _retiredUploads.erase(it);
+    }
+
+    for (auto it = _pendingUploads.begin(); it != _pendingUploads.end();) {
+
+        // The worker thread is still filling the pixel unpack buffer
+        if (!it->_ready) {
+            ++it;
+            continue;
+        }
+
+        functions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, it->_pixelUnpackBuffer);
+        functions->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        // Discard uploads that were superseded or that failed
+        if (it->_request != _uploadRequests[it->_target] || it->_numberOfBytes == 0) {
+            functions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            // Buffers of the upload ring are reused, so only the frame is dropped
+            if (it->_streamingBuffer >= 0)
+                emit _layer.channelFrameDropped(static_cast<std::uint32_t>(it->_target));
+            else
+                functions->glDeleteBuffers(1, &it->_pixelUnpackBuffer);
+
+            it = _pendingUploads.erase(it);
+            continue;
+        }
+
+        if (it->_target < 3) {
+
+            // Streamed uploads go into the slot after the one that is displayed, so that the displayed texture is never written to
+            const auto slot = it->_streamingBuffer >= 0 ? (_channelSlots[it->_target] + 1) % numberOfStreamingSlots : -1;
+
+            _channelSlots[it->_target] = slot;
+
+            updateChannelTexture(getTextureByName(getChannelTextureName(static_cast<std::uint32_t>(it->_target))), it->_format, it->_size, static_cast<GLsizei>(it->_numberOfBytes));
+
+            _channelDenormalizations[it->_target]   = it->_denormalization;
+            _channelCompressions[it->_target]       = it->_compression;
+            _channelGenerations[it->_target]        = it->_generation;
+            _channelPresentations[it->_target]      = true;
+
+#if _DEBUG
+            qDebug() << "Channel" << it->_target + 1 << "stored as" << ChannelStorage::getFormatName(it->_format) << "(asynchronous upload)";
+#endif
+        }
+        else {
+            auto& texture = getTextureByName("Mask");
+
+            if (!texture->isCreated() || it->_size != QSize(texture->width(), texture->height())) {
+                if (texture->isCreated())
+                    texture->destroy();
+
+                texture->create();
+                texture->setLayers(1);
+                texture->setSize(it->_size.width(), it->_size.height());
+                texture->setFormat(QOpenGLTexture::R8_UNorm);
+                texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+                texture->setMinMagFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
+                texture->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::UInt8);
+            }
+
+            texture->bind();
+            {
+                functions->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                functions->glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, it->_size.width(), it->_size.height(), 1, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+                functions->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            }
+            texture->release();
+        }
+
+        functions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        // Buffers of the upload ring are reused once the GPU finished reading from them, other buffers are deleted
+        if (it->_streamingBuffer >= 0)
+            _uploadFences[it->_streamingBuffer] = functions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        else
+            _retiredUploads.push_back({ it->_pixelUnpackBuffer, functions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+
+        it = _pendingUploads.erase(it);
+    }
+}
+
+void ImageProp::updateChannelTexture(QSharedPointer<QOpenGLTexture>& texture, const ChannelStorage::Format& format, const QSize& imageSize, GLsizei numberOfBytes)
+{
+    auto functions = getRenderer().getOpenGLContext()->extraFunctions();
+
+    const auto textureFormat = getTextureFormat(format);
+
+    if (!texture->isCreated() || imageSize != QSize(texture->width(), texture->height()) || texture->format() != textureFormat) {
+        if (texture->isCreated())
+            texture->destroy();
+
+        texture->create();
+        texture->setSize(imageSize.width(), imageSize.height());
+        texture->setFormat(textureFormat);
+        texture->allocateStorage();
+        texture->setWrapMode(QOpenGLTexture::ClampToBorder);
+
+        const auto interpolationType = static_cast<InterpolationType>(_layer.getImageSettingsAction().getInterpolationTypeAction().getCurrentIndex());
+
+        texture->setMinMagFilters(interpolationType == InterpolationType::NearestNeighbor ? QOpenGLTexture::Nearest : QOpenGLTexture::Linear, interpolationType == InterpolationType::NearestNeighbor ? QOpenGLTexture::Nearest : QOpenGLTexture::Linear);
+    }
+
+    texture->bind();
+    {
+        // Source the texels from the pixel unpack buffer, the transfer proceeds asynchronously
+        functions->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        switch (format)
+        {
+            case ChannelStorage::Format::Float32:
+                functions->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, imageSize.width(), imageSize.height(), GL_RED, GL_FLOAT, nullptr);
+                break;
+
+            case ChannelStorage::Format::Float16:
+                functions->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, imageSize.width(), imageSize.height(), GL_RED, GL_HALF_FLOAT, nullptr);
+                break;
+
+            case ChannelStorage::Format::UInt16:
+                functions->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, imageSize.width(), imageSize.height(), GL_RED, GL_UNSIGNED_SHORT, nullptr);
+                break;
+
+            case ChannelStorage::Format::UInt8:
+                functions->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, imageSize.width(), imageSize.height(), GL_RED, GL_UNSIGNED_BYTE, nullptr);
+                break;
+
+            case ChannelStorage::Format::BC4:
+                functions->glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, imageSize.width(), imageSize.height(), GL_COMPRESSED_RED_RGTC1, numberOfBytes, nullptr);
+                break;
+
+            default:
+                break;
+        }
+
+        functions->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    texture->release();
+}
+
+QOpenGLTexture::TextureFormat ImageProp::getTextureFormat(const ChannelStorage::Format& format)
+{
+    switch (format)
+    {
+        case ChannelStorage::Format::Float32:
+            return QOpenGLTexture::R32F;
+
+        case ChannelStorage::Format::Float16:
+            return QOpenGLTexture::R16F;
+
+        case ChannelStorage::Format::UInt16:
+            return QOpenGLTexture::R16_UNorm;
+
+        case ChannelStorage::Format::UInt8:
+            return QOpenGLTexture::R8_UNorm;
+
+        case ChannelStorage::Format::BC4:
+            return QOpenGLTexture::R_ATI1N_UNorm;
+
+        default:
+            break;
+    }
+
+    return QOpenGLTexture::R32F;
+}
+
+void ImageProp::uploadTile(const TileCache::Tile& tile, std::int32_t slot)
+{
+    for (std::int32_t pyramidIndex = 0; pyramidIndex < numberOfPyramids; pyramidIndex++) {
+        const auto& pyramid = _pyramids[pyramidIndex];
+
+        if (!pyramid.isNull() && tile._level < pyramid->getNumberOfLevels()) {
+            pyramid->copyTile(tile._level, tile._x, tile._y, _tileData.data(), numberOfPyramids, pyramidIndex);
+        }
+        else {
+
+            // Missing channels are zero, a missing mask means everything is visible
+            const auto defaultValue = pyramidIndex == numberOfPyramids - 1 ? 1.0f : 0.0f;
+
+            for (std::size_t texelIndex = pyramidIndex; texelIndex < _tileData.size(); texelIndex += numberOfPyramids)
+                _tileData[texelIndex] = defaultValue;
+        }
+    }
+
+    getTextureByName("Tiles")->setData(0, slot, QOpenGLTexture::RGBA, QOpenGLTexture::Float32, _tileData.data());
+}
+
+void ImageProp::updateColorSpaceLookupTexture(const ColorSpaceType& colorSpaceType)
+{
+    auto& texture = getTextureByName("ColorSpaceLookup");
+
+    // The lookup table of this color space is uploaded already
+    if (texture->isCreated() && _colorSpaceLookupType == static_cast<std::int32_t>(colorSpaceType))
+        return;
+
+    const auto& lookupTable = ColorSpaceLookupTable::get(colorSpaceType);
+
+    texture.reset(new QOpenGLTexture(QOpenGLTexture::Target3D));
+
+    texture->setSize(ColorSpaceLookupTable::size, ColorSpaceLookupTable::size, ColorSpaceLookupTable::size);
+    texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    texture->setMipLevels(1);
+    texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+    texture->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, lookupTable.getData().constData());
+
+    // Trilinear interpolation between the lattice points
+    texture->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
+    texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+
+    _colorSpaceLookupType = static_cast<std::int32_t>(colorSpaceType);
+}
+
+bool ImageProp::isLabelMap() const
+{
+    // Tiles hold the channels as floating point values, so streamed label maps are color mapped like other images
+    return !_tiled && _layer.getSourceDataset()->getDataType() == ClusterType;
+}
+
+void ImageProp::setLabels(const QVector<float>& scalarData, const QSize& imageSize)
+{
+    if (scalarData.size() < static_cast<qsizetype>(imageSize.width()) * imageSize.height())
+        return;
+
+    _labels.resize(static_cast<std::size_t>(scalarData.size()));
+
+    // Pixels without a (valid) cluster index get a label beyond the last label, they are not drawn
+    std::transform(scalarData.begin(), scalarData.end(), _labels.begin(), LabelIndex::toLabel);
+
+    auto& texture = getTextureByName("Labels");
+
+    // Re-configure when the image size has changed
+    if (!texture->isCreated() || imageSize != QSize(texture->width(), texture->height())) {
+        texture->destroy();
+        texture->create();
+        texture->setSize(imageSize.width(), imageSize.height());
+        texture->setFormat(QOpenGLTexture::R32U);
+        texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+        texture->setMinMagFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
+        texture->allocateStorage(QOpenGLTexture::RedInteger, QOpenGLTexture::UInt32);
+    }
+
+    texture->setData(QOpenGLTexture::PixelFormat::RedInteger, QOpenGLTexture::PixelType::UInt32, _labels.data());
+}
+
+void ImageProp::setLabelColors(const QVector<QColor>& labelColors)
+{
+    try {
+        getRenderer().bindOpenGLContext();
+        {
+            const auto numberOfLabels = static_cast<std::size_t>(labelColors.size());
+
+            // Flags are (re-)initialized when the number of labels changes
+            if (_labelProperties.size() != labelPropertiesSize * numberOfLabels) {
+                _labelProperties.assign(labelPropertiesSize * numberOfLabels, 0);
+
+                for (std::uint32_t label = 0; label < numberOfLabels; label++)
+                    setLabelFlags(label, false);
+
+                for (const auto& selectedLabel : _selectedLabels)
+                    if (selectedLabel < numberOfLabels)
+                        setLabelFlags(selectedLabel, true);
+            }
+
+            for (std::size_t label = 0; label < numberOfLabels; label++) {
+                const auto& labelColor  = labelColors[static_cast<qsizetype>(label)];
+                auto labelProperties    = _labelProperties.data() + labelPropertiesSize * label;
+
+                labelProperties[0] = static_cast<std::uint8_t>(labelColor.red());
+                labelProperties[1] = static_cast<std::uint8_t>(labelColor.green());
+                labelProperties[2] = static_cast<std::uint8_t>(labelColor.blue());
+                labelProperties[3] = static_cast<std::uint8_t>(labelColor.alpha());
+            }
+
+            if (numberOfLabels > 0)
+                uploadLabelProperties(0, static_cast<std::uint32_t>(numberOfLabels - 1));
+            else
+                _numberOfLabels = 0;
+        }
+        getRenderer().releaseOpenGLContext();
+    }
+    catch (std::exception& e)
+    {
+        exceptionMessageBox("Unable to set label colors in layer image prop", e);
+    }
+    catch (...) {
+        exceptionMessageBox("Unable to set label colors in layer image prop");
+    }
+}
+
+void ImageProp::setSelectedLabels(const std::vector<std::uint32_t>& selectedLabels)
+{
+    try {
+        getRenderer().bindOpenGLContext();
+        {
+            const auto numberOfLabels = static_cast<std::uint32_t>(_labelProperties.size() / labelPropertiesSize);
+
+            // Range of labels of which the flags changed
+            auto firstLabel = std::numeric_limits<std::uint32_t>::max();
+            auto lastLabel  = std::uint32_t{ 0 };
+
+            const auto updateLabelFlags = [this, numberOfLabels, &firstLabel, &lastLabel](const std::vector<std::uint32_t>& labels, bool selected) -> void {
+                for (const auto& label : labels) {
+                    if (label >= numberOfLabels)
+                        continue;
+
+                    setLabelFlags(label, selected);
+
+                    firstLabel  = std::min(firstLabel, label);
+                    lastLabel   = std::max(lastLabel, label);
+                }
+            };
+
+            updateLabelFlags(_selectedLabels, false);
+            updateLabelFlags(selectedLabels, true);
+
+            _selectedLabels = selectedLabels;
+
+            if (firstLabel <= lastLabel)
+                uploadLabelProperties(firstLabel, lastLabel);
+        }
+        getRenderer().releaseOpenGLContext();
+    }
+    catch (std::exception& e)
+    {
+        exceptionMessageBox("Unable to set selected labels in layer image prop", e);
+    }
+    catch (...) {
+        exceptionMessageBox("Unable to set selected labels in layer image prop");
+    }
+}
+
+void ImageProp::setSelectedLabelsOnly(bool selectedLabelsOnly)
+{
+    if (selectedLabelsOnly == _selectedLabelsOnly)
+        return;
+
+    try {
+        getRenderer().bindOpenGLContext();
+        {
+            _selectedLabelsOnly = selectedLabelsOnly;
+
+            const auto numberOfLabels = static_cast<std::uint32_t>(_labelProperties.size() / labelPropertiesSize);
+
+            // Only the visibility flag changes, the selection flag is kept
+            for (std::uint32_t label = 0; label < numberOfLabels; label++)
+                setLabelFlags(label, _labelProperties[labelPropertiesSize * label + 5] > 0);
+
+            if (numberOfLabels > 0)
+                uploadLabelProperties(0, numberOfLabels - 1);
+        }
+        getRenderer().releaseOpenGLContext();
+    }
+    catch (std::exception& e)
+    {
+        exceptionMessageBox("Unable to set selected labels only in layer image prop", e);
+    }
+    catch (...) {
+        exceptionMessageBox("Unable to set selected labels only in layer image prop");
+    }
+}
+
+void ImageProp::setLabelFlags(std::uint32_t label, bool selected)
+{
+    auto labelProperties = _labelProperties.data() + labelPropertiesSize * static_cast<std::size_t>(label);
+
+    labelProperties[4] = !_selectedLabelsOnly || selected ? 255 : 0;
+    labelProperties[5] = selected ? 255 : 0;
+}
+
+void ImageProp::uploadLabelProperties(std::uint32_t firstLabel, std::uint32_t lastLabel)
+{
+    auto functions = getRenderer().getOpenGLContext()->extraFunctions();
+
+    const auto numberOfLabels = static_cast<std::int32_t>(_labelProperties.size() / labelPropertiesSize);
+
+    if (_labelPropertiesBuffer == 0)
+        functions->glGenBuffers(1, &_labelPropertiesBuffer);
+
+    if (_labelPropertiesTexture == 0)
+        functions->glGenTextures(1, &_labelPropertiesTexture);
+
+    functions->glBindBuffer(GL_TEXTURE_BUFFER, _labelPropertiesBuffer);
+
+    // A buffer texture is not limited by the maximum texture size, so it scales to millions of labels
+    if (numberOfLabels != _numberOfLabels) {
+        functions->glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(_labelProperties.size()), _labelProperties.data(), GL_DYNAMIC_DRAW);
+        functions->glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        functions->glBindTexture(GL_TEXTURE_BUFFER, _labelPropertiesTexture);
+        functions->glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA8, _labelPropertiesBuffer);
+        functions->glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+        _numberOfLabels = numberOfLabels;
+        return;
+    }
+
+    // Only the changed range is written
+    const auto offset = labelPropertiesSize * static_cast<std::size_t>(firstLabel);
+    const auto size   = labelPropertiesSize * (static_cast<std::size_t>(lastLabel) - firstLabel + 1);
+
+    functions->glBufferSubData(GL_TEXTURE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), _labelProperties.data() + offset);
+    functions->glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+const std::vector<std::uint32_t>& ImageProp::getLabels() const
+{
+    return _labels;
+}
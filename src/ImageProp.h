@@ -2,8 +2,20 @@
 
 #include "Prop.h"
 #include "Layer.h"
+#include "ImagePyramid.h"
+#include "TileCache.h"
+#include "ChannelStorage.h"
+#include "ColorMapAtlas.h"
 
 #include <util/Interpolation.h>
+#include <util/ColorSpace.h>
+
+#include <QColor>
+#include <QVector2D>
+#include <QThreadPool>
+
+#include <array>
+#include <utility>
 
 class Layer;
 
@@ -34,6 +46,30 @@ public: // Enumerations
         Mask
     };
 
+    /** Number of pyramids (three scalar channels and the mask) */
+    static constexpr std::int32_t numberOfPyramids = 4;
+
+    /** GPU memory budget for the tile cache (and threshold above which the image is streamed in tiles) */
+    static constexpr std::uint64_t tileCacheBudget = 512ull * 1024ull * 1024ull;
+
+    /** Memory budget for the selection overlay texture of streamed images (the overlay is reduced to fit) */
+    static constexpr std::uint64_t selectionOverlayBudget = 64ull * 1024ull * 1024ull;
+
+    /** Maximum number of tiles that are uploaded per frame (keeps the frame time bounded while streaming) */
+    static constexpr std::int32_t maximumNumberOfTileUploadsPerFrame = 16;
+
+    /** Number of pixel unpack buffers and channel texture slots in the streaming upload ring (playback) */
+    static constexpr std::int32_t numberOfStreamingSlots = 3;
+
+    /** Uploads of at least this many bytes are staged in a pixel unpack buffer by a worker thread and issued at the next frame */
+    static constexpr std::uint64_t asynchronousUploadThreshold = 4ull * 1024ull * 1024ull;
+
+    /** GPU memory budget for keeping all dimensions resident in a texture array */
+    static constexpr std::uint64_t residentDimensionsBudget = 1024ull * 1024ull * 1024ull;
+
+    /** Number of bytes per label in the label properties buffer (two RGBA8 texels: color and opacity, visibility and selection flags) */
+    static constexpr std::int32_t labelPropertiesSize = 8;
+
 public: // Construction/destruction
 
     /**
@@ -51,6 +87,9 @@ public: // Rendering
     /** Initializes the prop */
     void initialize() override;
 
+    /** Destroys the prop */
+    void destroy() override;
+
     /**
      * Renders the prop
      * @param modelViewProjectionMatrix Model view projection matrix
@@ -73,12 +112,20 @@ public: // Rendering
     void setColorMapImage(const QImage& colorMapImage);
 
     /**
-     * Set channel scalar data
+     * Set channel scalar data, stored in the most compact texture format that preserves it (the upload is skipped when \p generation matches the uploaded generation)
      * @param channelIndex Channel index
      * @param scalarData Scalar data
+     * @param generation Scalar data generation
      * @param displayRange Display range
      */
-    void setChannelScalarData(const std::uint32_t& channelIndex, const QVector<float>& scalarData, const DisplayRange& displayRange);
+    void setChannelScalarData(const std::uint32_t& channelIndex, const QVector<float>& scalarData, const std::uint64_t& generation, const DisplayRange& displayRange);
+
+    /**
+     * Set channel display range (only affects shader uniforms)
+     * @param channelIndex Channel index
+     * @param displayRange Display range
+     */
+    void setChannelDisplayRange(const std::uint32_t& channelIndex, const DisplayRange& displayRange);
 
     /**
      * Set mask data
@@ -86,6 +133,13 @@ public: // Rendering
      */
     void setMaskData(const std::vector<std::uint8_t>& maskData);
 
+    /**
+     * Set selection data, the selection overlay is blended in the same pass as the image
+     * @param selectionData Selection data (non-zero for selected pixels)
+     * @param region Region of which the selection changed in image coordinates (the whole image is uploaded when the texture is re-configured)
+     */
+    void setSelectionData(const std::vector<std::uint8_t>& selectionData, const QRect& region);
+
     /**
      * Set image interpolation type
      * @param interpolationType Interpolation type
@@ -98,7 +152,280 @@ public: // Rendering
      */
     void setColorMapInterpolationType(const InterpolationType& interpolationType);
 
+    /** Returns whether the image is streamed in tiles from a multi-resolution pyramid */
+    bool isTiled() const;
+
+    /**
+     * Set whether channel uploads are streamed (e.g. during playback)
+     * Streamed uploads go through a ring of pixel unpack buffers into a ring of texture slots, so that they overlap rendering
+     * An upload is dropped (and reported through Layer::channelFrameDropped) when its pixel unpack buffer is still in use
+     * @param streaming Whether channel uploads are streamed
+     */
+    void setStreaming(bool streaming);
+
+public: // Label maps
+
+    /** Returns whether the image is a label map (cluster indices), label maps are sampled as integers and colored per label (unless streamed in tiles) */
+    bool isLabelMap() const;
+
+    /**
+     * Set the colors of the labels, uploaded to a texture buffer so that the number of labels is not limited by the maximum texture size
+     * @param labelColors Color per label (cluster), the alpha is the opacity of the label
+     */
+    void setLabelColors(const QVector<QColor>& labelColors);
+
+    /**
+     * Flag \p selectedLabels as selected, only the properties of the previously and newly selected labels are updated
+     * @param selectedLabels Selected labels (clusters)
+     */
+    void setSelectedLabels(const std::vector<std::uint32_t>& selectedLabels);
+
+    /**
+     * Set whether only the selected labels are visible
+     * @param selectedLabelsOnly Whether to hide labels that are not selected
+     */
+    void setSelectedLabelsOnly(bool selectedLabelsOnly);
+
+    /** Get the label per pixel (empty when the image is not a label map) */
+    const std::vector<std::uint32_t>& getLabels() const;
+
+public: // Resident dimensions
+
+    /**
+     * Get the GPU memory that is required to keep \p numberOfDimensions dimensions resident
+     * @param numberOfDimensions Number of dimensions
+     * @return Number of bytes
+     */
+    std::uint64_t getResidentDimensionsCost(std::int32_t numberOfDimensions) const;
+
+    /**
+     * Allocate the resident dimensions texture array with a layer for each of the \p numberOfDimensions dimensions
+     * Fails when the image is tiled, when the cost exceeds the budget or when there are more dimensions than array layers
+     * @param numberOfDimensions Number of dimensions
+     * @return Whether the texture array was allocated (the channels are uploaded on demand otherwise)
+     */
+    bool allocateResidentDimensions(std::int32_t numberOfDimensions);
+
+    /** Release the resident dimensions texture array, the channels sample their own textures again */
+    void releaseResidentDimensions();
+
+    /**
+     * Upload \p channelStorage into the layer of the dimension with \p dimensionIndex
+     * @param dimensionIndex Dimension index
+     * @param channelStorage Packed dimension data (UInt16 format)
+     * @param scalarDataRange Scalar data range of the dimension
+     */
+    void setResidentDimension(std::int32_t dimensionIndex, const ChannelStorage& channelStorage, const DisplayRange& scalarDataRange);
+
+    /**
+     * Get whether the dimension with \p dimensionIndex is uploaded to the resident dimensions texture array
+     * @param dimensionIndex Dimension index
+     * @return Boolean determining whether the dimension is resident
+     */
+    bool isDimensionResident(std::int32_t dimensionIndex) const;
+
+    /**
+     * Get the scalar data range of the resident dimension with \p dimensionIndex
+     * @param dimensionIndex Dimension index
+     * @return Scalar data range
+     */
+    DisplayRange getResidentDimensionRange(std::int32_t dimensionIndex) const;
+
+    /**
+     * Let the channel with \p channelIndex sample the dimension with \p dimensionIndex from the resident dimensions texture array (only changes a shader uniform)
+     * The channel samples its own texture when the dimension is not resident
+     * @param channelIndex Channel index
+     * @param dimensionIndex Dimension index
+     */
+    void setChannelDimension(std::uint32_t channelIndex, std::int32_t dimensionIndex);
+
+protected: // Tiled rendering
+
+    /**
+     * Build the pyramid with \p pyramidIndex from \p scalarData in the background, the tile cache is flushed once it is done
+     * @param pyramidIndex Pyramid index (0-2: scalar channels, 3: mask)
+     * @param scalarData Scalar data in row-column order
+     */
+    void buildPyramid(std::int32_t pyramidIndex, const QVector<float>& scalarData);
+
+    /**
+     * Renders the visible tiles at the pyramid level that matches the current zoom level
+     * @param shaderProgram Bound image shader program variant
+     * @param transform Model-view-projection matrix of the quad
+     */
+    void renderTiles(QOpenGLShaderProgram& shaderProgram, const QMatrix4x4& transform);
+
+    /**
+     * Upload \p tile into \p slot of the tiles texture
+     * @param tile Tile to upload
+     * @param slot Tiles texture layer
+     */
+    void uploadTile(const TileCache::Tile& tile, std::int32_t slot);
+
+protected: // Asynchronous uploads
+
+    /** Texture upload that is staged in a mapped pixel unpack buffer */
+    struct PendingUpload {
+        std::int32_t                _target;                /** Upload target (0-2: scalar channels, 3: mask) */
+        std::uint64_t               _request;               /** Upload request, outdated when a newer upload for the target was requested */
+        GLuint                      _pixelUnpackBuffer;     /** Pixel unpack buffer that holds the texels */
+        void*                       _mappedData;            /** Mapped pixel unpack buffer memory (filled by a worker thread) */
+        bool                        _ready;                 /** Whether the worker thread filled the pixel unpack buffer */
+        ChannelStorage::Format      _format;                /** Storage format of the texels */
+        QSize                       _size;                  /** Image size */
+        QVector2D                   _denormalization;       /** Scale (x) and offset (y) that reconstruct the value from the texture sample */
+        std::uint64_t               _numberOfBytes;         /** Number of bytes written by the worker thread (zero if the worker failed) */
+        std::uint64_t               _generation;            /** Scalar data generation of the upload */
+        bool                        _compression;           /** Whether block compression was requested */
+        std::int32_t                _streamingBuffer;       /** Pixel unpack buffer of the upload ring that holds the texels (-1: buffer owned by the upload) */
+    };
+
+    /**
+     * Create and map a pixel unpack buffer of \p numberOfBytes for upload \p request to \p target (the OpenGL context must be bound)
+     * @param target Upload target (0-2: scalar channels, 3: mask)
+     * @param request Upload request
+     * @param size Image size
+     * @param numberOfBytes Capacity of the pixel unpack buffer
+     * @param generation Scalar data generation of the upload
+     * @param compression Whether block compression was requested
+     * @param streamingBuffer Pixel unpack buffer of the upload ring to stage into (-1: create a buffer for the upload)
+     * @return Mapped memory that the worker thread writes into (nullptr if mapping failed)
+     */
+    void* stageUpload(std::int32_t target, std::uint64_t request, const QSize& size, std::uint64_t numberOfBytes, std::uint64_t generation = 0, bool compression = false, std::int32_t streamingBuffer = -1);
+
+    /**
+     * Pack \p scalarData of the channel with \p channelIndex into \p mappedData on a worker thread, upload \p request is marked ready when done
+     * @param channelIndex Channel index
+     * @param request Upload request
+     * @param scalarData Scalar data
+     * @param size Image size
+     * @param compress Whether to block compress the channel
+     * @param mappedData Mapped pixel unpack buffer memory
+     */
+    void packChannelUpload(std::uint32_t channelIndex, std::uint64_t request, const QVector<float>& scalarData, const QSize& size, bool compress, void* mappedData);
+
+    /**
+     * Mark upload \p request to \p target as filled by the worker thread (called on the GUI thread)
+     * @param target Upload target (0-2: scalar channels, 3: mask)
+     * @param request Upload request
+     * @param format Storage format of the texels
+     * @param denormalization Scale (x) and offset (y) that reconstruct the value from the texture sample
+     * @param numberOfBytes Number of bytes written (zero if the worker failed)
+     */
+    void markUploadReady(std::int32_t target, std::uint64_t request, const ChannelStorage::Format& format, const QVector2D& denormalization, std::uint64_t numberOfBytes);
+
+    /** Issue the texture updates of the filled pixel unpack buffers and recycle the buffers the GPU finished reading (called at the start of each frame) */
+    void finishUploads();
+
+protected: // Channel storage
+
+    /**
+     * Get the name of the texture that currently holds the channel with \p channelIndex
+     * @param channelIndex Channel index
+     * @return Texture name (base channel texture or streaming slot texture)
+     */
+    QString getChannelTextureName(std::uint32_t channelIndex) const;
+
+    /**
+     * Acquire the next pixel unpack buffer of the upload ring for a streamed upload (without waiting)
+     * @return Index of the pixel unpack buffer (-1 when the ring is full and the frame has to be dropped)
+     */
+    std::int32_t acquireStreamingBuffer();
+
+    /**
+     * Update channel \p texture from the bound pixel unpack buffer, the texture is (re)configured when its size or format changed
+     * @param texture Channel texture
+     * @param format Storage format of the texels
+     * @param imageSize Image size
+     * @param numberOfBytes Number of bytes in the pixel unpack buffer
+     */
+    void updateChannelTexture(QSharedPointer<QOpenGLTexture>& texture, const ChannelStorage::Format& format, const QSize& imageSize, GLsizei numberOfBytes);
+
+    /**
+     * Get the texture format for channel storage \p format
+     * @param format Channel storage format
+     * @return OpenGL texture format
+     */
+    static QOpenGLTexture::TextureFormat getTextureFormat(const ChannelStorage::Format& format);
+
+protected: // Label maps
+
+    /**
+     * Convert \p scalarData to labels and upload them to the (unsigned integer) labels texture
+     * @param scalarData Cluster index per pixel
+     * @param imageSize Image size
+     */
+    void setLabels(const QVector<float>& scalarData, const QSize& imageSize);
+
+    /**
+     * Set the visibility and selection flags of \p label in the label properties
+     * @param label Label
+     * @param selected Whether the label is selected
+     */
+    void setLabelFlags(std::uint32_t label, bool selected);
+
+    /**
+     * Upload the properties of the labels in [\p firstLabel, \p lastLabel] (the buffer is re-allocated when the number of labels changed)
+     * @param firstLabel First label to upload
+     * @param lastLabel Last label to upload
+     */
+    void uploadLabelProperties(std::uint32_t firstLabel, std::uint32_t lastLabel);
+
+protected: // Color space lookup
+
+    /**
+     * Upload the lookup table of \p colorSpaceType to the color space lookup texture (unless it holds it already, the OpenGL context must be bound)
+     * @param colorSpaceType Color space of the channels (HSL or LAB)
+     */
+    void updateColorSpaceLookupTexture(const ColorSpaceType& colorSpaceType);
+
+protected: // Shader variants
+
+    /**
+     * Get the preprocessor definitions of the image shader program variant for the current settings
+     * (number of channels, color space and its conversion, whether the image is masked and whether a constant color is used)
+     * @return Preprocessor definitions
+     */
+    QStringList getShaderDefines() const;
+
 protected:
-    Layer&          _layer;             /** Reference to layer */
-    DisplayRanges   _displayRanges;     /** Display ranges */
+    Layer&                                                              _layer;                      /** Reference to layer */
+    DisplayRanges                                                       _displayRanges;              /** Display ranges */
+    std::array<std::uint64_t, 3>                                        _channelGenerations;         /** Scalar data generation that is uploaded per channel (zero if none) */
+    std::array<bool, 3>                                                 _channelCompressions;        /** Whether the uploaded channel is block compressed */
+    std::array<QVector2D, 3>                                            _channelDenormalizations;    /** Per channel scale (x) and offset (y) that reconstruct the value from the texture sample */
+    std::array<bool, 3>                                                 _channelPresentations;       /** Whether each channel holds a frame that was not painted yet */
+    bool                                                                _tiled;                      /** Whether the image is streamed in tiles (too large for a single texture or for the memory budget) */
+    QSize                                                               _imageSize;                  /** Image size in pixels */
+    std::int32_t                                                        _selectionReduction;         /** Number of pixels per selection overlay texel along each axis (larger than one when a streamed image does not fit) */
+    std::array<QSharedPointer<const ImagePyramid>, numberOfPyramids>    _pyramids;                   /** Pyramids for the scalar channels and the mask */
+    std::array<std::uint32_t, numberOfPyramids>                         _pyramidGenerations;         /** Incremented for each pyramid build so that outdated builds are discarded */
+    TileCache                                                           _tileCache;                  /** Least-recently-used cache of tiles in the tiles texture */
+    std::vector<float>                                                  _tileData;                   /** Staging buffer for tile uploads */
+    bool                                                                _streaming;                  /** Whether channel uploads are streamed through the upload ring */
+    std::array<GLuint, numberOfStreamingSlots>                          _pixelUnpackBuffers;         /** Ring of pixel unpack buffers for streamed uploads */
+    std::array<GLsync, numberOfStreamingSlots>                          _uploadFences;               /** Fences that signal the GPU finished reading from each pixel unpack buffer */
+    std::int32_t                                                        _uploadIndex;                /** Pixel unpack buffer that was used last */
+    std::array<std::int32_t, 3>                                         _channelSlots;               /** Texture slot that holds each channel (-1: base channel texture) */
+    std::vector<bool>                                                   _residentDimensions;         /** Whether each dimension is uploaded to the resident dimensions texture array */
+    std::vector<QVector2D>                                              _residentDenormalizations;   /** Per dimension scale (x) and offset (y) that reconstruct the value from the texture sample */
+    std::vector<DisplayRange>                                           _residentRanges;             /** Per dimension scalar data range */
+    std::array<std::int32_t, 3>                                         _channelLayers;              /** Resident dimensions layer that each channel samples (-1: channel texture) */
+    QThreadPool                                                         _uploadThreadPool;           /** Worker threads that fill the staged pixel unpack buffers (waited for before the buffers are deleted) */
+    std::array<std::uint64_t, numberOfPyramids>                         _uploadRequests;             /** Latest upload request per target (three scalar channels and the mask) */
+    std::vector<PendingUpload>                                          _pendingUploads;             /** Uploads that are staged in mapped pixel unpack buffers */
+    std::vector<std::pair<GLuint, GLsync>>                              _retiredUploads;             /** Pixel unpack buffers that are deleted once their fence signals */
+    QString                                                             _vertexShaderSource;         /** Image vertex shader source code (specialized per shader program variant) */
+    QString                                                             _fragmentShaderSource;       /** Image fragment shader source code (specialized per shader program variant) */
+    bool                                                                _masked;                     /** Whether the mask excludes any pixel (unmasked variants skip sampling the mask) */
+    std::int32_t                                                        _colorSpaceLookupType;       /** Color space of the uploaded lookup table (-1: none) */
+    ColorMapAtlas::SliceHandle                                          _colorMapSlice;              /** Color map atlas slice that holds the color map */
+    InterpolationType                                                   _colorMapInterpolationType;  /** Color map interpolation type */
+    std::vector<std::uint32_t>                                          _labels;                     /** Label per pixel (for sample readout and pixel selection) */
+    std::vector<std::uint8_t>                                           _labelProperties;            /** Properties per label (mirrors the label properties buffer) */
+    std::vector<std::uint32_t>                                          _selectedLabels;             /** Labels that are flagged as selected */
+    bool                                                                _selectedLabelsOnly;         /** Whether labels that are not selected are hidden */
+    GLuint                                                              _labelPropertiesBuffer;      /** Buffer with the properties per label */
+    GLuint                                                              _labelPropertiesTexture;     /** Buffer texture through which the shader reads the label properties */
+    std::int32_t                                                        _numberOfLabels;             /** Number of labels in the label properties buffer */
 };
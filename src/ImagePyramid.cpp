@@ -0,0 +1,96 @@
+#include "ImagePyramid.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+ImagePyramid::ImagePyramid(const QVector<float>& scalarData, const QSize& size) :
+    _size(size),
+    _levels()
+{
+    if (static_cast<qsizetype>(size.width()) * size.height() != scalarData.size())
+        throw std::runtime_error("Scalar data size does not match the image size");
+
+    const auto numberOfLevels = getNumberOfLevels(size);
+
+    _levels.reserve(numberOfLevels);
+    _levels.append(scalarData);
+
+    // Down-sample each level with a 2x2 box filter (clamped at the odd edge)
+    for (std::int32_t level = 1; level < numberOfLevels; level++) {
+        const auto& source      = _levels.last();
+        const auto sourceSize   = getLevelSize(size, level - 1);
+        const auto targetSize   = getLevelSize(size, level);
+
+        QVector<float> target(static_cast<qsizetype>(targetSize.width()) * targetSize.height());
+
+        for (std::int32_t targetY = 0; targetY < targetSize.height(); targetY++) {
+            const auto sourceY0 = std::min(2 * targetY, sourceSize.height() - 1);
+            const auto sourceY1 = std::min(2 * targetY + 1, sourceSize.height() - 1);
+
+            const auto row0 = source.constData() + static_cast<qsizetype>(sourceY0) * sourceSize.width();
+            const auto row1 = source.constData() + static_cast<qsizetype>(sourceY1) * sourceSize.width();
+
+            auto targetRow = target.data() + static_cast<qsizetype>(targetY) * targetSize.width();
+
+            for (std::int32_t targetX = 0; targetX < targetSize.width(); targetX++) {
+                const auto sourceX0 = std::min(2 * targetX, sourceSize.width() - 1);
+                const auto sourceX1 = std::min(2 * targetX + 1, sourceSize.width() - 1);
+
+                targetRow[targetX] = 0.25f * (row0[sourceX0] + row0[sourceX1] + row1[sourceX0] + row1[sourceX1]);
+            }
+        }
+
+        _levels.append(target);
+    }
+}
+
+std::int32_t ImagePyramid::getNumberOfLevels(const QSize& size)
+{
+    std::int32_t numberOfLevels = 1;
+
+    // Add levels until the level fits in a single tile
+    while (std::max(getLevelSize(size, numberOfLevels - 1).width(), getLevelSize(size, numberOfLevels - 1).height()) > tileSize)
+        numberOfLevels++;
+
+    return numberOfLevels;
+}
+
+QSize ImagePyramid::getLevelSize(const QSize& size, std::int32_t level)
+{
+    const auto divisor = 1 << level;
+
+    return QSize(std::max(1, (size.width() + divisor - 1) / divisor), std::max(1, (size.height() + divisor - 1) / divisor));
+}
+
+QSize ImagePyramid::getNumberOfTiles(const QSize& size, std::int32_t level)
+{
+    const auto levelSize = getLevelSize(size, level);
+
+    return QSize((levelSize.width() + tileSize - 1) / tileSize, (levelSize.height() + tileSize - 1) / tileSize);
+}
+
+QRect ImagePyramid::getTileRectangle(const QSize& size, std::int32_t level, std::int32_t tileX, std::int32_t tileY)
+{
+    return QRect(tileX * tileSize, tileY * tileSize, tileSize, tileSize).intersected(QRect(QPoint(0, 0), getLevelSize(size, level)));
+}
+
+void ImagePyramid::copyTile(std::int32_t level, std::int32_t tileX, std::int32_t tileY, float* destination, std::int32_t numberOfComponents, std::int32_t component) const
+{
+    if (level < 0 || level >= getNumberOfLevels())
+        throw std::out_of_range("Invalid pyramid level");
+
+    const auto& source      = _levels[level];
+    const auto levelSize    = getLevelSize(_size, level);
+    const auto originX      = tileX * tileSize - tileBorder;
+    const auto originY      = tileY * tileSize - tileBorder;
+
+    for (std::int32_t texelY = 0; texelY < tileTexels; texelY++) {
+        const auto sourceY  = std::clamp(originY + texelY, 0, levelSize.height() - 1);
+        const auto row      = source.constData() + static_cast<qsizetype>(sourceY) * levelSize.width();
+
+        auto target = destination + static_cast<qsizetype>(texelY) * tileTexels * numberOfComponents + component;
+
+        for (std::int32_t texelX = 0; texelX < tileTexels; texelX++, target += numberOfComponents)
+            *target = row[std::clamp(originX + texelX, 0, levelSize.width() - 1)];
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <QRect>
+#include <QSize>
+#include <QVector>
+
+#include <cstdint>
+
+/**
+ * Image pyramid class
+ *
+ * Multi-resolution representation of a single scalar image plane, used for streaming large images in tiles
+ * Level zero shares the (implicitly shared) scalar data it is built from, every next level halves the
+ * resolution with a 2x2 box filter until the level fits in a single tile
+ */
+class ImagePyramid
+{
+public:
+
+    static constexpr std::int32_t tileSize      = 256;                      /** Number of pixels along each side of the tile content */
+    static constexpr std::int32_t tileBorder    = 1;                        /** Border (replicated from the neighbouring tiles) so that bilinear filtering is seamless */
+    static constexpr std::int32_t tileTexels    = tileSize + 2 * tileBorder;/** Number of texels along each side of a stored tile */
+
+public: // Construction
+
+    /**
+     * Construct pyramid from \p scalarData
+     * @param scalarData Scalar data in row-column order (shared with level zero)
+     * @param size Image size
+     */
+    ImagePyramid(const QVector<float>& scalarData, const QSize& size);
+
+public: // Levels and tiles
+
+    /**
+     * Get the number of pyramid levels for an image of \p size
+     * @param size Image size
+     * @return Number of levels
+     */
+    static std::int32_t getNumberOfLevels(const QSize& size);
+
+    /**
+     * Get the size of \p level for an image of \p size
+     * @param size Image size
+     * @param level Pyramid level
+     * @return Level size in pixels
+     */
+    static QSize getLevelSize(const QSize& size, std::int32_t level);
+
+    /**
+     * Get the number of tiles in x and y for \p level for an image of \p size
+     * @param size Image size
+     * @param level Pyramid level
+     * @return Tile grid size
+     */
+    static QSize getNumberOfTiles(const QSize& size, std::int32_t level);
+
+    /**
+     * Get the rectangle that tile (\p tileX, \p tileY) covers in \p level pixel coordinates
+     * @param size Image size
+     * @param level Pyramid level
+     * @param tileX Tile column
+     * @param tileY Tile row
+     * @return Tile content rectangle
+     */
+    static QRect getTileRectangle(const QSize& size, std::int32_t level, std::int32_t tileX, std::int32_t tileY);
+
+    /** Get the image size (level zero) */
+    QSize getSize() const { return _size; }
+
+    /** Get the number of levels */
+    std::int32_t getNumberOfLevels() const { return static_cast<std::int32_t>(_levels.size()); }
+
+    /**
+     * Copy tile (\p tileX, \p tileY) of \p level including its border into \p destination (edges are clamped)
+     * @param level Pyramid level
+     * @param tileX Tile column
+     * @param tileY Tile row
+     * @param destination Destination buffer of at least tileTexels x tileTexels x \p numberOfComponents floats
+     * @param numberOfComponents Number of interleaved components in the destination
+     * @param component Component to write
+     */
+    void copyTile(std::int32_t level, std::int32_t tileX, std::int32_t tileY, float* destination, std::int32_t numberOfComponents, std::int32_t component) const;
+
+private:
+    QSize                   _size;      /** Image size */
+    QVector<QVector<float>> _levels;    /** Scalar data per level (level zero shares the input data) */
+};
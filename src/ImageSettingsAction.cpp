@@ -17,6 +17,7 @@ ImageSettingsAction::ImageSettingsAction(QObject* parent, const QString& title)
     _opacityAction(this, "Opacity", 0.0f, 100.0f, 100.0f, 1),
     _subsampleFactorAction(this, "Subsample", 1, 8, 1),
     _colorSpaceAction(this, "Color space", colorSpaces.values(), "Mono"),
+    _colorConversionAction(this, "Color conversion", { "Analytic", "Lookup table" }, "Analytic"),
     _scalarChannel1Action(this, ScalarChannelAction::channelIndexes.value(ScalarChannelAction::Channel1)),
     _scalarChannel2Action(this, ScalarChannelAction::channelIndexes.value(ScalarChannelAction::Channel2)),
     _scalarChannel3Action(this, ScalarChannelAction::channelIndexes.value(ScalarChannelAction::Channel3)),
@@ -25,11 +26,18 @@ ImageSettingsAction::ImageSettingsAction(QObject* parent, const QString& title)
     _interpolationTypeAction(this, "Interpolate", interpolationTypes.values(), "Bilinear"),
     _useConstantColorAction(this, "Use constant color", false),
     _fixChannelRangesToColorSpaceAction(this, "Set channel ranges to color space", false),
-    _constantColorAction(this, "Constant color", QColor(Qt::white))
+    _compressChannelsAction(this, "Compress channels", false),
+    _dimensionCacheBudgetAction(this, "Dimension cache", 0, 16384, 512),
+    _residentDimensionsAction(this, "Resident dimensions", false),
+    _residentDimensionsStatusAction(this, "Resident VRAM"),
+    _playbackAction(this, "Playback"),
+    _constantColorAction(this, "Constant color", QColor(Qt::white)),
+    _selectedClustersOnlyAction(this, "Selected clusters only", false)
 {
     addAction(&_opacityAction);
     addAction(&_subsampleFactorAction);
     addAction(&_colorSpaceAction);
+    addAction(&_colorConversionAction);
     addAction(&_scalarChannel1Action);
     addAction(&_scalarChannel2Action);
     addAction(&_scalarChannel3Action);
@@ -38,24 +46,41 @@ ImageSettingsAction::ImageSettingsAction(QObject* parent, const QString& title)
     addAction(&_interpolationTypeAction);
     addAction(&_useConstantColorAction);
     addAction(&_fixChannelRangesToColorSpaceAction);
+    addAction(&_compressChannelsAction);
+    addAction(&_dimensionCacheBudgetAction);
+    addAction(&_residentDimensionsAction);
+    addAction(&_residentDimensionsStatusAction);
+    addAction(&_playbackAction);
     addAction(&_constantColorAction);
+    addAction(&_selectedClustersOnlyAction);
 
     _subsampleFactorAction.setVisible(false);
 
+    _residentDimensionsStatusAction.setEnabled(false);
+    _residentDimensionsStatusAction.setConnectionPermissionsToForceNone();
+
     _opacityAction.setToolTip("Image layer opacity");
     _subsampleFactorAction.setToolTip("Subsampling factor");
     _scalarChannel1Action.setToolTip("Scalar channel 1");
     _scalarChannel2Action.setToolTip("Scalar channel 2");
     _scalarChannel3Action.setToolTip("Scalar channel 3");
     _colorSpaceAction.setToolTip("The color space used to shade the image");
+    _colorConversionAction.setToolTip("How HSL and LAB channels are converted to RGB: analytic (exact) or with a precomputed lookup table (faster, eight bit precision)");
     _colorMap1DAction.setToolTip("Image one-dimensional color map");
     _colorMap2DAction.setToolTip("Image two-dimensional color map");
     _interpolationTypeAction.setToolTip("The type of two-dimensional image interpolation used");
     _useConstantColorAction.setToolTip("Use constant color to shade the image");
     _fixChannelRangesToColorSpaceAction.setToolTip("In this mode, data ranges are ignored and the channel ranges are set to the current color space range (RGB, HSL or LAB)");
+    _compressChannelsAction.setToolTip("Store the channels block compressed on the GPU (BC4), this reduces GPU memory at the cost of precision (lossy, eight bits at most), channels with eight bit integral data are stored exactly instead");
+    _dimensionCacheBudgetAction.setToolTip("Memory budget for previously extracted dimension images, switching back to a cached dimension is instant");
+    _residentDimensionsAction.setToolTip("Upload all dimensions to the GPU once (sixteen bits per pixel), switching the dimension of a channel is then instant\nFalls back to on-demand uploads when the dimensions exceed the GPU memory budget");
+    _residentDimensionsStatusAction.setToolTip("GPU memory required to keep all dimensions resident");
+    _playbackAction.setToolTip("Play a channel through a range of dimensions (e.g. time points or wavelengths)");
     _constantColorAction.setToolTip("Constant color");
+    _selectedClustersOnlyAction.setToolTip("Only show the selected clusters");
 
     _opacityAction.setSuffix("%");
+    _dimensionCacheBudgetAction.setSuffix(" MB");
 
     _colorMap1DAction.getRangeAction(ColorMapAction::Axis::X).setEnabled(false);
     _colorMap1DAction.getRangeAction(ColorMapAction::Axis::Y).setEnabled(false);
@@ -114,10 +139,10 @@ ImageSettingsAction::ImageSettingsAction(QObject* parent, const QString& title)
             _scalarChannel3Action.setColorSpaceRange(false);
         }
 
-        // update channels
-        emit channelChanged(_scalarChannel1Action);
-        emit channelChanged(_scalarChannel2Action);
-        emit channelChanged(_scalarChannel3Action);
+        // update channel display ranges
+        emit channelDisplayRangeChanged(_scalarChannel1Action);
+        emit channelDisplayRangeChanged(_scalarChannel2Action);
+        emit channelDisplayRangeChanged(_scalarChannel3Action);
 
     });
 
@@ -132,6 +157,18 @@ ImageSettingsAction::ImageSettingsAction(QObject* parent, const QString& title)
     connect(&_scalarChannel3Action, &ScalarChannelAction::changed, this, [this]() {
         emit channelChanged(_scalarChannel3Action);
     });
+
+    connect(&_scalarChannel1Action, &ScalarChannelAction::displayRangeChanged, this, [this]() {
+        emit channelDisplayRangeChanged(_scalarChannel1Action);
+    });
+
+    connect(&_scalarChannel2Action, &ScalarChannelAction::displayRangeChanged, this, [this]() {
+        emit channelDisplayRangeChanged(_scalarChannel2Action);
+    });
+
+    connect(&_scalarChannel3Action, &ScalarChannelAction::displayRangeChanged, this, [this]() {
+        emit channelDisplayRangeChanged(_scalarChannel3Action);
+    });
 }
 
 void ImageSettingsAction::initialize(Layer* layer)
@@ -147,6 +184,8 @@ void ImageSettingsAction::initialize(Layer* layer)
     _scalarChannel2Action.initialize(_layer, ScalarChannelAction::Channel2);
     _scalarChannel3Action.initialize(_layer, ScalarChannelAction::Channel3);
 
+    _playbackAction.initialize(_layer);
+
     updateColorMapImage();
 
     const auto isClusterType    = _layer->getSourceDataset()->getDataType() == ClusterType;
@@ -157,6 +196,8 @@ void ImageSettingsAction::initialize(Layer* layer)
     connect(&_subsampleFactorAction, &IntegralAction::valueChanged, _layer, &Layer::invalidate);
     connect(&_interpolationTypeAction, &OptionAction::currentIndexChanged, _layer, &Layer::invalidate);
     connect(&_constantColorAction, &ColorAction::colorChanged, _layer, &Layer::invalidate);
+    connect(&_colorConversionAction, &OptionAction::currentIndexChanged, _layer, &Layer::invalidate);
+    connect(&_selectedClustersOnlyAction, &ToggleAction::toggled, _layer, &Layer::setSelectedLabelsOnly);
 
     //connect(&_colorSpaceAction, &OptionAction::currentIndexChanged, _layer, &Layer::invalidate);
     //connect(&_colorSpaceAction, &OptionAction::currentIndexChanged, this, &ImageSettingsAction::updateColorMapImage);
@@ -185,11 +226,21 @@ void ImageSettingsAction::initialize(Layer* layer)
 
         _useConstantColorAction.setEnabled(false);
 
+        // Cluster labels have to be stored exactly
+        _compressChannelsAction.setChecked(false);
+        _compressChannelsAction.setEnabled(false);
+
+        // There is only one dimension (cluster index)
+        _residentDimensionsAction.setChecked(false);
+        _residentDimensionsAction.setEnabled(false);
+
         _scalarChannel1Action.getWindowLevelAction().setEnabled(false);
         _scalarChannel2Action.getWindowLevelAction().setEnabled(false);
         _scalarChannel3Action.getWindowLevelAction().setEnabled(false);
     }
     else {
+        _selectedClustersOnlyAction.setEnabled(false);
+
         if (_layer->getNumberOfImages() >= 2) {
             _scalarChannel2Action.getDimensionAction().setCurrentIndex(1);
         }
@@ -204,6 +255,17 @@ void ImageSettingsAction::initialize(Layer* layer)
     //connect(&_colorMapAction.getDiscretizeAction(), &ToggleAction::toggled, this, &ImageSettingsAction::updateColorMapImage);
 
     const auto updateScalarChannels = [this]() {
+
+        // Cached dimension images are out of date
+        _layer->getDimensionCache().remove(_layer->getImagesDatasetId());
+
+        // Resident dimensions are out of date as well
+        _layer->updateResidentDimensions();
+
+        _scalarChannel1Action.invalidateScalarData();
+        _scalarChannel2Action.invalidateScalarData();
+        _scalarChannel3Action.invalidateScalarData();
+
         _scalarChannel1Action.computeScalarData();
         _scalarChannel2Action.computeScalarData();
         _scalarChannel3Action.computeScalarData();
@@ -276,39 +338,43 @@ const std::uint32_t ImageSettingsAction::getNumberOfActiveScalarChannels() const
 
 QImage ImageSettingsAction::getColorMapImage() const
 {
-    if (_layer->getSourceDataset()->getDataType() == ClusterType) {
-        const auto& clusters = Dataset<Clusters>(_layer->getSourceDataset())->getClusters();
+    switch (_colorSpaceAction.getCurrentIndex())
+    {
+        case 0:
+            return _colorMap1DAction.getColorMapImage();
+
+        case 1:
+            return _colorMap2DAction.getColorMapImage();
 
-        QImage discreteColorMapImage(static_cast<std::int32_t>(clusters.size()), 1, QImage::Format::Format_RGB32);
+        default:
+            break;
+    }
 
-        auto clusterIndex = 0;
+    return {};
+}
 
-        for (const auto& cluster : clusters) {
-            discreteColorMapImage.setPixelColor(clusterIndex, 0, cluster.getColor());
-            clusterIndex++;
-        }
+QVector<QColor> ImageSettingsAction::getLabelColors() const
+{
+    const auto& clusters = Dataset<Clusters>(_layer->getSourceDataset())->getClusters();
 
-        return discreteColorMapImage.convertToFormat(QImage::Format_RGB32);
-    }
-    else {
-        switch (_colorSpaceAction.getCurrentIndex())
-        {
-            case 0:
-                return _colorMap1DAction.getColorMapImage();
+    QVector<QColor> labelColors;
 
-            case 1:
-                return _colorMap2DAction.getColorMapImage();
+    labelColors.reserve(static_cast<qsizetype>(clusters.size()));
 
-            default:
-                break;
-        }
-    }
+    for (const auto& cluster : clusters)
+        labelColors << cluster.getColor();
 
-    return {};
+    return labelColors;
 }
 
 void ImageSettingsAction::updateColorMapImage()
 {
+    // Clusters are colored per cluster index
+    if (_layer->getSourceDataset()->getDataType() == ClusterType) {
+        _layer->setLabelColors(getLabelColors());
+        return;
+    }
+
     auto interpolationType = InterpolationType::Bilinear;
 
     switch (_colorSpaceAction.getCurrentIndex())
@@ -349,6 +415,8 @@ void ImageSettingsAction::colorSpaceChanged()
             _fixChannelRangesToColorSpaceAction.setChecked(false);
             _fixChannelRangesToColorSpaceAction.setEnabled(false);
 
+            _colorConversionAction.setEnabled(false);
+
             break;
         }
 
@@ -368,6 +436,8 @@ void ImageSettingsAction::colorSpaceChanged()
             _fixChannelRangesToColorSpaceAction.setChecked(false);
             _fixChannelRangesToColorSpaceAction.setEnabled(false);
 
+            _colorConversionAction.setEnabled(false);
+
             break;
         }
 
@@ -386,6 +456,8 @@ void ImageSettingsAction::colorSpaceChanged()
 
             _fixChannelRangesToColorSpaceAction.setEnabled(true);
 
+            _colorConversionAction.setEnabled(false);
+
             break;
         }
 
@@ -404,6 +476,8 @@ void ImageSettingsAction::colorSpaceChanged()
 
             _fixChannelRangesToColorSpaceAction.setEnabled(true);
 
+            _colorConversionAction.setEnabled(true);
+
             break;
         }
 
@@ -422,6 +496,8 @@ void ImageSettingsAction::colorSpaceChanged()
 
             _fixChannelRangesToColorSpaceAction.setEnabled(true);
 
+            _colorConversionAction.setEnabled(true);
+
             break;
         }
 
@@ -451,6 +527,7 @@ void ImageSettingsAction::connectToPublicAction(WidgetAction* publicAction, bool
         actions().connectPrivateActionToPublicAction(&_opacityAction, &publicImageSettingsAction->getOpacityAction(), recursive);
         actions().connectPrivateActionToPublicAction(&_subsampleFactorAction, &publicImageSettingsAction->getSubsampleFactorAction(), recursive);
         actions().connectPrivateActionToPublicAction(&_colorSpaceAction, &publicImageSettingsAction->getColorSpaceAction(), recursive);
+        actions().connectPrivateActionToPublicAction(&_colorConversionAction, &publicImageSettingsAction->getColorConversionAction(), recursive);
         actions().connectPrivateActionToPublicAction(&_scalarChannel1Action, &publicImageSettingsAction->getScalarChannel1Action(), recursive);
         actions().connectPrivateActionToPublicAction(&_scalarChannel2Action, &publicImageSettingsAction->getScalarChannel2Action(), recursive);
         actions().connectPrivateActionToPublicAction(&_scalarChannel3Action, &publicImageSettingsAction->getScalarChannel3Action(), recursive);
@@ -458,7 +535,12 @@ void ImageSettingsAction::connectToPublicAction(WidgetAction* publicAction, bool
         actions().connectPrivateActionToPublicAction(&_colorMap2DAction, &publicImageSettingsAction->getColorMap2DAction(), recursive);
         actions().connectPrivateActionToPublicAction(&_interpolationTypeAction, &publicImageSettingsAction->getInterpolationTypeAction(), recursive);
         actions().connectPrivateActionToPublicAction(&_useConstantColorAction, &publicImageSettingsAction->getUseConstantColorAction(), recursive);
+        actions().connectPrivateActionToPublicAction(&_compressChannelsAction, &publicImageSettingsAction->getCompressChannelsAction(), recursive);
+        actions().connectPrivateActionToPublicAction(&_dimensionCacheBudgetAction, &publicImageSettingsAction->getDimensionCacheBudgetAction(), recursive);
+        actions().connectPrivateActionToPublicAction(&_residentDimensionsAction, &publicImageSettingsAction->getResidentDimensionsAction(), recursive);
+        actions().connectPrivateActionToPublicAction(&_playbackAction, &publicImageSettingsAction->getPlaybackAction(), recursive);
         actions().connectPrivateActionToPublicAction(&_constantColorAction, &publicImageSettingsAction->getConstantColorAction(), recursive);
+        actions().connectPrivateActionToPublicAction(&_selectedClustersOnlyAction, &publicImageSettingsAction->getSelectedClustersOnlyAction(), recursive);
     }
 
     GroupAction::connectToPublicAction(publicAction, recursive);
@@ -473,6 +555,7 @@ void ImageSettingsAction::disconnectFromPublicAction(bool recursive)
         actions().disconnectPrivateActionFromPublicAction(&_opacityAction, recursive);
         actions().disconnectPrivateActionFromPublicAction(&_subsampleFactorAction, recursive);
         actions().disconnectPrivateActionFromPublicAction(&_colorSpaceAction, recursive);
+        actions().disconnectPrivateActionFromPublicAction(&_colorConversionAction, recursive);
         actions().disconnectPrivateActionFromPublicAction(&_scalarChannel1Action, recursive);
         actions().disconnectPrivateActionFromPublicAction(&_scalarChannel2Action, recursive);
         actions().disconnectPrivateActionFromPublicAction(&_scalarChannel3Action, recursive);
@@ -480,7 +563,12 @@ void ImageSettingsAction::disconnectFromPublicAction(bool recursive)
         actions().disconnectPrivateActionFromPublicAction(&_colorMap2DAction, recursive);
         actions().disconnectPrivateActionFromPublicAction(&_interpolationTypeAction, recursive);
         actions().disconnectPrivateActionFromPublicAction(&_useConstantColorAction, recursive);
+        actions().disconnectPrivateActionFromPublicAction(&_compressChannelsAction, recursive);
+        actions().disconnectPrivateActionFromPublicAction(&_dimensionCacheBudgetAction, recursive);
+        actions().disconnectPrivateActionFromPublicAction(&_residentDimensionsAction, recursive);
+        actions().disconnectPrivateActionFromPublicAction(&_playbackAction, recursive);
         actions().disconnectPrivateActionFromPublicAction(&_constantColorAction, recursive);
+        actions().disconnectPrivateActionFromPublicAction(&_selectedClustersOnlyAction, recursive);
     }
 
     GroupAction::disconnectFromPublicAction(recursive);
@@ -493,6 +581,7 @@ void ImageSettingsAction::fromVariantMap(const QVariantMap& variantMap)
     _opacityAction.fromParentVariantMap(variantMap);
     _subsampleFactorAction.fromParentVariantMap(variantMap);
     _colorSpaceAction.fromParentVariantMap(variantMap);
+    _colorConversionAction.fromParentVariantMap(variantMap);
     _scalarChannel1Action.fromParentVariantMap(variantMap);
     _scalarChannel2Action.fromParentVariantMap(variantMap);
     _scalarChannel3Action.fromParentVariantMap(variantMap);
@@ -500,7 +589,12 @@ void ImageSettingsAction::fromVariantMap(const QVariantMap& variantMap)
     _colorMap2DAction.fromParentVariantMap(variantMap);
     _interpolationTypeAction.fromParentVariantMap(variantMap);
     _useConstantColorAction.fromParentVariantMap(variantMap);
+    _compressChannelsAction.fromParentVariantMap(variantMap);
+    _dimensionCacheBudgetAction.fromParentVariantMap(variantMap);
+    _residentDimensionsAction.fromParentVariantMap(variantMap);
+    _playbackAction.fromParentVariantMap(variantMap);
     _constantColorAction.fromParentVariantMap(variantMap);
+    _selectedClustersOnlyAction.fromParentVariantMap(variantMap);
 }
 
 QVariantMap ImageSettingsAction::toVariantMap() const
@@ -510,6 +604,7 @@ QVariantMap ImageSettingsAction::toVariantMap() const
     _opacityAction.insertIntoVariantMap(variantMap);
     _subsampleFactorAction.insertIntoVariantMap(variantMap);
     _colorSpaceAction.insertIntoVariantMap(variantMap);
+    _colorConversionAction.insertIntoVariantMap(variantMap);
     _scalarChannel1Action.insertIntoVariantMap(variantMap);
     _scalarChannel2Action.insertIntoVariantMap(variantMap);
     _scalarChannel3Action.insertIntoVariantMap(variantMap);
@@ -517,7 +612,12 @@ QVariantMap ImageSettingsAction::toVariantMap() const
     _colorMap2DAction.insertIntoVariantMap(variantMap);
     _interpolationTypeAction.insertIntoVariantMap(variantMap);
     _useConstantColorAction.insertIntoVariantMap(variantMap);
+    _compressChannelsAction.insertIntoVariantMap(variantMap);
+    _dimensionCacheBudgetAction.insertIntoVariantMap(variantMap);
+    _residentDimensionsAction.insertIntoVariantMap(variantMap);
+    _playbackAction.insertIntoVariantMap(variantMap);
     _constantColorAction.insertIntoVariantMap(variantMap);
+    _selectedClustersOnlyAction.insertIntoVariantMap(variantMap);
 
     return variantMap;
 }
@@ -6,9 +6,12 @@
 #include <actions/ColorMap2DAction.h>
 #include <actions/ToggleAction.h>
 #include <actions/ColorAction.h>
+#include <actions/StringAction.h>
 
 #include "ScalarChannelAction.h"
+#include "PlaybackAction.h"
 
+#include <QColor>
 #include <QTimer>
 
 class Layer;
@@ -49,6 +52,9 @@ protected: // Color map
     /** Get color map image */
     QImage getColorMapImage() const;
 
+    /** Get the colors of the clusters by cluster index (label) */
+    QVector<QColor> getLabelColors() const;
+
     /** Update the color map image and notify others */
     void updateColorMapImage();
 
@@ -91,6 +97,7 @@ public: // Action getters
     DecimalAction& getOpacityAction() { return _opacityAction; }
     IntegralAction& getSubsampleFactorAction() { return _subsampleFactorAction; }
     OptionAction& getColorSpaceAction() { return _colorSpaceAction; }
+    OptionAction& getColorConversionAction() { return _colorConversionAction; }
     ScalarChannelAction& getScalarChannel1Action() { return _scalarChannel1Action; }
     ScalarChannelAction& getScalarChannel2Action() { return _scalarChannel2Action; }
     ScalarChannelAction& getScalarChannel3Action() { return _scalarChannel3Action; }
@@ -99,7 +106,13 @@ public: // Action getters
     OptionAction& getInterpolationTypeAction() { return _interpolationTypeAction; }
     ToggleAction& getUseConstantColorAction() { return _useConstantColorAction; }
     ToggleAction& getFixChannelRangesToColorSpaceAction() { return _fixChannelRangesToColorSpaceAction; }
+    ToggleAction& getCompressChannelsAction() { return _compressChannelsAction; }
+    IntegralAction& getDimensionCacheBudgetAction() { return _dimensionCacheBudgetAction; }
+    ToggleAction& getResidentDimensionsAction() { return _residentDimensionsAction; }
+    StringAction& getResidentDimensionsStatusAction() { return _residentDimensionsStatusAction; }
+    PlaybackAction& getPlaybackAction() { return _playbackAction; }
     ColorAction& getConstantColorAction() { return _constantColorAction; }
+    ToggleAction& getSelectedClustersOnlyAction() { return _selectedClustersOnlyAction; }
 
 signals:
 
@@ -112,11 +125,18 @@ signals:
      */
     void channelChanged(ScalarChannelAction& scalarChannelAction);
 
+    /**
+     * Signals the display range of the scalar channel changed (without a change in scalar data)
+     * @param scalarChannelAction Reference to scalar channel action of which the display range changed
+     */
+    void channelDisplayRangeChanged(ScalarChannelAction& scalarChannelAction);
+
 protected:
     Layer*                  _layer;                                 /** Reference to layer */
     DecimalAction           _opacityAction;                         /** Opacity action */
     IntegralAction          _subsampleFactorAction;                 /** Subsample factor action */
     OptionAction            _colorSpaceAction;                      /** Color space action */
+    OptionAction            _colorConversionAction;                 /** HSL and LAB conversion accuracy (analytic or lookup table) action */
     ScalarChannelAction     _scalarChannel1Action;                  /** Scalar channel 1 action */
     ScalarChannelAction     _scalarChannel2Action;                  /** Scalar channel 2 action */
     ScalarChannelAction     _scalarChannel3Action;                  /** Scalar channel 3 action */
@@ -125,7 +145,13 @@ protected:
     OptionAction            _interpolationTypeAction;               /** Interpolation type action */
     ToggleAction            _useConstantColorAction;                /** Constant color action */
     ToggleAction            _fixChannelRangesToColorSpaceAction;    /** Fixes ranges of channels to color space ranges action */
+    ToggleAction            _compressChannelsAction;                /** Lossy block compression of the channel textures action */
+    IntegralAction          _dimensionCacheBudgetAction;            /** Memory budget of the dimension cache in megabytes action */
+    ToggleAction            _residentDimensionsAction;              /** Keep all dimensions resident on the GPU action */
+    StringAction            _residentDimensionsStatusAction;        /** GPU memory cost and status of the resident dimensions action (read-only) */
+    PlaybackAction          _playbackAction;                        /** Cine playback through dimensions action */
     ColorAction             _constantColorAction;                   /** Color action */
+    ToggleAction            _selectedClustersOnlyAction;            /** Hide clusters that are not selected action (clusters data only) */
     QTimer                  _updateSelectionTimer;                  /** Timer to update layer selection when appropriate */
     QTimer                  _updateScalarDataTimer;                 /** Timer to update layer scalar data when appropriate */
 
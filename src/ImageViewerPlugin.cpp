@@ -318,7 +318,7 @@ void ImageViewerPlugin::arrangeLayers(LayersLayout layersLayout)
     }
 
     getImageViewerWidget().getRenderer().setZoomRectangle(getImageViewerWidget().getWorldBoundingRectangle());
-    getImageViewerWidget().update();
+    getImageViewerWidget().getRenderer().render();
 }
 
 void ImageViewerPlugin::addDataset(const Dataset<Images>& dataset)
@@ -332,7 +332,7 @@ void ImageViewerPlugin::addDataset(const Dataset<Images>& dataset)
 
     _layersModel->addLayer(layer);
 
-    getImageViewerWidget().update();
+    getImageViewerWidget().getRenderer().render();
 }
 
 void ImageViewerPlugin::onLayerSelectionChanged()
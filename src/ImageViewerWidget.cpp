@@ -77,7 +77,7 @@ ImageViewerWidget::ImageViewerWidget(ImageViewerPlugin& imageViewerPlugin) :
 
     QObject::connect(&_pixelSelectionTool, &PixelSelectionTool::shapeChanged, [this]() {
         if (isInitialized())
-            update();
+            _renderer.requestFrame(LayersRenderer::Overlays);
     });
 }
 
@@ -127,7 +127,7 @@ bool ImageViewerWidget::eventFilter(QObject* target, QEvent* event)
                     _pixelSelectionTool.setEnabled(false);
 
                     // Re-render because the pixel selection tool pixmaps have changed
-                    update();
+                    _renderer.requestFrame(LayersRenderer::Overlays);
                 }
             }
 
@@ -315,9 +315,8 @@ bool ImageViewerWidget::eventFilter(QObject* target, QEvent* event)
                         const auto currentMousePosition     = _mousePositions[numberOfMousePositions - 1];
                         const auto panVector                = currentMousePosition - previousMousePosition;
 
-                        // Pan the view and render
+                        // Pan the view (requests a frame)
                         _renderer.panBy(QPoint(-panVector.x(), -panVector.y()));
-                        _renderer.render();
                     }
 
                     // Notify others that the viewport changed
@@ -419,7 +418,7 @@ bool ImageViewerWidget::eventFilter(QObject* target, QEvent* event)
                         _renderer.zoomAround(zoomCenter, 1.0f + _renderer.getZoomSensitivity());
                     }
 
-                    // Notify others that navigation has started, the viewport changed and navigation ended
+                    // Notify others that navigation has started, the viewport changed and navigation ended (zooming requested a frame already)
                     emit navigationStarted();
                     emit viewportChanged();
                     emit navigationEnded();
@@ -429,13 +428,15 @@ bool ImageViewerWidget::eventFilter(QObject* target, QEvent* event)
 
                 case None:
                 case Selection:
+                {
+                    _renderer.render();
+
                     break;
+                }
             }
 
             notifyMousePositionsChanged();
 
-            _renderer.render();
-
             break;
         }
 
@@ -551,11 +552,18 @@ void ImageViewerWidget::initializeGL()
         qDebug() << "Destroying image viewer widget context";
 #endif
 
+        // Stop the loader before the context it shares its objects with goes away
+        _renderer.getLoader().destroy();
+        _renderer.destroy();
+
         _openGLInitialized = false;
 	});
 
     _openGLInitialized = true;
 
+    // Compile shader programs of new layers in the background
+    _renderer.getLoader().initialize(context());
+
 #ifdef _DEBUG
     _openglDebugLogger->initialize();
 #endif
@@ -571,6 +579,9 @@ void ImageViewerWidget::resizeGL(int width, int height)
 
 void ImageViewerWidget::paintGL()
 {
+    // Take the dirty subsystems of this frame, requests made while painting go to the next frame
+    _renderer.beginFrame();
+
     try {
         QPainter painter;
 
@@ -594,13 +605,10 @@ void ImageViewerWidget::paintGL()
         // Draw the image layers
         for (auto& layer : layersSorted) {
                 
-            // Draw layer with OpenGL
+            // Draw layer with OpenGL (re-renders the layer only when it changed, composites its cached rendering otherwise)
             painter.beginNativePainting();
             {
-                glEnable(GL_BLEND);
-                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-                layer->render(_renderer.getProjectionMatrix() * _renderer.getViewMatrix());
+                layer->composite(_renderer.getProjectionMatrix() * _renderer.getViewMatrix());
             }
             painter.endNativePainting();
 
@@ -640,12 +648,8 @@ void ImageViewerWidget::paintGL()
             painter.drawPixmap(rect(), _pixelSelectionTool.getShapePixmap());
         }
 
-        // Show cluster name when in sample selection mode
-        if (_interactionMode == Selection) {
-
-            // Only deal with sample selection type
-            if (_pixelSelectionTool.getType() != PixelSelectionType::Sample)
-                return;
+        // Show cluster name when in sample selection mode (only deal with sample selection type)
+        if (_interactionMode == Selection && _pixelSelectionTool.getType() == PixelSelectionType::Sample) {
 
             // Get layer beneath cursor (if any)
             auto layer = getLayerBeneathCursor();
@@ -666,6 +670,9 @@ void ImageViewerWidget::paintGL()
         exceptionMessageBox("Rendering failed");
     }
 
+    // Schedule the frames that were requested while painting and resume the idle tasks
+    _renderer.frameRendered();
+
 #ifdef _DEBUG
     for (const QOpenGLDebugMessage& message : _openglDebugLogger->loggedMessages())
         switch (message.severity())
@@ -725,7 +732,7 @@ void ImageViewerWidget::setInteractionMode(const InteractionMode& interactionMod
     setCursor(_interactionMode == Selection ? Qt::ArrowCursor : Qt::OpenHandCursor);
 
     // Render
-    update();
+    _renderer.requestFrame(LayersRenderer::Overlays);
 
     // Notify others that the interaction mode changed
     emit interactionModeChanged(_interactionMode);
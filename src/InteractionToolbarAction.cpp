@@ -140,24 +140,24 @@ void InteractionToolbarAction::initialize(ImageViewerPlugin* imageViewerPlugin)
 
     connect(&_zoomOutAction, &TriggerAction::triggered, this, [this]() {
         getImageViewerWidget().getRenderer().setZoomPercentage(getImageViewerWidget().getRenderer().getZoomPercentage() - zoomDeltaPercentage);
-        getImageViewerWidget().update();
+        getImageViewerWidget().getRenderer().render();
     });
 
     connect(&_zoomPercentageAction, &DecimalAction::valueChanged, this, [this](const float& value) {
         getImageViewerWidget().getRenderer().setZoomPercentage(0.01f * value);
-        getImageViewerWidget().update();
+        getImageViewerWidget().getRenderer().render();
     });
 
     connect(&_zoomInAction, &TriggerAction::triggered, this, [this]() {
         getImageViewerWidget().getRenderer().setZoomPercentage(getImageViewerWidget().getRenderer().getZoomPercentage() + zoomDeltaPercentage);
-        getImageViewerWidget().update();
+        getImageViewerWidget().getRenderer().render();
     });
 
     connect(&_zoomExtentsAction, &TriggerAction::triggered, this, [this, triggerUpdateZoomPercentageAfterAnimation]() {
         const auto worldBoundingRectangle = getImageViewerWidget().getWorldBoundingRectangle();
 
         getImageViewerWidget().getRenderer().setZoomRectangle(worldBoundingRectangle);
-        getImageViewerWidget().update();
+        getImageViewerWidget().getRenderer().render();
 
         triggerUpdateZoomPercentageAfterAnimation();
     });
@@ -0,0 +1,89 @@
+#include "LabelIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+LabelIndex::LabelIndex() :
+    _offsets(),
+    _runs(),
+    _bounds()
+{
+}
+
+void LabelIndex::build(const std::vector<std::uint32_t>& labels, std::int32_t width, std::uint32_t numberOfLabels)
+{
+    clear();
+
+    if (width <= 0)
+        return;
+
+    const auto numberOfPixels = labels.size();
+
+    // Invokes callback(label, pixelIndex, length) for every run in raster order
+    const auto forEachRun = [&labels, numberOfPixels, width, numberOfLabels](auto callback) -> void {
+        for (std::size_t rowStart = 0; rowStart < numberOfPixels; rowStart += static_cast<std::size_t>(width)) {
+            const auto rowEnd = std::min(rowStart + static_cast<std::size_t>(width), numberOfPixels);
+
+            for (auto pixelIndex = rowStart; pixelIndex < rowEnd;) {
+                const auto label    = labels[pixelIndex];
+                auto runEnd         = pixelIndex + 1;
+
+                while (runEnd < rowEnd && labels[runEnd] == label)
+                    runEnd++;
+
+                if (label < numberOfLabels)
+                    callback(label, pixelIndex, runEnd - pixelIndex);
+
+                pixelIndex = runEnd;
+            }
+        }
+    };
+
+    // Count the runs per label (shifted by one so that the prefix sum yields the offsets)
+    _offsets.assign(static_cast<std::size_t>(numberOfLabels) + 1, 0);
+    _bounds.assign(numberOfLabels, QRect());
+
+    forEachRun([this](std::uint32_t label, std::size_t, std::size_t) -> void {
+        _offsets[label + 1]++;
+    });
+
+    for (std::size_t label = 0; label < numberOfLabels; label++)
+        _offsets[label + 1] += _offsets[label];
+
+    _runs.resize(_offsets.back());
+
+    // Fill the runs, the cursor per label starts at its offset
+    auto cursors = std::vector<std::size_t>(_offsets.begin(), _offsets.end() - 1);
+
+    forEachRun([this, &cursors, width](std::uint32_t label, std::size_t pixelIndex, std::size_t length) -> void {
+        _runs[cursors[label]++] = Run{ static_cast<std::uint32_t>(pixelIndex), static_cast<std::uint32_t>(length) };
+
+        const auto x = static_cast<std::int32_t>(pixelIndex % width);
+        const auto y = static_cast<std::int32_t>(pixelIndex / width);
+
+        _bounds[label] = _bounds[label].united(QRect(QPoint(x, y), QPoint(x + static_cast<std::int32_t>(length) - 1, y)));
+    });
+}
+
+void LabelIndex::clear()
+{
+    _offsets.clear();
+    _runs.clear();
+    _bounds.clear();
+}
+
+std::uint32_t LabelIndex::toLabel(float scalar)
+{
+    return std::isfinite(scalar) && scalar >= 0.0f ? static_cast<std::uint32_t>(std::lround(scalar)) : invalidLabel;
+}
+
+QRect LabelIndex::getBoundingRectangle(const std::vector<std::uint32_t>& labels) const
+{
+    QRect boundingRectangle;
+
+    for (const auto& label : labels)
+        if (label < _bounds.size())
+            boundingRectangle = boundingRectangle.united(_bounds[label]);
+
+    return boundingRectangle;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <QRect>
+
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+/**
+ * Label index class
+ *
+ * Inverted index from label (cluster index) to the runs of consecutive pixels with that label
+ * Runs do not cross image rows, they are stored per label in raster order (compressed sparse row layout)
+ *
+ * Selecting labels then costs O(pixels of the selected labels) instead of a pass over the image
+ */
+class LabelIndex
+{
+public:
+
+    /** Label of pixels without a (valid) label */
+    static constexpr std::uint32_t invalidLabel = std::numeric_limits<std::uint32_t>::max();
+
+    /** Run of consecutive pixels in an image row */
+    struct Run {
+        std::uint32_t   _pixelIndex;    /** Index of the first pixel */
+        std::uint32_t   _length;        /** Number of pixels */
+    };
+
+public: // Construction
+
+    /** Default constructor */
+    LabelIndex();
+
+    /**
+     * Build the index from \p labels
+     * @param labels Label per pixel
+     * @param width Image width in pixels
+     * @param numberOfLabels Number of labels (pixels with a label beyond it are not indexed)
+     */
+    void build(const std::vector<std::uint32_t>& labels, std::int32_t width, std::uint32_t numberOfLabels);
+
+    /** Clear the index */
+    void clear();
+
+    /**
+     * Convert a cluster index scalar to a label
+     * @param scalar Cluster index scalar
+     * @return Label (invalid label for negative or non-finite scalars)
+     */
+    static std::uint32_t toLabel(float scalar);
+
+public: // Queries
+
+    /** Get whether the index was built */
+    bool isValid() const { return !_offsets.empty(); }
+
+    /** Get the number of labels */
+    std::uint32_t getNumberOfLabels() const { return _offsets.empty() ? 0 : static_cast<std::uint32_t>(_offsets.size() - 1); }
+
+    /**
+     * Get the bounding rectangle of the pixels with any of \p labels
+     * @param labels Labels
+     * @return Bounding rectangle in image coordinates (invalid when none of the labels occurs)
+     */
+    QRect getBoundingRectangle(const std::vector<std::uint32_t>& labels) const;
+
+    /**
+     * Invoke \p callback for every pixel with any of \p labels (out-of-range labels are ignored)
+     * @param labels Labels
+     * @param callback Callable with signature void(std::uint32_t pixelIndex)
+     */
+    template<typename Callback>
+    void forEachPixel(const std::vector<std::uint32_t>& labels, Callback callback) const
+    {
+        for (const auto& label : labels) {
+            if (label >= getNumberOfLabels())
+                continue;
+
+            for (auto runIndex = _offsets[label]; runIndex < _offsets[label + 1]; runIndex++)
+                for (std::uint32_t pixelIndex = _runs[runIndex]._pixelIndex; pixelIndex < _runs[runIndex]._pixelIndex + _runs[runIndex]._length; pixelIndex++)
+                    callback(pixelIndex);
+        }
+    }
+
+private:
+    std::vector<std::size_t>    _offsets;   /** Index of the first run per label (one extra entry marks the end) */
+    std::vector<Run>            _runs;      /** Runs of all labels */
+    std::vector<QRect>          _bounds;    /** Bounding rectangle of the pixels per label */
+};
@@ -3,7 +3,6 @@
 #include "SettingsAction.h"
 #include "DataHierarchyItem.h"
 #include "ImageProp.h"
-#include "SelectionProp.h"
 #include "SelectionToolProp.h"
 #include "LayersRenderer.h"
 
@@ -16,8 +15,15 @@
 #include <QFontMetrics>
 #include <QDebug>
 #include <QMenu>
+#include <QPointer>
+#include <QCoreApplication>
+#include <QThreadPool>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLFramebufferObject>
 
-#include <set>
+#include <algorithm>
+#include <iterator>
 
 using namespace mv;
 using namespace mv::gui;
@@ -37,7 +43,18 @@ Layer::Layer(QObject* parent, const QString& title) :
     _subsetAction(this, "Subset"),
     _selectionData(),
     _imageSelectionRectangle(),
-    _maskData()
+    _maskData(),
+    _maskBitmap(),
+    _pixelsBitmap(),
+    _selectionBitmap(),
+    _selectionBitmapOutdated(true),
+    _dimensionCache(),
+    _residentDimensionsRequest(std::make_shared<std::atomic<std::uint64_t>>(0)),
+    _numberOfResidentDimensions(0),
+    _renderTarget(),
+    _labelIndex(),
+    _labelIndexGeneration(0),
+    _clusterGlobalIndices()
 {
 }
 
@@ -65,13 +82,20 @@ void Layer::initialize(ImageViewerPlugin* imageViewerPlugin, const mv::Dataset<I
     _selectionData.resize(_imagesDataset->getNumberOfPixels());
 
     _props << new ImageProp(*this, "ImageProp");
-    _props << new SelectionProp(*this, "SelectionProp");
     _props << new SelectionToolProp(*this, "SelectionToolProp");
 
     this->getPropByName<ImageProp>("ImageProp")->setGeometry(_imagesDataset->getRectangle());
-    this->getPropByName<SelectionProp>("SelectionProp")->setGeometry(_imagesDataset->getRectangle());
     this->getPropByName<SelectionToolProp>("SelectionToolProp")->setGeometry(_imagesDataset->getRectangle());
 
+    // Size the dimension cache before the channels extract their first dimension
+    const auto updateDimensionCacheBudget = [this]() -> void {
+        _dimensionCache.setBudget(static_cast<std::uint64_t>(_imageSettingsAction.getDimensionCacheBudgetAction().getValue()) * 1024ull * 1024ull);
+    };
+
+    updateDimensionCacheBudget();
+
+    connect(&_imageSettingsAction.getDimensionCacheBudgetAction(), &IntegralAction::valueChanged, this, updateDimensionCacheBudget);
+
     _generalAction.initialize(this);
     _imageSettingsAction.initialize(this);
     _selectionAction.initialize(this, &_imageViewerPlugin->getImageViewerWidget(), &_imageViewerPlugin->getImageViewerWidget().getPixelSelectionTool());
@@ -79,6 +103,20 @@ void Layer::initialize(ImageViewerPlugin* imageViewerPlugin, const mv::Dataset<I
 
     computeSelectionIndices();
 
+    // The selection bitmap is synchronized with the points selection again before the next pixel selection is published
+    if (_sourceDataset->getDataType() == PointType) {
+        connect(&_sourceDataset, &Dataset<DatasetImpl>::dataSelectionChanged, this, [this]() -> void {
+            _selectionBitmapOutdated = true;
+        });
+    }
+
+    // The global indices of the cluster input points are mapped again after the clusters changed
+    if (_sourceDataset->getDataType() == ClusterType) {
+        connect(&_sourceDataset, &Dataset<DatasetImpl>::dataChanged, this, [this]() -> void {
+            _clusterGlobalIndices.clear();
+        });
+    }
+
     _maskData.resize(_imagesDataset->getNumberOfPixels());
 
     // Update the color map scalar data in the image prop
@@ -89,7 +127,12 @@ void Layer::initialize(ImageViewerPlugin* imageViewerPlugin, const mv::Dataset<I
             case ScalarChannelAction::Channel2:
             case ScalarChannelAction::Channel3:
             {
-                this->getPropByName<ImageProp>("ImageProp")->setChannelScalarData(channelAction.getIdentifier(), channelAction.getScalarData(), channelAction.getDisplayRange());
+                this->getPropByName<ImageProp>("ImageProp")->setChannelScalarData(channelAction.getIdentifier(), channelAction.getScalarData(), channelAction.getScalarDataGeneration(), channelAction.getDisplayRange());
+
+                // The first channel of clusters data holds the cluster indices
+                if (channelAction.getIdentifier() == ScalarChannelAction::Channel1 && _sourceDataset->getDataType() == ClusterType)
+                    updateLabelIndex();
+
                 break;
             }
 
@@ -101,6 +144,14 @@ void Layer::initialize(ImageViewerPlugin* imageViewerPlugin, const mv::Dataset<I
         invalidate();
     };
 
+    // Update the channel display range in the image prop (no texture upload)
+    const auto updateChannelDisplayRange = [this](ScalarChannelAction& channelAction) {
+        this->getPropByName<ImageProp>("ImageProp")->setChannelDisplayRange(channelAction.getIdentifier(), channelAction.getDisplayRange());
+
+        // Render
+        invalidate();
+    };
+
     const auto updateInterpolationType = [this]() {
         this->getPropByName<ImageProp>("ImageProp")->setInterpolationType(static_cast<InterpolationType>(_imageSettingsAction.getInterpolationTypeAction().getCurrentIndex()));
         invalidate();
@@ -108,11 +159,39 @@ void Layer::initialize(ImageViewerPlugin* imageViewerPlugin, const mv::Dataset<I
 
     connect(&_generalAction.getVisibleAction(), &ToggleAction::toggled, this, &Layer::invalidate);
     connect(&_imageSettingsAction, &ImageSettingsAction::channelChanged, this, updateChannelScalarData);
+    connect(&_imageSettingsAction, &ImageSettingsAction::channelDisplayRangeChanged, this, updateChannelDisplayRange);
     connect(&_imageSettingsAction.getInterpolationTypeAction(), &OptionAction::currentIndexChanged, this, updateInterpolationType);
+
+    // Stream channel uploads through the upload ring during playback
+    connect(&_imageSettingsAction.getPlaybackAction().getPlayAction(), &ToggleAction::toggled, this, [this, updateChannelScalarData](bool toggled) -> void {
+        this->getPropByName<ImageProp>("ImageProp")->setStreaming(toggled);
+
+        // Frames might have been dropped, so make sure the final frame is uploaded
+        if (!toggled) {
+            updateChannelScalarData(_imageSettingsAction.getScalarChannel1Action());
+            updateChannelScalarData(_imageSettingsAction.getScalarChannel2Action());
+            updateChannelScalarData(_imageSettingsAction.getScalarChannel3Action());
+        }
+    });
+
+    // Switching the dimension of a resident channel only changes a shader uniform
+    for (auto channelAction : { &_imageSettingsAction.getScalarChannel1Action(), &_imageSettingsAction.getScalarChannel2Action(), &_imageSettingsAction.getScalarChannel3Action() })
+        connect(&channelAction->getDimensionAction(), &OptionAction::currentIndexChanged, this, [this, channelAction]() -> void {
+            updateChannelDimension(*channelAction);
+        });
+
+    connect(&_imageSettingsAction.getResidentDimensionsAction(), &ToggleAction::toggled, this, &Layer::updateResidentDimensions);
+
+    // Re-upload the channels in the (un)compressed storage format
+    connect(&_imageSettingsAction.getCompressChannelsAction(), &ToggleAction::toggled, this, [this, updateChannelScalarData]() -> void {
+        updateChannelScalarData(_imageSettingsAction.getScalarChannel1Action());
+        updateChannelScalarData(_imageSettingsAction.getScalarChannel2Action());
+        updateChannelScalarData(_imageSettingsAction.getScalarChannel3Action());
+    });
     
     // Update prop when selection overlay color and opacity change
-    connect(&_selectionAction.getPixelSelectionAction().getOverlayColorAction(), &ColorAction::colorChanged, this, &Layer::invalidate);
-    connect(&_selectionAction.getPixelSelectionAction().getOverlayOpacityAction(), &DecimalAction::valueChanged, this, &Layer::invalidate);
+    connect(&_selectionAction.getPixelSelectionAction().getOverlayColorAction(), &ColorAction::colorChanged, this, &Layer::invalidateOverlays);
+    connect(&_selectionAction.getPixelSelectionAction().getOverlayOpacityAction(), &DecimalAction::valueChanged, this, &Layer::invalidateOverlays);
 
     // Update the model matrix and re-render
     const auto updateModelMatrixAndReRender = [this]() {
@@ -128,6 +207,7 @@ void Layer::initialize(ImageViewerPlugin* imageViewerPlugin, const mv::Dataset<I
     updateChannelScalarData(_imageSettingsAction.getScalarChannel3Action());
     updateInterpolationType();
     updateModelMatrixAndReRender();
+    updateResidentDimensions();
 
     const auto nameChanged = [this]() -> void {
         setText(_generalAction.getNameAction().getString());
@@ -137,26 +217,29 @@ void Layer::initialize(ImageViewerPlugin* imageViewerPlugin, const mv::Dataset<I
     nameChanged();
 
     connect(&_generalAction.getNameAction(), &StringAction::stringChanged, this, nameChanged);
-    connect(&_generalAction.getDatasetNameAction(), &StringAction::stringChanged, this, &Layer::invalidate);
+    connect(&_generalAction.getDatasetNameAction(), &StringAction::stringChanged, this, &Layer::invalidateOverlays);
 
     const auto updateSelectionRoi = [this]() {
         computeSelection();
         publishSelection();
     };
 
+    // Publish the region of interest when the renderer is idle (zooming and panning change it on every frame)
     connect(&_imageViewerPlugin->getImageViewerWidget().getRenderer(), &LayersRenderer::zoomRectangleChanged, this, [this, updateSelectionRoi]() {
-        updateRoi();
+        getRenderer()->requestIdleTask(this, "UpdateRoi", [this, updateSelectionRoi]() -> void {
+            updateRoi();
 
-        if (!_active)
-            return;
+            if (!_active)
+                return;
 
-        if (_selectionAction.getPixelSelectionAction().getPixelSelectionTool()->getType() != PixelSelectionType::ROI)
-            return;
+            if (_selectionAction.getPixelSelectionAction().getPixelSelectionTool()->getType() != PixelSelectionType::ROI)
+                return;
 
-        if (!_selectionAction.getPixelSelectionAction().getNotifyDuringSelectionAction().isChecked())
-            return;
+            if (!_selectionAction.getPixelSelectionAction().getNotifyDuringSelectionAction().isChecked())
+                return;
 
-        updateSelectionRoi();
+            updateSelectionRoi();
+        });
     });
 
     connect(&_imageViewerPlugin->getImageViewerWidget(), &ImageViewerWidget::navigationEnded, this, [this, updateSelectionRoi]() {
@@ -178,6 +261,9 @@ void Layer::initialize(ImageViewerPlugin* imageViewerPlugin, const mv::Dataset<I
             updateSelectionRoi();
         else
             _imagesDataset->selectNone();
+
+        // The selection props are not rendered in ROI selection mode
+        invalidateSelection();
     });
 
     connect(&_miscellaneousAction.getRoiViewAction(), &DecimalRectangleAction::rectangleChanged, getRenderer(), [this](float left, float right, float bottom, float top) -> void {
@@ -198,9 +284,12 @@ void Layer::initialize(ImageViewerPlugin* imageViewerPlugin, const mv::Dataset<I
     auto updateMaskData = [this]() {
         _imagesDataset->getMaskData(_maskData);
 
+        // Pack the mask so that it can be applied to pixel selections with bitwise operations
+        _maskBitmap.resize(_maskData.size());
+        _maskBitmap.packBytes(0, _maskData.data(), _maskData.size());
+
         // Apply masking to props
         this->getPropByName<ImageProp>("ImageProp")->setMaskData(_maskData);
-        this->getPropByName<SelectionProp>("SelectionProp")->setMaskData(_maskData);
         };
 
     connect(&_imagesDataset, &Dataset<Images>::dataChanged, this, updateMaskData);
@@ -213,6 +302,125 @@ Layer::~Layer()
 #if _DEBUG
     qDebug() << "Delete layer" << _generalAction.getNameAction().getString();
 #endif
+
+    // Cancel the resident dimension jobs that did not start yet
+    ++(*_residentDimensionsRequest);
+}
+
+void Layer::updateResidentDimensions()
+{
+    try {
+        auto imageProp = getPropByName<ImageProp>("ImageProp");
+
+        // Cancel uploads that are still in flight
+        const auto residentDimensionsRequest        = ++(*_residentDimensionsRequest);
+        const auto latestResidentDimensionsRequest  = _residentDimensionsRequest;
+        const auto numberOfDimensions               = static_cast<std::int32_t>(getNumberOfImages());
+        const auto cost                             = QString("%1 MB").arg(QString::number(imageProp->getResidentDimensionsCost(numberOfDimensions) / (1024.0 * 1024.0), 'f', 1));
+
+        auto& statusAction = _imageSettingsAction.getResidentDimensionsStatusAction();
+
+        _numberOfResidentDimensions = 0;
+
+        imageProp->releaseResidentDimensions();
+
+        if (!_imageSettingsAction.getResidentDimensionsAction().isChecked()) {
+            statusAction.setString(cost);
+        }
+        else if (!imageProp->allocateResidentDimensions(numberOfDimensions)) {
+            statusAction.setString(QString("%1 (over budget, on demand)").arg(cost));
+        }
+        else {
+            statusAction.setString(QString("%1 (0/%2 resident)").arg(cost, QString::number(numberOfDimensions)));
+
+            auto images             = _imagesDataset;
+            const auto imageSize    = getImageSize();
+
+            // The layer might be removed before the jobs complete
+            QPointer<Layer> guardedLayer(this);
+
+            // Extract and pack each dimension on a worker thread (after the visible dimensions) and upload it on the GUI thread
+            for (std::int32_t dimensionIndex = 0; dimensionIndex < numberOfDimensions; dimensionIndex++) {
+                QThreadPool::globalInstance()->start([guardedLayer, images, imageSize, dimensionIndex, cost, numberOfDimensions, residentDimensionsRequest, latestResidentDimensionsRequest]() mutable -> void {
+
+                    // Cancelled before the extraction started
+                    if (residentDimensionsRequest != latestResidentDimensionsRequest->load())
+                        return;
+
+                    QVector<float> scalarData;
+                    QPair<float, float> scalarDataRange;
+
+                    try {
+                        images->getScalarData(static_cast<std::uint32_t>(dimensionIndex), scalarData, scalarDataRange);
+                    }
+                    catch (std::exception& e)
+                    {
+                        qWarning() << "Unable to extract resident dimension:" << e.what();
+                    }
+                    catch (...) {
+                        qWarning() << "Unable to extract resident dimension";
+                    }
+
+                    if (scalarData.isEmpty() || residentDimensionsRequest != latestResidentDimensionsRequest->load())
+                        return;
+
+                    const auto channelStorage = ChannelStorage::createUInt16(scalarData, imageSize);
+
+                    // Hand over to the GUI thread, where the layer can be checked safely
+                    QMetaObject::invokeMethod(QCoreApplication::instance(), [guardedLayer, dimensionIndex, cost, numberOfDimensions, residentDimensionsRequest, channelStorage, scalarDataRange]() -> void {
+                        auto layer = guardedLayer.data();
+
+                        // Discard when the layer was removed or the resident dimensions were updated in the meantime
+                        if (layer == nullptr || residentDimensionsRequest != layer->_residentDimensionsRequest->load())
+                            return;
+
+                        layer->getPropByName<ImageProp>("ImageProp")->setResidentDimension(dimensionIndex, channelStorage, scalarDataRange);
+
+                        layer->_numberOfResidentDimensions++;
+
+                        auto& imageSettingsAction = layer->_imageSettingsAction;
+
+                        imageSettingsAction.getResidentDimensionsStatusAction().setString(QString("%1 (%2/%3 resident)").arg(cost, QString::number(layer->_numberOfResidentDimensions), QString::number(numberOfDimensions)));
+
+                        // Channels that display this dimension switch to the texture array
+                        for (auto channelAction : { &imageSettingsAction.getScalarChannel1Action(), &imageSettingsAction.getScalarChannel2Action(), &imageSettingsAction.getScalarChannel3Action() })
+                            if (channelAction->getDimensionAction().getCurrentIndex() == dimensionIndex)
+                                layer->updateChannelDimension(*channelAction);
+                    }, Qt::QueuedConnection);
+                }, ScalarChannelAction::prefetchPriority);
+            }
+        }
+
+        // Channels sample their own textures until their dimension is resident
+        updateChannelDimension(_imageSettingsAction.getScalarChannel1Action());
+        updateChannelDimension(_imageSettingsAction.getScalarChannel2Action());
+        updateChannelDimension(_imageSettingsAction.getScalarChannel3Action());
+    }
+    catch (std::exception& e)
+    {
+        exceptionMessageBox("Unable to update resident dimensions", e);
+    }
+    catch (...) {
+        exceptionMessageBox("Unable to update resident dimensions");
+    }
+}
+
+void Layer::updateChannelDimension(ScalarChannelAction& channelAction)
+{
+    auto imageProp = getPropByName<ImageProp>("ImageProp");
+
+    const auto channelIndex     = static_cast<std::uint32_t>(channelAction.getIdentifier());
+    const auto dimensionIndex   = channelAction.getDimensionAction().getCurrentIndex();
+
+    imageProp->setChannelDimension(channelIndex, dimensionIndex);
+
+    // Tone map with the range of the resident dimension (its scalar data might still be extracted in the background)
+    if (imageProp->isDimensionResident(dimensionIndex))
+        imageProp->setChannelDisplayRange(channelIndex, channelAction.getDisplayRange(imageProp->getResidentDimensionRange(dimensionIndex)));
+    else
+        imageProp->setChannelScalarData(channelIndex, channelAction.getScalarData(), channelAction.getScalarDataGeneration(), channelAction.getDisplayRange());
+
+    invalidate();
 }
 
 void Layer::render(const QMatrix4x4& modelViewProjectionMatrix)
@@ -226,8 +434,8 @@ void Layer::render(const QMatrix4x4& modelViewProjectionMatrix)
         // Render props
         for (auto prop : _props) {
 
-            // Do not render the selection prop and selection tool prop in ROI selection mode
-            if (prop->getName() == "SelectionProp" || prop->getName() == "SelectionToolProp")
+            // Do not render the selection tool prop in ROI selection mode (the image prop hides its selection overlay as well)
+            if (prop->getName() == "SelectionToolProp")
                 if (_selectionAction.getPixelSelectionAction().getTypeAction().getCurrentIndex() == static_cast<std::int16_t>(PixelSelectionType::ROI))
                     continue;
 
@@ -244,6 +452,67 @@ void Layer::render(const QMatrix4x4& modelViewProjectionMatrix)
     }
 }
 
+void Layer::composite(const QMatrix4x4& modelViewProjectionMatrix)
+{
+    try {
+
+        // Don't render if invisible
+        if (!_generalAction.getVisibleAction().isChecked())
+            return;
+
+        auto parentWidget   = getRenderer()->getParentWidget();
+        auto functions      = getRenderer()->getOpenGLContext()->functions();
+
+        const auto renderTargetSize = parentWidget->size() * parentWidget->devicePixelRatio();
+
+        if (renderTargetSize.isEmpty())
+            return;
+
+        // (Re)create the render target when the viewer is resized, its contents are outdated in that case
+        const auto renderTargetCreated = !_renderTarget || _renderTarget->size() != renderTargetSize;
+
+        if (renderTargetCreated) {
+            _renderTarget = std::make_unique<QOpenGLFramebufferObject>(renderTargetSize, QOpenGLFramebufferObject::CombinedDepthStencil);
+
+            if (!_renderTarget->isValid())
+                throw std::runtime_error("Render target is not valid");
+        }
+
+        // Only render the props when the layer or the view changed
+        if (renderTargetCreated || getRenderer()->isDirty(this)) {
+            GLint framebuffer = 0, viewport[4];
+
+            functions->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+            functions->glGetIntegerv(GL_VIEWPORT, viewport);
+
+            if (!_renderTarget->bind())
+                throw std::runtime_error("Unable to bind render target");
+
+            functions->glViewport(0, 0, renderTargetSize.width(), renderTargetSize.height());
+            functions->glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+            functions->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+            // Accumulate premultiplied colors, so that compositing the target is equivalent to rendering the props directly
+            functions->glEnable(GL_BLEND);
+            functions->glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+            render(modelViewProjectionMatrix);
+
+            functions->glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            functions->glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        }
+
+        getRenderer()->compositeTexture(_renderTarget->texture());
+    }
+    catch (std::exception& e)
+    {
+        exceptionMessageBox(QString("Unable to composite layer: %1").arg(_generalAction.getNameAction().getString()), e);
+    }
+    catch (...) {
+        exceptionMessageBox(QString("Unable to composite layer: %1").arg(_generalAction.getNameAction().getString()));
+    }
+}
+
 void Layer::updateModelMatrix()
 {
 #if _DEBUG
@@ -291,6 +560,38 @@ void Layer::setColorMapImage(const QImage& colorMapImage, const InterpolationTyp
     invalidate();
 }
 
+void Layer::setLabelColors(const QVector<QColor>& labelColors)
+{
+    // Get pointer to image prop
+    auto imageProp = this->getPropByName<ImageProp>("ImageProp");
+
+    // Set the label colors in the image prop
+    imageProp->setLabelColors(labelColors);
+
+    // Streamed tiles hold the cluster indices as floating point values, so they are color mapped with a discrete color map
+    if (!imageProp->isLabelMap() && !labelColors.isEmpty()) {
+        QImage discreteColorMapImage(static_cast<std::int32_t>(labelColors.size()), 1, QImage::Format::Format_RGB32);
+
+        for (std::int32_t labelIndex = 0; labelIndex < discreteColorMapImage.width(); labelIndex++)
+            discreteColorMapImage.setPixelColor(labelIndex, 0, labelColors[labelIndex]);
+
+        imageProp->setColorMapImage(discreteColorMapImage);
+        imageProp->setColorMapInterpolationType(InterpolationType::NearestNeighbor);
+    }
+
+    // Render
+    invalidate();
+}
+
+void Layer::setSelectedLabelsOnly(bool selectedLabelsOnly)
+{
+    // Hide the clusters that are not selected in the image prop
+    this->getPropByName<ImageProp>("ImageProp")->setSelectedLabelsOnly(selectedLabelsOnly);
+
+    // Render
+    invalidate();
+}
+
 void Layer::updateWindowTitle()
 {
     try {
@@ -440,9 +741,24 @@ bool Layer::isActive() const
     return _active;
 }
 
+bool Layer::isRenderable()
+{
+    return getPropByName<ImageProp>("ImageProp")->isInitialized();
+}
+
 void Layer::invalidate()
 {
-    _imageViewerPlugin->getImageViewerWidget().update();
+    getRenderer()->requestFrame(LayersRenderer::Textures, this);
+}
+
+void Layer::invalidateOverlays()
+{
+    getRenderer()->requestFrame(LayersRenderer::Overlays, this);
+}
+
+void Layer::invalidateSelection()
+{
+    getRenderer()->requestFrame(LayersRenderer::Selection, this);
 }
 
 void Layer::scaleToFit(const QRectF& layersRectangle)
@@ -492,6 +808,17 @@ void Layer::paint(QPainter& painter, const PaintFlag& paintFlags)
 
             // Draw the bounding rectangle
             painter.drawRect(propRectangle);
+
+            // Draw a placeholder while the layer resources are loaded in the background
+            if (!isRenderable()) {
+                auto placeholderColor = _generalAction.getColorAction().getColor();
+
+                placeholderColor.setAlphaF(0.15f);
+
+                painter.fillRect(propRectangle, placeholderColor);
+                painter.setFont(QApplication::font());
+                painter.drawText(propRectangle, Qt::AlignCenter, "Loading...");
+            }
         }
 
         // Draw layer selection rectangle (if not in ROI selection mode)
@@ -562,14 +889,15 @@ void Layer::paint(QPainter& painter, const PaintFlag& paintFlags)
                 // Show cluster name if hovering over an image that originates from clusters data
                 if (getSourceDataset()->getDataType() == ClusterType) {
 
-                    // Get cluster index from channel scalar data
-                    const auto clusterIndex = static_cast<std::int32_t>(_imageSettingsAction.getScalarChannel1Action().getScalarData()[pixelIndex]);
+                    // Get cluster index from the integer labels (or from the channel scalar data when streaming tiles)
+                    const auto& labels      = this->getPropByName<ImageProp>("ImageProp")->getLabels();
+                    const auto clusterIndex = pixelIndex < labels.size() ? labels[pixelIndex] : static_cast<std::uint32_t>(_imageSettingsAction.getScalarChannel1Action().getScalarData()[pixelIndex]);
 
-                    // Get cluster name from cluster index
-                    const auto clusterName = _sourceDataset.get<Clusters>()->getClusters()[clusterIndex].getName();
+                    const auto& clusters = _sourceDataset.get<Clusters>()->getClusters();
 
                     // Add cluster name to the label text
-                    labelText += "Cluster\t: " + clusterName;
+                    if (clusterIndex < clusters.size())
+                        labelText += "Cluster\t: " + clusters[clusterIndex].getName();
                 }
 
                 // Configure pen and brush
@@ -699,7 +1027,7 @@ void Layer::startSelection()
         this->getPropByName<SelectionToolProp>("SelectionToolProp")->resetOffScreenSelectionBuffer();
 
         // Render
-        invalidate();
+        invalidateSelection();
     }
     catch (std::exception& e)
     {
@@ -722,7 +1050,7 @@ void Layer::computeSelection(const QVector<QPoint>& mousePositions /*= QVector<Q
         this->getPropByName<SelectionToolProp>("SelectionToolProp")->compute(mousePositions);
 
         // Render
-        invalidate();
+        invalidateSelection();
     }
     catch (std::exception& e)
     {
@@ -745,7 +1073,7 @@ void Layer::resetSelectionBuffer()
         getPropByName<SelectionToolProp>("SelectionToolProp")->resetOffScreenSelectionBuffer();
 
         // Trigger render
-        invalidate();
+        invalidateSelection();
     }
     catch (std::exception& e)
     {
@@ -757,6 +1085,14 @@ void Layer::resetSelectionBuffer()
 }
 
 void Layer::publishSelection()
+{
+    // Publish the current state of the selection tool, even when the previous publication still waits for its read back
+    getPropByName<SelectionToolProp>("SelectionToolProp")->pinSelectionBuffer();
+
+    publishPinnedSelection();
+}
+
+void Layer::publishPinnedSelection()
 {
     try {
 #if _DEBUG
@@ -777,87 +1113,122 @@ void Layer::publishSelection()
         // Get reference to the pixel selection tool
         auto& pixelSelectionTool = getImageViewerPlugin().getImageViewerWidget().getPixelSelectionTool();
 
-        // Get current selection image
-        auto selectionImage = getPropByName<SelectionToolProp>("SelectionToolProp")->getSelectionImage().mirrored(true, true);
+        auto selectionToolProp = getPropByName<SelectionToolProp>("SelectionToolProp");
 
-        const auto noComponents     = 4;
-        const auto width            = static_cast<float>(getImageSize().width());
-        const auto noPixels         = _imagesDataset->getNumberOfPixels();
+        // The read back is consumed once its transfer completed, its fence is polled again in the next refresh interval instead of waited for
+        if (!selectionToolProp->isSelectionBufferReady()) {
+            getRenderer()->requestIdleTask(this, "PublishSelection", [this]() -> void {
+                publishPinnedSelection();
+            });
+
+            return;
+        }
+
+        const auto noPixels         = static_cast<std::size_t>(_imagesDataset->getNumberOfPixels());
         const auto imageRectangle   = _imagesDataset->getRectangle();
 
-        // Get pixel index from two-dimensional pixel coordinates
-        const auto getPixelIndex = [&imageRectangle](const std::int32_t& pixelX, const std::int32_t& pixelY) -> std::int32_t {
-            return pixelY * imageRectangle.width() + pixelX;
+        // The pixels bitmap is kept between publishes, only the bit range spanned by the rows of the region touched by the selection tool is written and read
+        if (_pixelsBitmap.size() != noPixels)
+            _pixelsBitmap.resize(noPixels);
+
+        std::size_t selectionOffset = 0;
+        std::size_t selectionCount  = 0;
+
+        // Pack the non-zero pixels of the read back region into the pixels bitmap (one bit per pixel in row-column order)
+        const auto selectionBuffer = selectionToolProp->mapSelectionBuffer();
+
+        if (!selectionBuffer.isEmpty()) {
+            const auto selectionRectangle = selectionBuffer.getRectangle();
+
+            selectionOffset = static_cast<std::size_t>(selectionRectangle.top()) * imageRectangle.width() + selectionRectangle.left();
+            selectionCount  = static_cast<std::size_t>(selectionRectangle.bottom()) * imageRectangle.width() + selectionRectangle.right() + 1 - selectionOffset;
+
+            // Pixels of the range that lie outside of the region are not selected
+            _pixelsBitmap.clear(selectionOffset, selectionCount);
+
+            for (std::int32_t pixelY = selectionRectangle.top(); pixelY <= selectionRectangle.bottom(); pixelY++)
+                _pixelsBitmap.packBytes(static_cast<std::size_t>(pixelY) * imageRectangle.width() + selectionRectangle.left(), selectionBuffer.getScanLine(pixelY), selectionRectangle.width(), SelectionToolProp::SelectionBuffer::pixelStep);
+        }
+
+        selectionToolProp->unmapSelectionBuffer();
+
+        // Exclude masked pixels
+        if (_maskBitmap.size() == noPixels)
+            _pixelsBitmap.apply(_maskBitmap, SelectionBitmap::Operation::Intersect, selectionOffset, selectionCount);
+
+        // Establish the selection set operation from the type of modifier
+        const auto getSelectionOperation = [&pixelSelectionTool]() -> SelectionBitmap::Operation {
+            switch (pixelSelectionTool.getModifier())
+            {
+                case PixelSelectionModifierType::Add:
+                    return SelectionBitmap::Operation::Add;
+
+                case PixelSelectionModifierType::Subtract:
+                    return SelectionBitmap::Operation::Subtract;
+
+                default:
+                    break;
+            }
+
+            return SelectionBitmap::Operation::Replace;
         };
 
         if (_sourceDataset->getDataType() == PointType) {
             
             // Get reference to points selection indices
-            std::vector<std::uint32_t> selectionIndices = _sourceDataset->getSelection<Points>()->indices;
+            const auto& selectionIndices = _sourceDataset->getSelection<Points>()->indices;
 
-            // Establish new selection indices depending on the type of modifier
-            switch (pixelSelectionTool.getModifier())
-            {
-                // Replace pixels with new selection
-                case PixelSelectionModifierType::Replace:
-                {
-                    selectionIndices.clear();
-                    selectionIndices.reserve(noPixels);
-
-                    // Loop over all the pixels in the selection image in row-column order and add to the selection indices if the pixel is non-zero
-                    for (std::int32_t pixelY = 0; pixelY < imageRectangle.height(); pixelY++) {
-                        for (std::int32_t pixelX = 0; pixelX < imageRectangle.width(); pixelX++) {
-                            if (_maskData[getPixelIndex(pixelX, pixelY)] > 0u && selectionImage.bits()[getPixelIndex(pixelX, pixelY) * noComponents] > 0)
-                                selectionIndices.push_back(getPixelIndex(pixelX, pixelY));
-                        }
-                    }
+            const auto selectionOperation = getSelectionOperation();
 
-                    break;
-                }
+            // The selection bitmap is out of date when the points selection was changed elsewhere
+            if (_selectionBitmap.size() != noPixels) {
+                _selectionBitmap.resize(noPixels);
 
-                // Add pixels to current selection
-                case PixelSelectionModifierType::Add:
-                {
-                    // Create selection set of current selection indices
-                    auto selectionSet = std::set<std::uint32_t>(selectionIndices.begin(), selectionIndices.end());
-
-                    // Loop over all the pixels in the selection image in row-column order and insert the selection index into the set if the pixel is non-zero
-                    for (std::int32_t pixelY = 0; pixelY < imageRectangle.height(); pixelY++) {
-                        for (std::int32_t pixelX = 0; pixelX < imageRectangle.width(); pixelX++) {
-                            if (_maskData[getPixelIndex(pixelX, pixelY)] > 0u && selectionImage.bits()[getPixelIndex(pixelX, pixelY) * noComponents] > 0)
-                                selectionSet.insert(getPixelIndex(pixelX, pixelY));
-                        }
-                    }
+                _selectionBitmapOutdated = true;
+            }
 
-                    // Convert the set back to a vector
-                    selectionIndices = std::vector<std::uint32_t>(selectionSet.begin(), selectionSet.end());
-                    break;
-                }
+            std::vector<std::uint32_t> newSelectionIndices;
 
-                // Remove pixels from current selection
-                case PixelSelectionModifierType::Subtract:
-                {
-                    // Create selection set of current selection indices
-                    auto selectionSet = std::set<std::uint32_t>(selectionIndices.begin(), selectionIndices.end());
-
-                    // Loop over all the pixels in the selection image in row-column order and remove the selection index from the set if the pixel is non-zero
-                    for (std::int32_t pixelY = 0; pixelY < imageRectangle.height(); pixelY++) {
-                        for (std::int32_t pixelX = 0; pixelX < imageRectangle.width(); pixelX++) {
-                            if (_maskData[getPixelIndex(pixelX, pixelY)] > 0u && selectionImage.bits()[getPixelIndex(pixelX, pixelY) * noComponents] > 0)
-                                selectionSet.erase(getPixelIndex(pixelX, pixelY));
-                        }
-                    }
+            if (selectionOperation == SelectionBitmap::Operation::Replace) {
 
-                    // Convert the set back to a vector
-                    selectionIndices = std::vector<std::uint32_t>(selectionSet.begin(), selectionSet.end());
-                    break;
+                // Replacing discards the current selection, so only its bits are cleared (the whole bitmap when it is out of date)
+                if (_selectionBitmapOutdated) {
+                    _selectionBitmap.clear();
+                }
+                else {
+                    for (const auto& selectionIndex : selectionIndices)
+                        if (selectionIndex < noPixels)
+                            _selectionBitmap.reset(selectionIndex);
                 }
 
-                default:
-                    break;
+                _selectionBitmap.apply(_pixelsBitmap, selectionOperation, selectionOffset, selectionCount);
+
+                // Only the touched range holds selected pixels
+                _selectionBitmap.forEachSetBit([&newSelectionIndices](std::size_t pixelIndex) -> void {
+                    newSelectionIndices.push_back(static_cast<std::uint32_t>(pixelIndex));
+                }, selectionOffset, selectionCount);
+            }
+            else {
+                if (_selectionBitmapOutdated)
+                    _selectionBitmap.assignIndices(selectionIndices);
+
+                // Outside the touched range the pixel selection is empty, so only that range is combined
+                _selectionBitmap.apply(_pixelsBitmap, selectionOperation, selectionOffset, selectionCount);
+                _selectionBitmap.toIndices(newSelectionIndices);
+
+                // Selected points beyond the image pixels are not in the bitmap, they are kept (after the pixel indices, so the indices stay sorted)
+                const auto numberOfPixelIndices = newSelectionIndices.size();
+
+                std::copy_if(selectionIndices.begin(), selectionIndices.end(), std::back_inserter(newSelectionIndices), [noPixels](std::uint32_t selectionIndex) -> bool {
+                    return selectionIndex >= noPixels;
+                });
+
+                std::sort(newSelectionIndices.begin() + static_cast<std::ptrdiff_t>(numberOfPixelIndices), newSelectionIndices.end());
             }
 
-            _sourceDataset->setSelectionIndices(selectionIndices);
+            _selectionBitmapOutdated = false;
+
+            _sourceDataset->setSelectionIndices(newSelectionIndices);
         }
 
         if (_sourceDataset->getDataType() == ClusterType) {
@@ -865,78 +1236,38 @@ void Layer::publishSelection()
             // Get reference to clusters selection indices
             auto& selectionIndices = _sourceDataset->getSelection<Clusters>()->indices;
 
-            // Convert floating point scalars to unsigned integer scalars
-            std::vector<std::uint32_t> integerScalarData(_imageSettingsAction.getScalarChannel1Action().getScalarData().begin(), _imageSettingsAction.getScalarChannel1Action().getScalarData().end());
+            // Cluster indices are stored as integer labels in the image prop (or as floating point scalars in the first channel when streaming tiles)
+            const auto& labels              = this->getPropByName<ImageProp>("ImageProp")->getLabels();
+            const auto& clusterScalarData   = _imageSettingsAction.getScalarChannel1Action().getScalarData();
 
-            // Establish new selection indices depending on the type of modifier
-            switch (pixelSelectionTool.getModifier())
-            {
-                // Replace pixels with new selection
-                case PixelSelectionModifierType::Replace:
-                {
-                    selectionIndices.clear();
-                    selectionIndices.reserve(noPixels);
-
-                    // Loop over all the pixels in the selection image in row-column order and add to the selection indices if the pixel is non-zero
-                    for (std::int32_t pixelY = 0; pixelY < imageRectangle.height(); pixelY++) {
-                        for (std::int32_t pixelX = 0; pixelX < imageRectangle.width(); pixelX++) {
-                            if (_maskData[getPixelIndex(pixelX, pixelY)] > 0u && selectionImage.bits()[getPixelIndex(pixelX, pixelY) * noComponents] > 0)
-                                selectionIndices.push_back(integerScalarData[getPixelIndex(pixelX, pixelY)]);
-                        }
-                    }
+            const auto noClusters = Dataset<Clusters>(_sourceDataset)->getClusters().size();
 
-                    // Convert selection indices vector to set to remove duplicates
-                    std::set<std::uint32_t> selectionSet(selectionIndices.begin(), selectionIndices.end());
+            // Collect the clusters touched by the pixel selection
+            SelectionBitmap clustersBitmap(noClusters);
 
-                    // Convert the set back to a vector
-                    selectionIndices = std::vector<std::uint32_t>(selectionSet.begin(), selectionSet.end());
+            _pixelsBitmap.forEachSetBit([&labels, &clusterScalarData, &clustersBitmap, noClusters](std::size_t pixelIndex) -> void {
+                if (pixelIndex < labels.size()) {
+                    if (labels[pixelIndex] < noClusters)
+                        clustersBitmap.set(labels[pixelIndex]);
 
-                    break;
+                    return;
                 }
 
-                // Add pixels to current selection
-                case PixelSelectionModifierType::Add:
-                {
-                    // Create selection set of current selection indices
-                    auto selectionSet = std::set<std::uint32_t>(selectionIndices.begin(), selectionIndices.end());
-
-                    // Loop over all the pixels in the selection image in row-column order and insert the selection index into the set if the pixel is non-zero
-                    for (std::int32_t pixelY = 0; pixelY < imageRectangle.height(); pixelY++) {
-                        for (std::int32_t pixelX = 0; pixelX < imageRectangle.width(); pixelX++) {
-                            if (_maskData[getPixelIndex(pixelX, pixelY)] > 0u && selectionImage.bits()[getPixelIndex(pixelX, pixelY) * noComponents] > 0)
-                                selectionSet.insert(integerScalarData[getPixelIndex(pixelX, pixelY)]);
-                        }
-                    }
-
-                    // Convert the set back to a vector
-                    selectionIndices = std::vector<std::uint32_t>(selectionSet.begin(), selectionSet.end());
-
-                    break;
-                }
+                if (pixelIndex >= static_cast<std::size_t>(clusterScalarData.size()))
+                    return;
 
-                // Remove pixels from current selection
-                case PixelSelectionModifierType::Subtract:
-                {
-                    // Create selection set of current selection indices
-                    auto selectionSet = std::set<std::uint32_t>(selectionIndices.begin(), selectionIndices.end());
-
-                    // Loop over all the pixels in the selection image in row-column order and remove the selection index from the set if the pixel is non-zero
-                    for (std::int32_t pixelY = 0; pixelY < imageRectangle.height(); pixelY++) {
-                        for (std::int32_t pixelX = 0; pixelX < imageRectangle.width(); pixelX++) {
-                            if (_maskData[getPixelIndex(pixelX, pixelY)] > 0u && selectionImage.bits()[getPixelIndex(pixelX, pixelY) * noComponents] > 0)
-                                selectionSet.erase(integerScalarData[getPixelIndex(pixelX, pixelY)]);
-                        }
-                    }
+                const auto clusterIndex = static_cast<std::size_t>(clusterScalarData[static_cast<qsizetype>(pixelIndex)]);
 
-                    // Convert the set back to a vector
-                    selectionIndices = std::vector<std::uint32_t>(selectionSet.begin(), selectionSet.end());
+                if (clusterIndex < noClusters)
+                    clustersBitmap.set(clusterIndex);
+            }, selectionOffset, selectionCount);
 
-                    break;
-                }
+            // Combine the current cluster selection with the touched clusters
+            SelectionBitmap selectionBitmap(noClusters);
 
-                default:
-                    break;
-            }
+            selectionBitmap.assignIndices(selectionIndices);
+            selectionBitmap.apply(clustersBitmap, getSelectionOperation());
+            selectionBitmap.toIndices(selectionIndices);
 
             // Get reference to the clusters dataset
             auto clusters = Dataset<Clusters>(_sourceDataset);
@@ -952,14 +1283,13 @@ void Layer::publishSelection()
             selection->indices.clear();
             selection->indices.reserve(selectedIndices.size());
 
-            std::vector<std::uint32_t> globalIndices;
-
-            // Get global indices for mapping selection
-            points->getGlobalIndices(globalIndices);
+            // Get (cached) global indices for mapping selection
+            const auto& globalIndices = getClusterGlobalIndices();
 
             // Translate selection indices and add them
             for (auto selectedIndex : selectedIndices)
-                selection->indices.push_back(globalIndices[selectedIndex]);
+                if (selectedIndex < globalIndices.size())
+                    selection->indices.push_back(globalIndices[selectedIndex]);
 
             // Notify others that the point selection changed
             events().notifyDatasetDataSelectionChanged(points);
@@ -968,8 +1298,12 @@ void Layer::publishSelection()
         // Notify listeners of the selection change
         events().notifyDatasetDataSelectionChanged(_sourceDataset->getSourceDataset<DatasetImpl>());
 
+        // The selection bitmap already holds the published selection
+        if (_sourceDataset->getDataType() == PointType)
+            _selectionBitmapOutdated = false;
+
         // Render
-        invalidate();
+        invalidateSelection();
     }
     catch (std::exception& e)
     {
@@ -983,17 +1317,55 @@ void Layer::publishSelection()
 void Layer::computeSelectionIndices()
 {
     try {
-        // Get selection image, selected indices and selection boundaries from the image dataset
-        _imagesDataset->getSelectionData(_selectionData, _selectedIndices, _imageSelectionRectangle);
+        auto imageProp = this->getPropByName<ImageProp>("ImageProp");
+
+        // Pixels outside the previous and the new selection boundaries do not change, so only that region of the selection texture is updated
+        const auto previousImageSelectionRectangle = _imageSelectionRectangle;
 
-        // Assign the scalar data to the prop
-        this->getPropByName<SelectionProp>("SelectionProp")->setSelectionData(_selectionData);
+        // The pixels of the selected clusters are looked up in the label index, this does not require a pass over the pixels
+        if (_sourceDataset->getDataType() == ClusterType && _labelIndex.isValid()) {
+            const auto& selectedClusters = _sourceDataset->getSelection<Clusters>()->indices;
+
+            const auto labelMap = imageProp->isLabelMap();
+
+            // Label maps flag the selected clusters in the label properties, otherwise only the previously and newly selected pixels are updated
+            if (labelMap) {
+                imageProp->setSelectedLabels(selectedClusters);
+            }
+            else {
+                for (const auto& selectedIndex : _selectedIndices)
+                    if (selectedIndex < _selectionData.size())
+                        _selectionData[selectedIndex] = 0;
+            }
+
+            _selectedIndices.clear();
+
+            _labelIndex.forEachPixel(selectedClusters, [this, labelMap](std::uint32_t pixelIndex) -> void {
+                _selectedIndices.push_back(pixelIndex);
+
+                if (!labelMap && pixelIndex < _selectionData.size())
+                    _selectionData[pixelIndex] = 1;
+            });
+
+            _imageSelectionRectangle = _labelIndex.getBoundingRectangle(selectedClusters);
+
+            if (!labelMap)
+                imageProp->setSelectionData(_selectionData, previousImageSelectionRectangle.united(_imageSelectionRectangle));
+        }
+        else {
+
+            // Get selection image, selected indices and selection boundaries from the image dataset
+            _imagesDataset->getSelectionData(_selectionData, _selectedIndices, _imageSelectionRectangle);
+
+            // Assign the scalar data to the prop
+            imageProp->setSelectionData(_selectionData, previousImageSelectionRectangle.united(_imageSelectionRectangle));
+        }
 
         // Notify others that the selection changed
         emit selectionChanged(_selectedIndices);
 
         // Render layer
-        invalidate();
+        invalidateSelection();
     }
     catch (std::exception& e)
     {
@@ -1004,6 +1376,49 @@ void Layer::computeSelectionIndices()
     }
 }
 
+void Layer::updateLabelIndex()
+{
+    auto& scalarChannelAction = _imageSettingsAction.getScalarChannel1Action();
+
+    // The cluster indices did not change since the index was built
+    if (scalarChannelAction.getScalarDataGeneration() != 0 && scalarChannelAction.getScalarDataGeneration() == _labelIndexGeneration)
+        return;
+
+    _labelIndexGeneration = scalarChannelAction.getScalarDataGeneration();
+
+    const auto imageWidth       = _imagesDataset->getImageSize().width();
+    const auto numberOfClusters = static_cast<std::uint32_t>(Dataset<Clusters>(_sourceDataset)->getClusters().size());
+    const auto& labels          = this->getPropByName<ImageProp>("ImageProp")->getLabels();
+
+    // Label maps keep the labels in the image prop, streamed images only have the floating point cluster indices
+    if (!labels.empty()) {
+        _labelIndex.build(labels, imageWidth, numberOfClusters);
+    }
+    else {
+        const auto& scalarData = scalarChannelAction.getScalarData();
+
+        std::vector<std::uint32_t> scalarLabels(static_cast<std::size_t>(scalarData.size()));
+
+        std::transform(scalarData.begin(), scalarData.end(), scalarLabels.begin(), LabelIndex::toLabel);
+
+        _labelIndex.build(scalarLabels, imageWidth, numberOfClusters);
+    }
+
+    // The pixels of the selected clusters might have changed
+    computeSelectionIndices();
+}
+
+const std::vector<std::uint32_t>& Layer::getClusterGlobalIndices()
+{
+    auto points = _sourceDataset->getDataHierarchyItem().getParent()->getDataset<Points>();
+
+    // Re-build when the clusters changed (cleared) or when the number of input points changed
+    if (_clusterGlobalIndices.size() != points->getNumPoints())
+        points->getGlobalIndices(_clusterGlobalIndices);
+
+    return _clusterGlobalIndices;
+}
+
 std::vector<std::uint32_t>& Layer::getSelectedIndices()
 {
     return _selectedIndices;
@@ -10,6 +10,9 @@
 #include "SelectionAction.h"
 #include "MiscellaneousAction.h"
 #include "SubsetAction.h"
+#include "SelectionBitmap.h"
+#include "LabelIndex.h"
+#include "DimensionCache.h"
 
 #include <util/Serializable.h>
 #include <util/Interpolation.h>
@@ -17,7 +20,11 @@
 #include <Set.h>
 #include <ImageData/Images.h>
 
+#include <atomic>
+#include <memory>
+
 class ImageViewerPlugin;
+class QOpenGLFramebufferObject;
 
 class Layer : public mv::gui::GroupsAction, public Renderable
 {
@@ -75,9 +82,18 @@ public:
     /** Get whether the layer is active or not */
     bool isActive() const;
 
-    /** Invalidates the prop (triggers a re-render of all layers) */
+    /** Get whether the layer resources are ready for rendering (the layer is drawn as a placeholder until then) */
+    bool isRenderable();
+
+    /** Invalidates the image of the layer (requests a frame) */
     void invalidate();
 
+    /** Invalidates the overlays of the layer (requests a frame) */
+    void invalidateOverlays();
+
+    /** Invalidates the selection of the layer (requests a frame) */
+    void invalidateSelection();
+
     /**
      * Squeeze the layer into a rectangle whilst maintaining its aspect ratio
      * @param rectangle Rectangle to squeeze into
@@ -141,9 +157,18 @@ public: // Selection
     /** Publish selection */
     void publishSelection();
 
+    /** Publish the selection from the pinned read back of the selection buffer (deferred to an idle task while the read back is in flight) */
+    void publishPinnedSelection();
+
     /** Compute the selected indices */
     void computeSelectionIndices();
 
+    /** Re-build the label index when the cluster indices changed (clusters data only) */
+    void updateLabelIndex();
+
+    /** Get the global indices of the cluster input points (cached until the clusters change) */
+    const std::vector<std::uint32_t>& getClusterGlobalIndices();
+
     /** Get indices of the selected pixels */
     std::vector<std::uint32_t>& getSelectedIndices();
 
@@ -178,6 +203,12 @@ protected: // Rendering
      */
     void render(const QMatrix4x4& modelViewProjectionMatrix) override;
 
+    /**
+     * Composites the layer from its cached render target, the props are only rendered into the target when the layer or the view changed
+     * @param modelViewProjectionMatrix Model view projection matrix
+     */
+    void composite(const QMatrix4x4& modelViewProjectionMatrix);
+
     /** Update the model transformation matrix (used in OpenGL) */
     void updateModelMatrix();
 
@@ -188,6 +219,18 @@ protected: // Rendering
      */
     void setColorMapImage(const QImage& colorMapImage, const InterpolationType& interpolationType);
 
+    /**
+     * Set the label colors (clusters data only)
+     * @param labelColors Colors by label (cluster index)
+     */
+    void setLabelColors(const QVector<QColor>& labelColors);
+
+    /**
+     * Set whether only the selected clusters are shown (clusters data only)
+     * @param selectedLabelsOnly Whether to hide clusters that are not selected
+     */
+    void setSelectedLabelsOnly(bool selectedLabelsOnly);
+
 protected: // Miscellaneous
 
     /** Update the view plugin window title when activated or when the layer name changes */
@@ -218,6 +261,26 @@ public: /** Action getters */
     MiscellaneousAction& getMiscellaneousAction() { return _miscellaneousAction; }
     SubsetAction& getSubsetAction() { return _subsetAction; }
 
+public: // Caching
+
+    /** Get the cache of extracted dimension images */
+    DimensionCache& getDimensionCache() { return _dimensionCache; }
+
+    /**
+     * (Re)upload all dimensions to the resident dimensions texture array of the image prop when enabled and within budget
+     * Dimensions are extracted on worker threads and uploaded one by one, channels switch to the texture array as soon as their dimension is resident
+     */
+    void updateResidentDimensions();
+
+protected:
+
+    /**
+     * Point the image prop to the current dimension of \p channelAction
+     * Only changes a shader uniform when the dimension is resident, uploads the channel scalar data otherwise
+     * @param channelAction Reference to scalar channel action
+     */
+    void updateChannelDimension(ScalarChannelAction& channelAction);
+
 signals:
 
     /**
@@ -226,20 +289,43 @@ signals:
      */
     void selectionChanged(const std::vector<std::uint32_t>& selectedIndices);
 
+    /**
+     * Signals that a new frame of the channel with \p channelIndex was painted
+     * @param channelIndex Channel index
+     */
+    void channelFramePresented(std::uint32_t channelIndex);
+
+    /**
+     * Signals that a streamed frame of the channel with \p channelIndex was dropped (e.g. because the upload ring was full)
+     * @param channelIndex Channel index
+     */
+    void channelFrameDropped(std::uint32_t channelIndex);
+
 protected:
-    ImageViewerPlugin*                  _imageViewerPlugin;             /** Pointer to image viewer plugin */
-    bool                                _active;                        /** Whether the layer is active (editable) */
-    mv::Dataset<Images>                 _imagesDataset;                 /** Smart pointer to images dataset */
-    mv::Dataset<mv::DatasetImpl>        _sourceDataset;                 /** Smart pointer to source dataset of the images */
-    std::vector<std::uint32_t>          _selectedIndices;               /** Indices of the selected pixels */
-    GeneralAction                       _generalAction;                 /** General action */
-    ImageSettingsAction                 _imageSettingsAction;           /** Image settings action */
-    SelectionAction                     _selectionAction;               /** Selection action */
-    MiscellaneousAction                 _miscellaneousAction;           /** Miscellaneous action */
-    SubsetAction                        _subsetAction;                  /** Subset action */
-    std::vector<std::uint8_t>           _selectionData;                 /** Selection data for selection prop */
-    QRect                               _imageSelectionRectangle;       /** Selection boundaries in image coordinates */
-    std::vector<std::uint8_t>           _maskData;                      /** Mask data for the image */
+    ImageViewerPlugin*                             _imageViewerPlugin;             /** Pointer to image viewer plugin */
+    bool                                           _active;                        /** Whether the layer is active (editable) */
+    mv::Dataset<Images>                            _imagesDataset;                 /** Smart pointer to images dataset */
+    mv::Dataset<mv::DatasetImpl>                   _sourceDataset;                 /** Smart pointer to source dataset of the images */
+    std::vector<std::uint32_t>                     _selectedIndices;               /** Indices of the selected pixels */
+    GeneralAction                                  _generalAction;                 /** General action */
+    ImageSettingsAction                            _imageSettingsAction;           /** Image settings action */
+    SelectionAction                                _selectionAction;               /** Selection action */
+    MiscellaneousAction                            _miscellaneousAction;           /** Miscellaneous action */
+    SubsetAction                                   _subsetAction;                  /** Subset action */
+    std::vector<std::uint8_t>                      _selectionData;                 /** Selection data for selection prop */
+    QRect                                          _imageSelectionRectangle;       /** Selection boundaries in image coordinates */
+    std::vector<std::uint8_t>                      _maskData;                      /** Mask data for the image */
+    SelectionBitmap                                _maskBitmap;                    /** Mask data packed as bitmap (one bit per pixel) */
+    SelectionBitmap                                _pixelsBitmap;                  /** Pixel selection of the last publish (only valid in the range that was read back) */
+    SelectionBitmap                                _selectionBitmap;               /** Points selection of the source dataset packed as bitmap (one bit per pixel) */
+    bool                                           _selectionBitmapOutdated;       /** Whether the points selection changed since the selection bitmap was synchronized */
+    DimensionCache                                 _dimensionCache;                /** Least-recently-used cache of extracted dimension images */
+    std::shared_ptr<std::atomic<std::uint64_t>>    _residentDimensionsRequest;     /** Incremented for each resident dimensions upload so that outdated uploads are cancelled (shared with the workers) */
+    std::int32_t                                   _numberOfResidentDimensions;    /** Number of dimensions that are uploaded to the resident dimensions texture array */
+    std::unique_ptr<QOpenGLFramebufferObject>      _renderTarget;                  /** Cached rendering of the props at the current view (premultiplied alpha) */
+    LabelIndex                                     _labelIndex;                    /** Pixel runs per cluster (clusters data only) */
+    std::uint64_t                                  _labelIndexGeneration;          /** Scalar data generation of the first channel that is indexed */
+    std::vector<std::uint32_t>                     _clusterGlobalIndices;          /** Cached global indices of the cluster input points (empty when out of date) */
 
     friend class ImageViewerWidget;
     friend class ImageSettingsAction;
@@ -519,7 +519,7 @@ void LayersModel::moveLayer(const QModelIndex& layerModelIndex, const std::int32
         else
             insertRow(std::clamp(layerModelIndex.row() + amount, 0, rowCount()), row);
 
-        _imageViewerPlugin->getImageViewerWidget().update();
+        _imageViewerPlugin->getImageViewerWidget().getRenderer().render();
     }
     catch (std::exception& e)
     {
@@ -6,13 +6,17 @@
 #include <QMenu>
 #include <QDebug>
 #include <QOpenGLWidget>
+#include <QOpenGLFunctions>
 #include <QMouseEvent>
 #include <QtNumeric>
 #include <QVector2D>
 #include <QVector3D>
 #include <QVector4D>
 #include <QMatrix4x4>
+#include <QScreen>
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 LayersRenderer::LayersRenderer(QOpenGLWidget* parent) :
@@ -24,8 +28,23 @@ LayersRenderer::LayersRenderer(QOpenGLWidget* parent) :
     _zoomRectangleTopLeftAnimation(this, "zoomRectangleTopLeft"),
     _zoomRectangleSizeAnimation(this, "zoomRectangleSize"),
     _animationEnabled(),
+    _loader(this),
+    _shaderProgramCache(_loader, this),
+    _textureBlitter(),
+    _colorMapAtlas(),
     _zoomRectangleTopLeft(),
-    _zoomRectangleSize()
+    _zoomRectangleSize(),
+    _dirtySubsystems(),
+    _dirtyRenderables(),
+    _frameSubsystems(),
+    _frameRenderables(),
+    _framePending(false),
+    _frameTimer(),
+    _frameTimeoutTimer(),
+    _frameClock(),
+    _idleTasks(),
+    _idleTimer(),
+    _frameBudget(4)
 {
     _parallelAnimationGroup.addAnimation(&_zoomRectangleTopLeftAnimation);
     _parallelAnimationGroup.addAnimation(&_zoomRectangleSizeAnimation);
@@ -45,7 +64,30 @@ LayersRenderer::LayersRenderer(QOpenGLWidget* parent) :
 
     // Re-render when the zoom rectangle changes
     connect(this, &LayersRenderer::zoomRectangleChanged, this, [this]() {
-        getParentWidget()->update();
+        requestFrame(View);
+    });
+
+    _frameTimer.setSingleShot(true);
+    _frameTimer.setTimerType(Qt::PreciseTimer);
+
+    _frameTimeoutTimer.setSingleShot(true);
+    _frameTimeoutTimer.setInterval(frameTimeout);
+
+    _idleTimer.setSingleShot(true);
+    _idleTimer.setInterval(0);
+
+    connect(&_frameTimer, &QTimer::timeout, this, &LayersRenderer::scheduleFrame);
+    connect(&_idleTimer, &QTimer::timeout, this, &LayersRenderer::runIdleTasks);
+
+    // A paint might never be delivered (e.g. when the viewer is minimized or occluded), which would block frames and idle tasks indefinitely
+    connect(&_frameTimeoutTimer, &QTimer::timeout, this, [this]() -> void {
+        if (!_framePending)
+            return;
+
+        _framePending = false;
+
+        if (!_idleTasks.empty())
+            _idleTimer.start(0);
     });
 
     // Send _parallelAnimationGroup::finished outwards, used in e.g. when view ROI is set internally to send ROI after animation is finished
@@ -59,7 +101,186 @@ void LayersRenderer::init()
 
 void LayersRenderer::render()
 {
-    static_cast<QOpenGLWidget*>(parent())->update();
+    requestFrame(View);
+}
+
+void LayersRenderer::destroy()
+{
+    if (_textureBlitter.isCreated())
+        _textureBlitter.destroy();
+
+    _colorMapAtlas.destroy();
+}
+
+void LayersRenderer::requestFrame(const Subsystems& subsystems, const Renderable* renderable /*= nullptr*/)
+{
+    if (renderable == nullptr)
+        _dirtySubsystems |= subsystems;
+    else
+        _dirtyRenderables[renderable] |= subsystems;
+
+    scheduleFrame();
+}
+
+LayersRenderer::Subsystems LayersRenderer::getDirtySubsystems(const Renderable* renderable /*= nullptr*/) const
+{
+    if (renderable == nullptr)
+        return _frameSubsystems;
+
+    return _frameSubsystems | _frameRenderables.value(renderable);
+}
+
+bool LayersRenderer::isDirty(const Renderable* renderable) const
+{
+    return _frameRenderables.value(renderable) != Subsystems() || (_frameSubsystems & ~Subsystems(Overlays)) != Subsystems();
+}
+
+void LayersRenderer::compositeTexture(GLuint texture)
+{
+    if (!_textureBlitter.isCreated() && !_textureBlitter.create())
+        throw std::runtime_error("Unable to create the texture blitter");
+
+    auto functions = getOpenGLContext()->functions();
+
+    const auto depthTestEnabled = functions->glIsEnabled(GL_DEPTH_TEST);
+
+    // Layers are composited in order, so they must not be depth tested against each other
+    functions->glDisable(GL_DEPTH_TEST);
+    functions->glEnable(GL_BLEND);
+    functions->glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    _textureBlitter.bind();
+    {
+        // The identity transform covers the whole viewport
+        _textureBlitter.blit(texture, QMatrix4x4(), QOpenGLTextureBlitter::OriginBottomLeft);
+    }
+    _textureBlitter.release();
+
+    functions->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    if (depthTestEnabled)
+        functions->glEnable(GL_DEPTH_TEST);
+}
+
+void LayersRenderer::beginFrame()
+{
+    // Requests that are made while painting (e.g. for tiles that are still streaming) apply to the next frame
+    _frameSubsystems    = _dirtySubsystems;
+    _frameRenderables   = _dirtyRenderables;
+
+    _dirtySubsystems = Subsystems();
+
+    _dirtyRenderables.clear();
+}
+
+void LayersRenderer::frameRendered()
+{
+    _framePending = false;
+
+    _frameTimeoutTimer.stop();
+
+    _frameSubsystems = Subsystems();
+
+    _frameRenderables.clear();
+    _frameClock.restart();
+
+    // Work that was requested during the frame runs once it is presented
+    if (!_idleTasks.empty())
+        _idleTimer.start(0);
+
+    // Frames that were requested during the paint were not scheduled yet
+    if (_dirtySubsystems != Subsystems() || !_dirtyRenderables.isEmpty())
+        scheduleFrame();
+}
+
+void LayersRenderer::requestIdleTask(QObject* owner, const QString& name, const std::function<void()>& task)
+{
+    // Replace the pending task with the same owner and name (only the latest state matters)
+    const auto it = std::find_if(_idleTasks.begin(), _idleTasks.end(), [owner, &name](const IdleTask& idleTask) -> bool {
+        return idleTask._owner == owner && idleTask._name == name;
+    });
+
+    if (it != _idleTasks.end())
+        it->_task = task;
+    else
+        _idleTasks.push_back({ owner, name, task });
+
+    // Tasks are postponed until the pending frame is painted
+    if (!_framePending)
+        _idleTimer.start(0);
+}
+
+std::int32_t LayersRenderer::getFrameBudget() const
+{
+    return _frameBudget;
+}
+
+void LayersRenderer::setFrameBudget(const std::int32_t& frameBudget)
+{
+    _frameBudget = std::max(1, frameBudget);
+}
+
+void LayersRenderer::scheduleFrame()
+{
+    // A paint was issued already, dirty subsystems are picked up by it
+    if (_framePending)
+        return;
+
+    const auto remainingTime = _frameClock.isValid() ? getRefreshInterval() - static_cast<std::int32_t>(_frameClock.elapsed()) : 0;
+
+    // Not more than one paint per refresh interval
+    if (remainingTime > 0) {
+        if (!_frameTimer.isActive())
+            _frameTimer.start(remainingTime);
+
+        return;
+    }
+
+    // A hidden viewer does not paint, so the paint would never be acknowledged
+    _framePending = getParentWidget()->isVisible();
+
+    // Release the pending frame when the paint does not happen in time
+    if (_framePending)
+        _frameTimeoutTimer.start();
+
+    getParentWidget()->update();
+}
+
+void LayersRenderer::runIdleTasks()
+{
+    // Visual work goes first
+    if (_framePending)
+        return;
+
+    QElapsedTimer budgetClock;
+
+    budgetClock.start();
+
+    // Tasks that are requested by the tasks that run now (e.g. to poll a transfer again) do not run in this pass
+    auto numberOfTasks = _idleTasks.size();
+
+    while (numberOfTasks > 0 && !_idleTasks.empty() && budgetClock.elapsed() < _frameBudget) {
+        const auto idleTask = _idleTasks.front();
+
+        _idleTasks.erase(_idleTasks.begin());
+
+        numberOfTasks--;
+
+        if (!idleTask._owner.isNull())
+            idleTask._task();
+    }
+
+    // Continue in the next event loop iteration (or after the next frame), requested tasks wait for the next refresh interval
+    if (!_idleTasks.empty() && !_framePending)
+        _idleTimer.start(numberOfTasks > 0 ? 0 : getRefreshInterval());
+}
+
+std::int32_t LayersRenderer::getRefreshInterval() const
+{
+    const auto screen       = getParentWidget()->screen();
+    const auto refreshRate  = screen != nullptr ? screen->refreshRate() : 60.0;
+
+    return static_cast<std::int32_t>(std::floor(1000.0 / std::max(1.0, refreshRate)));
 }
 
 QVector3D LayersRenderer::getScreenPointToWorldPosition(const QMatrix4x4& modelViewMatrix, const QPoint& screenPoint) const
@@ -305,6 +526,21 @@ void LayersRenderer::releaseOpenGLContext()
     getParentWidget()->doneCurrent();
 }
 
+GLLoader& LayersRenderer::getLoader()
+{
+    return _loader;
+}
+
+ShaderProgramCache& LayersRenderer::getShaderProgramCache()
+{
+    return _shaderProgramCache;
+}
+
+ColorMapAtlas& LayersRenderer::getColorMapAtlas()
+{
+    return _colorMapAtlas;
+}
+
 QOpenGLWidget* LayersRenderer::getParentWidget() const
 {
     return dynamic_cast<QOpenGLWidget*>(parent());
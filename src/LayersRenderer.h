@@ -1,11 +1,23 @@
 #pragma once
 
+#include "GLLoader.h"
+#include "ShaderProgramCache.h"
+#include "ColorMapAtlas.h"
+
 #include <renderers/Renderer.h>
 
 #include <QVector2D>
 #include <QParallelAnimationGroup>
 #include <QPropertyAnimation>
 #include <QRectF>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
+#include <QOpenGLTextureBlitter>
+
+#include <functional>
+#include <vector>
 
 class QMouseEvent;
 class QWheelEvent;
@@ -20,6 +32,10 @@ class Renderable;
  *
  * Class for rendering image layers on the screen using the layers model and OpenGL
  *
+ * Frames are scheduled rather than painted on demand: frame requests mark subsystems (of the view or of individual layers) dirty
+ * and are coalesced into at most one paint per vertical refresh interval. Non-visual work (e.g. publishing the region of interest)
+ * is deferred to idle tasks, which run after a frame is presented within a configurable time budget per frame.
+ *
  * @author Thomas Kroes
  */
 class LayersRenderer : public mv::Renderer
@@ -29,6 +45,23 @@ class LayersRenderer : public mv::Renderer
     Q_PROPERTY(QPointF zoomRectangleTopLeft MEMBER _zoomRectangleTopLeft NOTIFY zoomRectangleChanged)
     Q_PROPERTY(QSizeF zoomRectangleSize MEMBER _zoomRectangleSize NOTIFY zoomRectangleChanged)
 
+public:
+
+    /** Subsystems that can be marked dirty by a frame request */
+    enum Subsystem {
+        View        = 0x0001,       /** Navigation (zoom rectangle) and viewport */
+        Textures    = 0x0002,       /** Layer image content (scalar data, display ranges, color maps) */
+        Overlays    = 0x0004,       /** Layer overlays (bounds, labels and selection overlay styling) */
+        Selection   = 0x0008,       /** Layer selection (selection tool buffer and selected pixels) */
+
+        All = View | Textures | Overlays | Selection
+    };
+
+    Q_DECLARE_FLAGS(Subsystems, Subsystem)
+
+    /** Time in milliseconds after which an issued paint that was not delivered no longer blocks frames and idle tasks */
+    static constexpr std::int32_t frameTimeout = 250;
+
 public: // Construction
 
     /**
@@ -40,11 +73,11 @@ public: // Construction
     /** Initialize the renderer */
     void init() override;
 
-    /** Renders the layers */
+    /** Renders the layers (requests a frame in which the view is dirty) */
     void render() override;
     
-    /** Destroys the renderer */
-    void destroy() override {};
+    /** Destroys the renderer (releases the OpenGL resources of the compositor) */
+    void destroy() override;
 
     /** Resizes the renderer */
     void resize(QSize renderSize) override {};
@@ -170,6 +203,70 @@ public: // Navigation
      */
     void setAnimationEnabled(const bool& animationEnabled);
 
+public: // Frame scheduling
+
+    /**
+     * Request a frame in which \p subsystems are dirty, requests are coalesced into at most one paint per vertical refresh interval
+     * @param subsystems Dirty subsystems
+     * @param renderable Renderable (layer) to which the dirty subsystems apply (applies to all renderables when nullptr)
+     */
+    void requestFrame(const Subsystems& subsystems, const Renderable* renderable = nullptr);
+
+    /** Signal that a frame is about to be painted, takes a snapshot of the dirty subsystems for the paint (call at the start of the paint) */
+    void beginFrame();
+
+    /**
+     * Get the subsystems of \p renderable that are dirty in the frame that is being painted
+     * @param renderable Renderable (layer), only subsystems that apply to all renderables are returned when nullptr
+     * @return Dirty subsystems
+     */
+    Subsystems getDirtySubsystems(const Renderable* renderable = nullptr) const;
+
+    /**
+     * Get whether the cached rendering of \p renderable is outdated in the frame that is being painted
+     * Subsystems that are marked dirty for all renderables invalidate every cached rendering, except for overlays (these are painted on top)
+     * @param renderable Renderable (layer)
+     * @return Whether \p renderable has to be re-rendered
+     */
+    bool isDirty(const Renderable* renderable) const;
+
+    /**
+     * Composite \p texture (with premultiplied alpha) over the whole viewport of the current framebuffer
+     * @param texture OpenGL texture name
+     */
+    void compositeTexture(GLuint texture);
+
+    /** Signal that a frame was painted, schedules the next frame when frames were requested during the paint and resumes the idle tasks (call at the end of the paint) */
+    void frameRendered();
+
+    /**
+     * Run \p task when the renderer is idle, a task with the same \p owner and \p name that is still pending is replaced
+     * @param owner Owner of the task, the task is dropped when the owner is destroyed
+     * @param name Name of the task (unique per owner)
+     * @param task Task to run on the GUI thread
+     */
+    void requestIdleTask(QObject* owner, const QString& name, const std::function<void()>& task);
+
+    /** Get the time budget for idle tasks per frame in milliseconds */
+    std::int32_t getFrameBudget() const;
+
+    /**
+     * Set the time budget for idle tasks per frame to \p frameBudget milliseconds
+     * @param frameBudget Frame budget in milliseconds
+     */
+    void setFrameBudget(const std::int32_t& frameBudget);
+
+protected: // Frame scheduling
+
+    /** Paint now when the vertical refresh interval since the last frame elapsed, otherwise when it elapses */
+    void scheduleFrame();
+
+    /** Run pending idle tasks until the frame budget is exhausted */
+    void runIdleTasks();
+
+    /** Get the vertical refresh interval of the screen the viewer is on in milliseconds */
+    std::int32_t getRefreshInterval() const;
+
 public: // Miscellaneous
 
     /** Returns the parent widget */
@@ -187,6 +284,15 @@ public: // Miscellaneous
     /** Releases the OpenGL context */
     void releaseOpenGLContext();
 
+    /** Get the loader which creates OpenGL resources in the background */
+    GLLoader& getLoader();
+
+    /** Get the cache of shader programs that are shared by the props of all layers */
+    ShaderProgramCache& getShaderProgramCache();
+
+    /** Get the atlas in which the color maps of all layers are stored */
+    ColorMapAtlas& getColorMapAtlas();
+
 signals:
 
     /** Signals that the zoom rectangle changed */
@@ -203,8 +309,33 @@ protected:
     QPropertyAnimation          _zoomRectangleTopLeftAnimation;     /** Zoom rectangle center property animation */
     QPropertyAnimation          _zoomRectangleSizeAnimation;        /** Zoom rectangle size property animation */
     bool                        _animationEnabled;                  /** Zoom animation enabled */
+    GLLoader                    _loader;                            /** Creates OpenGL resources on a background thread */
+    ShaderProgramCache          _shaderProgramCache;                /** Shader programs shared by all props */
+    QOpenGLTextureBlitter       _textureBlitter;                    /** Composites cached layer renderings */
+    ColorMapAtlas               _colorMapAtlas;                     /** Color maps of all layers */
 
 private:
     QPointF                     _zoomRectangleTopLeft;              /** Zoom rectangle top-left in world coordinates */
     QSizeF                      _zoomRectangleSize;                 /** Zoom rectangle size in world coordinates */
+
+    /** Task that runs when the renderer is idle */
+    struct IdleTask {
+        QPointer<QObject>       _owner;     /** Owner of the task */
+        QString                 _name;      /** Name of the task (unique per owner) */
+        std::function<void()>   _task;      /** Task to run */
+    };
+
+    Subsystems                              _dirtySubsystems;           /** Dirty subsystems that apply to all renderables (requested for the next frame) */
+    QHash<const Renderable*, Subsystems>    _dirtyRenderables;          /** Dirty subsystems per renderable (requested for the next frame) */
+    Subsystems                              _frameSubsystems;           /** Dirty subsystems that apply to all renderables in the frame that is being painted */
+    QHash<const Renderable*, Subsystems>    _frameRenderables;          /** Dirty subsystems per renderable in the frame that is being painted */
+    bool                                    _framePending;              /** Whether a paint was issued and did not happen yet */
+    QTimer                                  _frameTimer;                /** Issues the paint once the refresh interval elapsed */
+    QTimer                                  _frameTimeoutTimer;         /** Releases a pending frame of which the paint was not delivered */
+    QElapsedTimer                           _frameClock;                /** Time since the last frame was painted */
+    std::vector<IdleTask>                   _idleTasks;                 /** Pending idle tasks in request order */
+    QTimer                                  _idleTimer;                 /** Runs the idle tasks from the event loop */
+    std::int32_t                            _frameBudget;               /** Time budget for idle tasks per frame in milliseconds */
 };
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(LayersRenderer::Subsystems)
@@ -0,0 +1,252 @@
+#include "PlaybackAction.h"
+#include "Layer.h"
+
+#include <cmath>
+
+using namespace mv;
+
+PlaybackAction::PlaybackAction(QObject* parent, const QString& title) :
+    GroupAction(parent, title),
+    _layer(nullptr),
+    _playAction(this, "Play", false),
+    _channelAction(this, "Channel", ScalarChannelAction::channelIndexes.values(), ScalarChannelAction::channelIndexes.value(ScalarChannelAction::Channel1)),
+    _firstDimensionAction(this, "First", 0, 0, 0),
+    _lastDimensionAction(this, "Last", 0, 0, 0),
+    _frameRateAction(this, "Frame rate", 1, 60, 10),
+    _loopAction(this, "Loop", true),
+    _achievedFrameRateAction(this, "Achieved"),
+    _timer(),
+    _playbackClock(),
+    _startFrame(0),
+    _currentFrame(0),
+    _statisticsClock(),
+    _numberOfPresentedFrames(0),
+    _numberOfDroppedFrames(0)
+{
+    setConfigurationFlag(WidgetAction::ConfigurationFlag::ForceCollapsedInGroup);
+
+    addAction(&_playAction);
+    addAction(&_channelAction);
+    addAction(&_firstDimensionAction);
+    addAction(&_lastDimensionAction);
+    addAction(&_frameRateAction);
+    addAction(&_loopAction);
+    addAction(&_achievedFrameRateAction);
+
+    _achievedFrameRateAction.setEnabled(false);
+    _achievedFrameRateAction.setConnectionPermissionsToForceNone();
+
+    _frameRateAction.setSuffix(" fps");
+
+    _playAction.setToolTip("Play the channel through the dimension range");
+    _channelAction.setToolTip("Scalar channel that is animated");
+    _firstDimensionAction.setToolTip("First dimension of the playback range");
+    _lastDimensionAction.setToolTip("Last dimension of the playback range");
+    _frameRateAction.setToolTip("Target frame rate, frames are dropped when it cannot be sustained");
+    _loopAction.setToolTip("Restart at the first dimension when the last dimension is reached");
+    _achievedFrameRateAction.setToolTip("Achieved frame rate and the number of dropped frames in the last second");
+
+    _timer.setTimerType(Qt::PreciseTimer);
+
+    connect(&_timer, &QTimer::timeout, this, &PlaybackAction::advance);
+
+    connect(&_playAction, &ToggleAction::toggled, this, [this](bool toggled) -> void {
+        if (toggled)
+            start();
+        else
+            stop();
+    });
+
+    connect(&_frameRateAction, &IntegralAction::valueChanged, this, [this]() -> void {
+
+        // Restart the playback clock from the current frame at the new rate
+        if (_playAction.isChecked())
+            start();
+    });
+}
+
+void PlaybackAction::initialize(Layer* layer)
+{
+    Q_ASSERT(layer != nullptr);
+
+    if (layer == nullptr)
+        return;
+
+    _layer = layer;
+
+    const auto lastDimension = std::max(0, static_cast<std::int32_t>(_layer->getNumberOfImages()) - 1);
+
+    _firstDimensionAction.setRange(0, lastDimension);
+    _lastDimensionAction.setRange(0, lastDimension);
+    _lastDimensionAction.setValue(lastDimension);
+
+    setEnabled(lastDimension > 0);
+
+    // Count the frames of the animated channel that are actually painted, and the frames that are dropped on their way to the screen
+    connect(_layer, &Layer::channelFramePresented, this, [this](std::uint32_t channelIndex) -> void {
+        if (_playAction.isChecked() && static_cast<std::int32_t>(channelIndex) == _channelAction.getCurrentIndex())
+            framePresented();
+    });
+
+    connect(_layer, &Layer::channelFrameDropped, this, [this](std::uint32_t channelIndex) -> void {
+        if (_playAction.isChecked() && static_cast<std::int32_t>(channelIndex) == _channelAction.getCurrentIndex())
+            _numberOfDroppedFrames++;
+    });
+}
+
+ScalarChannelAction& PlaybackAction::getScalarChannelAction()
+{
+    switch (static_cast<ScalarChannelAction::Identifier>(_channelAction.getCurrentIndex()))
+    {
+        case ScalarChannelAction::Channel2:
+            return _layer->getImageSettingsAction().getScalarChannel2Action();
+
+        case ScalarChannelAction::Channel3:
+            return _layer->getImageSettingsAction().getScalarChannel3Action();
+
+        default:
+            break;
+    }
+
+    return _layer->getImageSettingsAction().getScalarChannel1Action();
+}
+
+void PlaybackAction::start()
+{
+    if (_layer == nullptr)
+        return;
+
+    const auto currentDimension = getScalarChannelAction().getDimensionAction().getCurrentIndex();
+
+    _startFrame                 = std::clamp(currentDimension - _firstDimensionAction.getValue(), 0, std::max(0, _lastDimensionAction.getValue() - _firstDimensionAction.getValue()));
+    _currentFrame               = _startFrame;
+    _numberOfPresentedFrames    = 0;
+    _numberOfDroppedFrames      = 0;
+
+    _playbackClock.start();
+    _statisticsClock.start();
+
+    // Tick faster than the frame rate so that frame deadlines are not missed by a whole interval
+    _timer.start(std::max(1, 500 / _frameRateAction.getValue()));
+}
+
+void PlaybackAction::stop()
+{
+    _timer.stop();
+
+    _achievedFrameRateAction.setString("");
+}
+
+void PlaybackAction::advance()
+{
+    auto& scalarChannelAction = getScalarChannelAction();
+
+    const auto firstDimension   = std::min(_firstDimensionAction.getValue(), _lastDimensionAction.getValue());
+    const auto lastDimension    = std::max(_firstDimensionAction.getValue(), _lastDimensionAction.getValue());
+    const auto numberOfFrames   = lastDimension - firstDimension + 1;
+
+    // Frame that should be on screen according to the playback clock
+    auto frame = _startFrame + static_cast<std::int32_t>(std::floor(_playbackClock.elapsed() * _frameRateAction.getValue() / 1000.0));
+
+    if (frame >= numberOfFrames) {
+        if (!_loopAction.isChecked()) {
+            frame = numberOfFrames - 1;
+
+            // Stop once the last frame is requested and presented
+            if (_currentFrame == frame && !scalarChannelAction.isExtracting()) {
+                _playAction.setChecked(false);
+                return;
+            }
+        }
+        else {
+            frame %= numberOfFrames;
+        }
+    }
+
+    if (frame == _currentFrame)
+        return;
+
+    // The previous frame is still on its way, wait instead of queueing up work (the timer ticks faster than the frame rate, so a tick is not a frame)
+    if (scalarChannelAction.isExtracting())
+        return;
+
+    // Each frame that was skipped to catch up with the playback clock is counted as dropped once
+    _numberOfDroppedFrames += std::max(0, ((frame - _currentFrame + numberOfFrames) % numberOfFrames) - 1);
+
+    _currentFrame = frame;
+
+    scalarChannelAction.getDimensionAction().setCurrentIndex(firstDimension + frame);
+}
+
+void PlaybackAction::framePresented()
+{
+    _numberOfPresentedFrames++;
+
+    if (_statisticsClock.elapsed() < 1000)
+        return;
+
+    const auto achievedFrameRate = 1000.0 * _numberOfPresentedFrames / _statisticsClock.elapsed();
+
+    _achievedFrameRateAction.setString(QString("%1 fps (%2 dropped)").arg(QString::number(achievedFrameRate, 'f', 1), QString::number(_numberOfDroppedFrames)));
+
+    _numberOfPresentedFrames    = 0;
+    _numberOfDroppedFrames      = 0;
+
+    _statisticsClock.restart();
+}
+
+void PlaybackAction::connectToPublicAction(WidgetAction* publicAction, bool recursive)
+{
+    auto publicPlaybackAction = dynamic_cast<PlaybackAction*>(publicAction);
+
+    Q_ASSERT(publicPlaybackAction != nullptr);
+
+    if (publicPlaybackAction == nullptr)
+        return;
+
+    if (recursive) {
+        actions().connectPrivateActionToPublicAction(&_channelAction, &publicPlaybackAction->getChannelAction(), recursive);
+        actions().connectPrivateActionToPublicAction(&_frameRateAction, &publicPlaybackAction->getFrameRateAction(), recursive);
+        actions().connectPrivateActionToPublicAction(&_loopAction, &publicPlaybackAction->getLoopAction(), recursive);
+    }
+
+    GroupAction::connectToPublicAction(publicAction, recursive);
+}
+
+void PlaybackAction::disconnectFromPublicAction(bool recursive)
+{
+    if (!isConnected())
+        return;
+
+    if (recursive) {
+        actions().disconnectPrivateActionFromPublicAction(&_channelAction, recursive);
+        actions().disconnectPrivateActionFromPublicAction(&_frameRateAction, recursive);
+        actions().disconnectPrivateActionFromPublicAction(&_loopAction, recursive);
+    }
+
+    GroupAction::disconnectFromPublicAction(recursive);
+}
+
+void PlaybackAction::fromVariantMap(const QVariantMap& variantMap)
+{
+    GroupAction::fromVariantMap(variantMap);
+
+    _channelAction.fromParentVariantMap(variantMap);
+    _firstDimensionAction.fromParentVariantMap(variantMap);
+    _lastDimensionAction.fromParentVariantMap(variantMap);
+    _frameRateAction.fromParentVariantMap(variantMap);
+    _loopAction.fromParentVariantMap(variantMap);
+}
+
+QVariantMap PlaybackAction::toVariantMap() const
+{
+    auto variantMap = GroupAction::toVariantMap();
+
+    _channelAction.insertIntoVariantMap(variantMap);
+    _firstDimensionAction.insertIntoVariantMap(variantMap);
+    _lastDimensionAction.insertIntoVariantMap(variantMap);
+    _frameRateAction.insertIntoVariantMap(variantMap);
+    _loopAction.insertIntoVariantMap(variantMap);
+
+    return variantMap;
+}
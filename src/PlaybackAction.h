@@ -0,0 +1,119 @@
+#pragma once
+
+#include <actions/GroupAction.h>
+#include <actions/ToggleAction.h>
+#include <actions/OptionAction.h>
+#include <actions/IntegralAction.h>
+#include <actions/StringAction.h>
+
+#include <QTimer>
+#include <QElapsedTimer>
+
+class Layer;
+class ScalarChannelAction;
+
+using namespace mv::gui;
+
+/**
+ * Playback action class
+ *
+ * Cine (flip-book) playback of a scalar channel through a range of dimensions (e.g. time points or wavelengths)
+ *
+ * Frames are scheduled from a playback clock, so frames are dropped (rather than slowing down) when the target frame rate cannot be sustained
+ */
+class PlaybackAction : public GroupAction
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * Construct with \p parent object and \p title
+     * @param parent Pointer to parent object
+     * @param title Title
+     */
+    Q_INVOKABLE PlaybackAction(QObject* parent, const QString& title);
+
+    /**
+     * Initialize with \p layer
+     * @param layer Pointer to layer
+     */
+    void initialize(Layer* layer);
+
+    /** Get the scalar channel action that is animated */
+    ScalarChannelAction& getScalarChannelAction();
+
+protected:
+
+    /** Start playback from the current dimension */
+    void start();
+
+    /** Stop playback */
+    void stop();
+
+    /** Advance to the dimension that corresponds to the playback clock */
+    void advance();
+
+    /** Count a presented frame and update the achieved frame rate once per second */
+    void framePresented();
+
+protected: // Linking
+
+    /**
+     * Connect this action to a public action
+     * @param publicAction Pointer to public action to connect to
+     * @param recursive Whether to also connect descendant child actions
+     */
+    void connectToPublicAction(WidgetAction* publicAction, bool recursive) override;
+
+    /**
+     * Disconnect this action from its public action
+     * @param recursive Whether to also disconnect descendant child actions
+     */
+    void disconnectFromPublicAction(bool recursive) override;
+
+public: // Serialization
+
+    /**
+     * Load widget action from variant map
+     * @param Variant map representation of the widget action
+     */
+    void fromVariantMap(const QVariantMap& variantMap) override;
+
+    /**
+     * Save widget action to variant map
+     * @return Variant map representation of the widget action
+     */
+    QVariantMap toVariantMap() const override;
+
+public: // Action getters
+
+    ToggleAction& getPlayAction() { return _playAction; }
+    OptionAction& getChannelAction() { return _channelAction; }
+    IntegralAction& getFirstDimensionAction() { return _firstDimensionAction; }
+    IntegralAction& getLastDimensionAction() { return _lastDimensionAction; }
+    IntegralAction& getFrameRateAction() { return _frameRateAction; }
+    ToggleAction& getLoopAction() { return _loopAction; }
+    StringAction& getAchievedFrameRateAction() { return _achievedFrameRateAction; }
+
+protected:
+    Layer*              _layer;                     /** Pointer to layer */
+    ToggleAction        _playAction;                /** Play/pause action */
+    OptionAction        _channelAction;             /** Animated scalar channel action */
+    IntegralAction      _firstDimensionAction;      /** First dimension of the playback range action */
+    IntegralAction      _lastDimensionAction;       /** Last dimension of the playback range action */
+    IntegralAction      _frameRateAction;           /** Target frame rate action */
+    ToggleAction        _loopAction;                /** Loop playback action */
+    StringAction        _achievedFrameRateAction;   /** Achieved frame rate action (read-only) */
+    QTimer              _timer;                     /** Frame timer */
+    QElapsedTimer       _playbackClock;             /** Time since playback started */
+    std::int32_t        _startFrame;                /** Frame (relative to the first dimension) at which playback started */
+    std::int32_t        _currentFrame;              /** Frame (relative to the first dimension) that was requested last */
+    QElapsedTimer       _statisticsClock;           /** Time since the statistics were reset */
+    std::int32_t        _numberOfPresentedFrames;   /** Number of frames presented since the statistics were reset */
+    std::int32_t        _numberOfDroppedFrames;     /** Number of frames dropped since the statistics were reset */
+};
+
+Q_DECLARE_METATYPE(PlaybackAction)
+
+inline const auto playbackActionMetaTypeId = qRegisterMetaType<PlaybackAction*>("PlaybackAction");
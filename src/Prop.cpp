@@ -2,12 +2,19 @@
 #include "LayersRenderer.h"
 #include "Renderable.h"
 #include "Shape.h"
+#include "ShaderProgramCache.h"
+
+#include <util/Exception.h>
 
 #include <QOpenGLShaderProgram>
 #include <QOpenGLTexture>
 #include <QOpenGLFramebufferObject>
 #include <QDebug>
 
+#include <stdexcept>
+
+using namespace mv::util;
+
 Prop::Prop(Renderable& renderable, const QString& name) :
     _renderable(renderable),
     _initialized(false),
@@ -15,8 +22,10 @@ Prop::Prop(Renderable& renderable, const QString& name) :
     _visible(true),
     _modelMatrix(),
     _shaderPrograms(),
+    _failedShaderPrograms(),
     _textures(),
-    _shapes()
+    _shapes(),
+    _lifetime(std::make_shared<bool>(true))
 {
 }
 
@@ -47,14 +56,100 @@ bool Prop::canRender() const
     return isInitialized() && isVisible();
 }
 
-void Prop::addShaderProgram(const QString& name)
+QSharedPointer<QOpenGLShaderProgram> Prop::getShaderProgramByName(const QString& name)
 {
-    _shaderPrograms.insert(name, QSharedPointer<QOpenGLShaderProgram>::create());
+    return _shaderPrograms.value(name);
 }
 
-QSharedPointer<QOpenGLShaderProgram> Prop::getShaderProgramByName(const QString& name)
+QString Prop::getShaderProgramVariantName(const QString& name, const QStringList& defines)
 {
-    return _shaderPrograms.value(name);
+    if (defines.isEmpty())
+        return name;
+
+    return QString("%1[%2]").arg(name, defines.join(","));
+}
+
+QSharedPointer<QOpenGLShaderProgram> Prop::getShaderProgramVariant(const QString& name, const QStringList& defines, const QString& vertexShader, const QString& fragmentShader)
+{
+    const auto variantName          = getShaderProgramVariantName(name, defines);
+    auto& shaderProgramCache        = getRenderer().getShaderProgramCache();
+
+    // Props with the same settings share the variant
+    if (!_shaderPrograms.contains(variantName))
+        _shaderPrograms.insert(variantName, shaderProgramCache.acquire(vertexShader, fragmentShader, defines));
+
+    auto shaderProgram = getShaderProgramByName(variantName);
+
+    if (shaderProgram->isLinked())
+        return shaderProgram;
+
+    // The failure was reported already, the variant is not compiled again
+    if (_failedShaderPrograms.contains(variantName))
+        return nullptr;
+
+    // Another prop compiles the variant in the background, render again once it is linked
+    if (shaderProgramCache.isCompiling(shaderProgram)) {
+        auto renderer = &getRenderer();
+
+        shaderProgramCache.load(shaderProgram, renderer, [renderer]() -> void {
+            renderer->render();
+        });
+
+        return nullptr;
+    }
+
+    // Compile the variant on first use, a variant that fails to link is reported once instead of in every frame
+    if (!shaderProgramCache.compile(shaderProgram)) {
+        qWarning() << "Unable to compile and link" << variantName << "shader program of" << _name << ":" << shaderProgram->log();
+
+        _failedShaderPrograms.insert(variantName);
+
+        return nullptr;
+    }
+
+    return shaderProgram;
+}
+
+void Prop::loadShaderProgram(const QString& name, const QString& vertexShader, const QString& fragmentShader, const std::function<void()>& linked, const QStringList& defines /*= QStringList()*/)
+{
+    auto& shaderProgramCache = getRenderer().getShaderProgramCache();
+
+    _shaderPrograms.insert(name, shaderProgramCache.acquire(vertexShader, fragmentShader, defines));
+
+    auto shaderProgram  = getShaderProgramByName(name);
+    auto lifetime       = std::weak_ptr<bool>(_lifetime);
+
+    // Finishes the prop in the viewer context
+    const auto finish = [this, name, shaderProgram, lifetime, linked]() -> void {
+
+        // The prop was destroyed while its shader program was compiled
+        if (lifetime.expired())
+            return;
+
+        try {
+            getRenderer().bindOpenGLContext();
+            {
+                // Compiles in the viewer context when the loader did not run the job
+                if (!getRenderer().getShaderProgramCache().compile(shaderProgram))
+                    throw std::runtime_error(QString("Unable to compile and link the %1 shader program: %2").arg(name, shaderProgram->log()).toStdString());
+
+                linked();
+            }
+            getRenderer().releaseOpenGLContext();
+
+            // Render now that the prop is ready
+            getRenderer().render();
+        }
+        catch (std::exception& e)
+        {
+            exceptionMessageBox(QString("Unable to load %1 shader program of %2").arg(name, _name), e);
+        }
+        catch (...) {
+            exceptionMessageBox(QString("Unable to load %1 shader program of %2").arg(name, _name));
+        }
+    };
+
+    shaderProgramCache.load(shaderProgram, &getRenderer(), finish);
 }
 
 void Prop::addTexture(const QString& name, const QOpenGLTexture::Target& target)
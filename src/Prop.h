@@ -2,10 +2,15 @@
 
 #include <QMatrix4x4>
 #include <QMap>
+#include <QSet>
 #include <QSharedPointer>
+#include <QStringList>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLTexture>
 
+#include <functional>
+#include <memory>
+
 class LayersRenderer;
 class Renderable;
 class Shape;
@@ -143,18 +148,43 @@ protected: // Shape management
 
 protected: // Shader program management
 
-    /**
-    * Add shader program by name
-    * @param name Name of the shader program
-    */
-    void addShaderProgram(const QString& name);
-
     /**
     * Get shader program by name
     * @param name Name of the shader program
     */
     QSharedPointer<QOpenGLShaderProgram> getShaderProgramByName(const QString& name);
 
+    /**
+     * Acquire the shared shader program for \p vertexShader and \p fragmentShader from the renderer cache under \p name, and compile and link it on the loader thread unless another prop did so already
+     * \p linked is invoked on the GUI thread with the viewer context bound once the program is linked, e.g. to configure vertex arrays and mark the prop initialized
+     * @param name Name of the shader program
+     * @param vertexShader Vertex shader source code
+     * @param fragmentShader Fragment shader source code
+     * @param linked Invoked when the shader program is linked
+     * @param defines Preprocessor definitions with which the shaders are specialized
+     */
+    void loadShaderProgram(const QString& name, const QString& vertexShader, const QString& fragmentShader, const std::function<void()>& linked, const QStringList& defines = QStringList());
+
+protected: // Shader variants
+
+    /**
+     * Get the name of the variant of shader program \p name that is specialized with \p defines
+     * @param name Name of the shader program
+     * @param defines Preprocessor definitions (e.g. "MASKED" or "NUMBER_OF_CHANNELS 3")
+     * @return Shader program variant name (\p name when there are no definitions)
+     */
+    static QString getShaderProgramVariantName(const QString& name, const QStringList& defines);
+
+    /**
+     * Get the variant of shader program \p name that is specialized with \p defines from the renderer cache, it is compiled on first use (the OpenGL context must be bound)
+     * @param name Name of the shader program
+     * @param defines Preprocessor definitions
+     * @param vertexShader Vertex shader source code (without definitions)
+     * @param fragmentShader Fragment shader source code (without definitions)
+     * @return Linked shader program variant (nullptr while another prop compiles it on the loader thread, the renderer renders again once it is linked, or when it failed to link)
+     */
+    QSharedPointer<QOpenGLShaderProgram> getShaderProgramVariant(const QString& name, const QStringList& defines, const QString& vertexShader, const QString& fragmentShader);
+
 protected: // Texture management
 
     /**
@@ -177,7 +207,9 @@ protected:
 
 private:
     QMatrix4x4                                              _modelMatrix;           /** Transformation matrix */
-    QMap<QString, QSharedPointer<QOpenGLShaderProgram>>     _shaderPrograms;        /** OpenGL shader programs */
+    QMap<QString, QSharedPointer<QOpenGLShaderProgram>>     _shaderPrograms;        /** Handles to shared OpenGL shader programs */
+    QSet<QString>                                           _failedShaderPrograms;  /** Names of the shader program variants that failed to link (reported once) */
     QMap<QString, QSharedPointer<QOpenGLTexture>>           _textures;              /** OpenGL textures */
     QMap<QString, QSharedPointer<Shape>>                    _shapes;                /** Shapes */
+    std::shared_ptr<bool>                                   _lifetime;              /** Expires when the prop is destroyed, guards callbacks of loader jobs */
 };
\ No newline at end of file
@@ -8,6 +8,10 @@
 #include <PointData/PointData.h>
 #include <ClusterData/ClusterData.h>
 
+#include <QCoreApplication>
+#include <QPointer>
+#include <QThreadPool>
+
 using namespace mv;
 
 const QMap<ScalarChannelAction::Identifier, QString> ScalarChannelAction::channelIndexes = {
@@ -26,7 +30,17 @@ ScalarChannelAction::ScalarChannelAction(QObject* parent, const QString& title)
     _scalarData(),
     _scalarDataRange({ 0.0f, 0.0f }),
     _colorSpaceRange({ 0.0f, 0.0f }),
-    _useColorSpaceRange(false) 
+    _useColorSpaceRange(false),
+    _scalarDataGeneration(0),
+    _extractedDimension(-1),
+    _extractedSubsample(0),
+    _latestExtractionRequest(std::make_shared<std::atomic<std::uint64_t>>(0)),
+    _prefetchesCancelled(std::make_shared<std::atomic<bool>>(false)),
+    _dimensionHistory(),
+    _pendingPrefetches(),
+    _awaitingPrefetch(false),
+    _invalidations(0),
+    _extracting(false)
 {
     setDefaultWidgetFlags(GroupAction::Horizontal);
     setShowLabels(false);
@@ -43,12 +57,20 @@ ScalarChannelAction::ScalarChannelAction(QObject* parent, const QString& title)
     connect(&_enabledAction, &ToggleAction::toggled, this, updateEnabled);
 
     connect(&_windowLevelAction, &WindowLevelAction::changed, this, [this]() {
-        emit changed(*this);
+        emit displayRangeChanged(*this);
     });
 
     updateEnabled();
 }
 
+ScalarChannelAction::~ScalarChannelAction()
+{
+    // Supersede the extraction request and cancel the prefetches so that queued jobs do not start extracting
+    ++(*_latestExtractionRequest);
+
+    *_prefetchesCancelled = true;
+}
+
 void ScalarChannelAction::initialize(Layer* layer, const Identifier& identifier)
 {
     Q_ASSERT(layer != nullptr);
@@ -81,6 +103,7 @@ void ScalarChannelAction::initialize(Layer* layer, const Identifier& identifier)
 
     connect(&_layer->getImageSettingsAction().getSubsampleFactorAction(), &IntegralAction::valueChanged, this, resizeScalars);
     connect(&_dimensionAction, &OptionAction::currentIndexChanged, this, &ScalarChannelAction::computeScalarData);
+    connect(&_dimensionAction, &OptionAction::currentIndexChanged, this, &ScalarChannelAction::prefetchDimensions);
 
     computeScalarData();
 
@@ -113,6 +136,11 @@ const QPair<float, float>& ScalarChannelAction::getScalarDataRange() const
     return _scalarDataRange;
 }
 
+std::uint64_t ScalarChannelAction::getScalarDataGeneration() const
+{
+    return _scalarDataGeneration;
+}
+
 void ScalarChannelAction::setColorSpaceRange(bool status, float lower, float upper)
 {
     _useColorSpaceRange = status;
@@ -121,9 +149,14 @@ void ScalarChannelAction::setColorSpaceRange(bool status, float lower, float upp
 }
 
 QPair<float, float> ScalarChannelAction::getDisplayRange()
+{
+    return getDisplayRange(_scalarDataRange);
+}
+
+QPair<float, float> ScalarChannelAction::getDisplayRange(const QPair<float, float>& scalarDataRange)
 {
     QPair<float, float> displayRange;
-    QPair<float, float> dataRange = _scalarDataRange;
+    QPair<float, float> dataRange = scalarDataRange;
 
     if (_useColorSpaceRange)
     {
@@ -165,9 +198,92 @@ void ScalarChannelAction::computeScalarData()
                 if (_dimensionAction.getCurrentIndex() < 0)
                     break;
 
-                getImages()->getScalarData(_dimensionAction.getCurrentIndex(), _scalarData, _scalarDataRange);
+                const auto subsampleFactor = _layer->getImageSettingsAction().getSubsampleFactorAction().getValue();
 
-                break;
+                // Only extract when the dimension or subsampling changed, or when the data is out of date
+                if (_dimensionAction.getCurrentIndex() == _extractedDimension && subsampleFactor == _extractedSubsample)
+                    break;
+
+                _extractedDimension = _dimensionAction.getCurrentIndex();
+                _extractedSubsample = subsampleFactor;
+
+                // Supersede the extraction request that might still be in flight
+                const auto extractionRequest        = ++(*_latestExtractionRequest);
+                const auto latestExtractionRequest  = _latestExtractionRequest;
+                const auto dimensionIndex           = static_cast<std::uint32_t>(_extractedDimension);
+                const auto cacheKey                 = DimensionCache::Key{ _layer->getImagesDatasetId(), _extractedDimension, _extractedSubsample };
+
+                DimensionCache::Entry cacheEntry;
+
+                _awaitingPrefetch   = false;
+                _extracting         = false;
+
+                // Use the previously extracted dimension image when it is cached
+                if (_layer->getDimensionCache().find(cacheKey, cacheEntry)) {
+                    applyScalarData(cacheEntry._scalarData, cacheEntry._scalarDataRange);
+                    return;
+                }
+
+                // The dimension is already being prefetched, wait for it instead of extracting it twice
+                if (_pendingPrefetches.contains(_extractedDimension)) {
+                    _awaitingPrefetch   = true;
+                    _extracting         = true;
+                    return;
+                }
+
+                auto images = getImages();
+
+                _extracting = true;
+
+                // The action might be destroyed (e.g. the layer is removed) before the job completes
+                QPointer<ScalarChannelAction> guardedAction(this);
+
+                // Extract on a worker thread and hand the scalar data to the action on the GUI thread
+                QThreadPool::globalInstance()->start([guardedAction, images, dimensionIndex, extractionRequest, latestExtractionRequest]() mutable -> void {
+
+                    // Cancelled before the extraction started
+                    if (extractionRequest != latestExtractionRequest->load())
+                        return;
+
+                    QVector<float> scalarData;
+                    QPair<float, float> scalarDataRange;
+
+                    try {
+                        images->getScalarData(dimensionIndex, scalarData, scalarDataRange);
+                    }
+                    catch (std::exception& e)
+                    {
+                        qWarning() << "Unable to extract scalar data:" << e.what();
+                    }
+                    catch (...) {
+                        qWarning() << "Unable to extract scalar data";
+                    }
+
+                    // Cancelled during the extraction
+                    if (extractionRequest != latestExtractionRequest->load())
+                        return;
+
+                    // Hand over to the GUI thread, where the action can be checked safely
+                    QMetaObject::invokeMethod(QCoreApplication::instance(), [guardedAction, extractionRequest, scalarData, scalarDataRange]() -> void {
+                        if (guardedAction.isNull())
+                            return;
+
+                        // Discard when a newer request was made in the meantime
+                        if (extractionRequest != guardedAction->_latestExtractionRequest->load())
+                            return;
+
+                        guardedAction->_extracting = false;
+
+                        // Keep the current scalar data when extraction yielded nothing
+                        if (scalarData.isEmpty())
+                            return;
+
+                        guardedAction->applyScalarData(scalarData, scalarDataRange);
+                    }, Qt::QueuedConnection);
+                }, extractionPriority);
+
+                // The changed signal is emitted once the extraction completes
+                return;
             }
 
             default:
@@ -185,6 +301,191 @@ void ScalarChannelAction::computeScalarData()
     }
 }
 
+bool ScalarChannelAction::isExtracting() const
+{
+    return _extracting;
+}
+
+void ScalarChannelAction::invalidateScalarData()
+{
+    _extractedDimension = -1;
+
+    _invalidations++;
+}
+
+void ScalarChannelAction::applyScalarData(const QVector<float>& scalarData, const QPair<float, float>& scalarDataRange)
+{
+    _scalarData         = scalarData;
+    _scalarDataRange    = scalarDataRange;
+
+    _scalarDataGeneration++;
+
+    _layer->getDimensionCache().insert({ _layer->getImagesDatasetId(), _extractedDimension, _extractedSubsample }, { _scalarData, _scalarDataRange });
+
+    emit changed(*this);
+}
+
+void ScalarChannelAction::prefetchDimensions()
+{
+    try
+    {
+        if (!_enabledAction.isChecked() || _layer == nullptr || !getImages().isValid())
+            return;
+
+        const auto currentDimension = _dimensionAction.getCurrentIndex();
+
+        if (currentDimension < 0)
+            return;
+
+        _dimensionHistory << currentDimension;
+
+        while (_dimensionHistory.count() > prefetchHistorySize)
+            _dimensionHistory.removeFirst();
+
+        auto& dimensionCache = _layer->getDimensionCache();
+
+        const auto subsampleFactor      = _layer->getImageSettingsAction().getSubsampleFactorAction().getValue();
+        const auto numberOfEntryBytes   = static_cast<std::uint64_t>(getImages()->getNumberOfPixels()) * sizeof(float);
+
+        for (const auto& dimension : predictDimensions()) {
+            if (_pendingPrefetches.count() >= maximumNumberOfPrefetches)
+                break;
+
+            if (_pendingPrefetches.contains(dimension))
+                continue;
+
+            // Prefetches may only use free space in the cache, they never evict extracted dimensions
+            if (dimensionCache.getNumberOfBytes() + (_pendingPrefetches.count() + 1) * numberOfEntryBytes > dimensionCache.getBudget())
+                break;
+
+            const auto cacheKey = DimensionCache::Key{ _layer->getImagesDatasetId(), dimension, subsampleFactor };
+
+            DimensionCache::Entry cacheEntry;
+
+            if (dimensionCache.find(cacheKey, cacheEntry))
+                continue;
+
+            _pendingPrefetches << dimension;
+
+            auto images = getImages();
+
+            const auto invalidations = _invalidations;
+
+            const auto prefetchesCancelled = _prefetchesCancelled;
+
+            // The action might be destroyed (e.g. the layer is removed) before the prefetch completes
+            QPointer<ScalarChannelAction> guardedAction(this);
+
+            // Extract with low priority so that the visible dimension is always extracted first
+            QThreadPool::globalInstance()->start([guardedAction, images, dimension, cacheKey, invalidations, prefetchesCancelled]() mutable -> void {
+                QVector<float> scalarData;
+                QPair<float, float> scalarDataRange;
+
+                // Skip the extraction when the action was destroyed before the prefetch started
+                if (prefetchesCancelled->load())
+                    return;
+
+                try {
+                    images->getScalarData(static_cast<std::uint32_t>(dimension), scalarData, scalarDataRange);
+                }
+                catch (std::exception& e)
+                {
+                    qWarning() << "Unable to prefetch scalar data:" << e.what();
+                }
+                catch (...) {
+                    qWarning() << "Unable to prefetch scalar data";
+                }
+
+                // Always report back, the visible dimension might be waiting for this prefetch
+                QMetaObject::invokeMethod(QCoreApplication::instance(), [guardedAction, dimension, cacheKey, invalidations, scalarData, scalarDataRange]() -> void {
+                    if (guardedAction.isNull())
+                        return;
+
+                    guardedAction->prefetchFinished(dimension, cacheKey, invalidations, scalarData, scalarDataRange);
+                }, Qt::QueuedConnection);
+            }, prefetchPriority);
+        }
+    }
+    catch (std::exception& e)
+    {
+        qWarning() << "Unable to prefetch dimensions:" << e.what();
+    }
+    catch (...) {
+        qWarning() << "Unable to prefetch dimensions";
+    }
+}
+
+void ScalarChannelAction::prefetchFinished(std::int32_t dimension, const DimensionCache::Key& cacheKey, std::uint32_t invalidations, const QVector<float>& scalarData, const QPair<float, float>& scalarDataRange)
+{
+    _pendingPrefetches.remove(dimension);
+
+    // The scalar data was invalidated (e.g. the dataset changed) while prefetching
+    const auto outdated = invalidations != _invalidations;
+
+    const auto awaited = _awaitingPrefetch && dimension == _extractedDimension && cacheKey._subsampleFactor == _extractedSubsample;
+
+    if (awaited) {
+        _awaitingPrefetch   = false;
+        _extracting         = false;
+
+        // Fall back to a regular extraction when the prefetch failed or is outdated
+        if (scalarData.isEmpty() || outdated) {
+            invalidateScalarData();
+            computeScalarData();
+        }
+        else {
+            applyScalarData(scalarData, scalarDataRange);
+        }
+
+        return;
+    }
+
+    auto& dimensionCache = _layer->getDimensionCache();
+
+    // Only keep the prefetched dimension when it fits without evicting anything
+    if (!scalarData.isEmpty() && !outdated && dimensionCache.getNumberOfBytes() + static_cast<std::uint64_t>(scalarData.size()) * sizeof(float) <= dimensionCache.getBudget())
+        dimensionCache.insert(cacheKey, { scalarData, scalarDataRange });
+}
+
+QVector<std::int32_t> ScalarChannelAction::predictDimensions() const
+{
+    QVector<std::int32_t> predictedDimensions;
+
+    if (_dimensionHistory.isEmpty())
+        return predictedDimensions;
+
+    const auto numberOfDimensions   = static_cast<std::int32_t>(_layer->getNumberOfImages());
+    const auto currentDimension     = _dimensionHistory.last();
+
+    const auto addDimension = [&predictedDimensions, numberOfDimensions, currentDimension](std::int32_t dimension) -> void {
+        if (dimension >= 0 && dimension < numberOfDimensions && dimension != currentDimension && !predictedDimensions.contains(dimension))
+            predictedDimensions << dimension;
+    };
+
+    // Without a direction, the neighbours are equally likely
+    if (_dimensionHistory.count() < 2 || _dimensionHistory[_dimensionHistory.count() - 2] == currentDimension) {
+        addDimension(currentDimension + 1);
+        addDimension(currentDimension - 1);
+
+        return predictedDimensions;
+    }
+
+    const auto stride = currentDimension - _dimensionHistory[_dimensionHistory.count() - 2];
+
+    // A repeated stride means the user is scrubbing in one direction
+    const auto scrubbing = _dimensionHistory.count() >= 3 && _dimensionHistory[_dimensionHistory.count() - 2] - _dimensionHistory[_dimensionHistory.count() - 3] == stride;
+
+    addDimension(currentDimension + stride);
+
+    if (scrubbing)
+        addDimension(currentDimension + 2 * stride);
+
+    // The user might also flip back to the previous dimension
+    addDimension(currentDimension - stride);
+
+    return predictedDimensions;
+}
+
 Dataset<Images> ScalarChannelAction::getImages()
 {
     if (_layer == nullptr)
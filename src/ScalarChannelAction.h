@@ -1,5 +1,7 @@
 #pragma once
 
+#include "DimensionCache.h"
+
 #include <actions/GroupAction.h>
 #include <actions/ToggleAction.h>
 #include <actions/OptionAction.h>
@@ -7,6 +9,11 @@
 
 #include <ImageData/Images.h>
 
+#include <QSet>
+
+#include <atomic>
+#include <memory>
+
 using namespace mv::gui;
 using namespace mv::util;
 
@@ -37,6 +44,16 @@ public:
     /** Maps channel index enum to name */
     static const QMap<Identifier, QString> channelIndexes;
 
+    /** Number of recent dimension changes from which the prefetcher predicts the next dimensions */
+    static constexpr std::int32_t prefetchHistorySize = 4;
+
+    /** Maximum number of dimensions that are prefetched at the same time */
+    static constexpr std::int32_t maximumNumberOfPrefetches = 2;
+
+    /** Thread pool priorities (the visible dimension is extracted before speculative prefetches) */
+    static constexpr std::int32_t extractionPriority    = 1;
+    static constexpr std::int32_t prefetchPriority      = 0;
+
 public:
 
     /**
@@ -46,6 +63,9 @@ public:
      */
     Q_INVOKABLE ScalarChannelAction(QObject* parent, const QString& title);
 
+    /** Cancels the extraction that might still be in flight */
+    ~ScalarChannelAction() override;
+
     /**
      * Initialize with \p layer, channel \p identifier
      * @param layer Pointer to layer
@@ -73,14 +93,66 @@ public: // Channel data
     /** Get display range */
     QPair<float, float> getDisplayRange();
 
-    /** Compute scalar data for image sequence */
+    /**
+     * Get display range for \p scalarDataRange (e.g. of a dimension that is not extracted yet)
+     * @param scalarDataRange Scalar data range
+     * @return Display range
+     */
+    QPair<float, float> getDisplayRange(const QPair<float, float>& scalarDataRange);
+
+    /**
+     * Get scalar data generation
+     * The generation is incremented each time the scalar data is (re-)extracted, so that consumers only have to upload changed data
+     * @return Scalar data generation (zero when no scalar data was extracted yet)
+     */
+    std::uint64_t getScalarDataGeneration() const;
+
+    /**
+     * Compute scalar data for image sequence (extraction is skipped when the dimension and subsample factor did not change)
+     * Extraction runs on a worker thread, the current scalar data remains available until the changed() signal announces the new data
+     * A newer request supersedes a request that is still in flight, the result of the latter is discarded
+     */
     void computeScalarData();
 
+    /** Returns whether the scalar data of the current dimension is still being extracted (the previous scalar data is still in use) */
+    bool isExtracting() const;
+
+    /** Mark the scalar data out of date so that the next computeScalarData() re-extracts it (e.g. when the dataset changed) */
+    void invalidateScalarData();
+
 protected:
 
     /** Get smart pointer to images dataset */
     mv::Dataset<Images> getImages();
 
+    /**
+     * Assign extracted \p scalarData, add it to the dimension cache and notify listeners
+     * @param scalarData Scalar data
+     * @param scalarDataRange Scalar data range
+     */
+    void applyScalarData(const QVector<float>& scalarData, const QPair<float, float>& scalarDataRange);
+
+protected: // Prefetching
+
+    /** Record the current dimension and speculatively extract the dimensions that are likely to be visited next into the dimension cache */
+    void prefetchDimensions();
+
+    /**
+     * Invoked on the GUI thread when the prefetch of \p dimension completed
+     * @param dimension Prefetched dimension index
+     * @param cacheKey Dimension cache key of the prefetched dimension
+     * @param invalidations Number of invalidations at the time the prefetch was started
+     * @param scalarData Prefetched scalar data (empty when the prefetch failed or was cancelled)
+     * @param scalarDataRange Prefetched scalar data range
+     */
+    void prefetchFinished(std::int32_t dimension, const DimensionCache::Key& cacheKey, std::uint32_t invalidations, const QVector<float>& scalarData, const QPair<float, float>& scalarDataRange);
+
+    /**
+     * Predict the dimensions that are likely to be visited next from the recent dimension changes
+     * @return Predicted dimension indices, most likely first
+     */
+    QVector<std::int32_t> predictDimensions() const;
+
 protected: // Linking
 
     /**
@@ -115,6 +187,9 @@ signals:
     /** Signals the channel changed */
     void changed(ScalarChannelAction& channelAction);
 
+    /** Signals the display range of the channel changed (the scalar data is unchanged) */
+    void displayRangeChanged(ScalarChannelAction& channelAction);
+
 public: // Action getters
 
     OptionAction& getDimensionAction() { return _dimensionAction; }
@@ -122,15 +197,25 @@ public: // Action getters
     WindowLevelAction& getWindowLevelAction() { return _windowLevelAction; }
 
 private:
-    Layer*                  _layer;                 /** Pointer to layer */
-    Identifier              _identifier;            /** Channel index */
-    ToggleAction            _enabledAction;         /** Enabled action */
-    OptionAction            _dimensionAction;       /** Selected dimension action */
-    WindowLevelAction       _windowLevelAction;     /** Window/level action */
-    QVector<float>          _scalarData;            /** Channel scalar data for the specified dimension */
-    QPair<float, float>     _scalarDataRange;       /** Scalar data range */
-    QPair<float, float>     _colorSpaceRange;       /** Color Space range */
-    bool                    _useColorSpaceRange;    /** _scalarDataRange is ignored and instead a color space dependend range is used */
+    Layer*                                         _layer;                      /** Pointer to layer */
+    Identifier                                     _identifier;                 /** Channel index */
+    ToggleAction                                   _enabledAction;              /** Enabled action */
+    OptionAction                                   _dimensionAction;            /** Selected dimension action */
+    WindowLevelAction                              _windowLevelAction;          /** Window/level action */
+    QVector<float>                                 _scalarData;                 /** Channel scalar data for the specified dimension */
+    QPair<float, float>                            _scalarDataRange;            /** Scalar data range */
+    QPair<float, float>                            _colorSpaceRange;            /** Color Space range */
+    bool                                           _useColorSpaceRange;         /** _scalarDataRange is ignored and instead a color space dependend range is used */
+    std::uint64_t                                  _scalarDataGeneration;       /** Incremented each time the scalar data is extracted */
+    std::int32_t                                   _extractedDimension;         /** Dimension of the extracted (or in flight) scalar data (-1 if out of date) */
+    std::int32_t                                   _extractedSubsample;         /** Subsample factor of the extracted (or in flight) scalar data */
+    std::shared_ptr<std::atomic<std::uint64_t>>    _latestExtractionRequest;    /** Latest extraction request identifier (shared with the workers so that superseded requests are cancelled) */
+    std::shared_ptr<std::atomic<bool>>             _prefetchesCancelled;        /** Set on destruction (shared with the workers so that queued prefetches are skipped) */
+    QVector<std::int32_t>                          _dimensionHistory;           /** Recently visited dimensions (oldest first) */
+    QSet<std::int32_t>                             _pendingPrefetches;          /** Dimensions that are being prefetched */
+    bool                                           _awaitingPrefetch;           /** Whether the visible dimension is delivered by a pending prefetch */
+    std::uint32_t                                  _invalidations;              /** Incremented when the scalar data is invalidated, so that outdated prefetches are not cached */
+    bool                                           _extracting;                 /** Whether the scalar data of the current dimension is being extracted */
 
     friend class ImageAction;
 };
@@ -27,18 +27,22 @@ SelectionAction::SelectionAction(QObject* parent, const QString& title) :
     _targetWidget(nullptr),
     _pixelSelectionAction(this, "Pixel Selection"),
     _pixelSelectionTool(nullptr),
-    _showRegionAction(this, "Show selected region", false)
+    _showRegionAction(this, "Show selected region", false),
+    _rasterizerAction(this, "Rasterizer", { "GPU", "CPU", "Validate" }, "CPU")
 {
     setIconByName("mouse-pointer");
 
     _showRegionAction.setVisible(false);
 
+    _rasterizerAction.setToolTip("Rasterize the pixel selection with an off-screen shader (GPU), with a scanline rasterizer (CPU) or with both and report differences (Validate)");
+
     addAction(&_pixelSelectionAction.getTypeAction());
     addAction(&_pixelSelectionAction.getBrushRadiusAction());
     addAction(&_pixelSelectionAction.getModifierAction());
     addAction(&_pixelSelectionAction.getOverlayColorAction());
     addAction(&_pixelSelectionAction.getOverlayOpacityAction());
     addAction(&_pixelSelectionAction.getNotifyDuringSelectionAction());
+    addAction(&_rasterizerAction);
 }
 
 void SelectionAction::initialize(Layer* layer, QWidget* targetWidget, PixelSelectionTool* pixelSelectionTool)
@@ -55,9 +59,9 @@ void SelectionAction::initialize(Layer* layer, QWidget* targetWidget, PixelSelec
 
     _pixelSelectionAction.initialize(targetWidget, _pixelSelectionTool, allowedPixelSelectionTypes);
 
-    connect(&_pixelSelectionAction.getOverlayColorAction(), &ColorAction::colorChanged, _layer, &Layer::invalidate);
-    connect(&_pixelSelectionAction.getOverlayOpacityAction(), &DecimalAction::valueChanged, _layer, &Layer::invalidate);
-    connect(&_showRegionAction, &ToggleAction::toggled, _layer, &Layer::invalidate);
+    connect(&_pixelSelectionAction.getOverlayColorAction(), &ColorAction::colorChanged, _layer, &Layer::invalidateOverlays);
+    connect(&_pixelSelectionAction.getOverlayOpacityAction(), &DecimalAction::valueChanged, _layer, &Layer::invalidateOverlays);
+    connect(&_showRegionAction, &ToggleAction::toggled, _layer, &Layer::invalidateOverlays);
 
     const auto updateInteractionActions = [this]() -> void {
         const auto inSelectionMode  = _layer->getImageViewerPlugin().getImageViewerWidget().getInteractionMode() == ImageViewerWidget::InteractionMode::Selection;
@@ -96,6 +100,7 @@ void SelectionAction::connectToPublicAction(WidgetAction* publicAction, bool rec
     if (recursive) {
         actions().connectPrivateActionToPublicAction(&_pixelSelectionAction, &publicSelectionAction->getPixelSelectionAction(), recursive);
         actions().connectPrivateActionToPublicAction(&_showRegionAction, &publicSelectionAction->getShowRegionAction(), recursive);
+        actions().connectPrivateActionToPublicAction(&_rasterizerAction, &publicSelectionAction->getRasterizerAction(), recursive);
     }
 
     GroupAction::connectToPublicAction(publicAction, recursive);
@@ -109,6 +114,7 @@ void SelectionAction::disconnectFromPublicAction(bool recursive)
     if (recursive) {
         actions().disconnectPrivateActionFromPublicAction(&_pixelSelectionAction, recursive);
         actions().disconnectPrivateActionFromPublicAction(&_showRegionAction, recursive);
+        actions().disconnectPrivateActionFromPublicAction(&_rasterizerAction, recursive);
     }
 
     GroupAction::disconnectFromPublicAction(recursive);
@@ -120,6 +126,7 @@ void SelectionAction::fromVariantMap(const QVariantMap& variantMap)
 
     _pixelSelectionAction.fromParentVariantMap(variantMap);
     _showRegionAction.fromParentVariantMap(variantMap);
+    _rasterizerAction.fromParentVariantMap(variantMap);
 }
 
 QVariantMap SelectionAction::toVariantMap() const
@@ -128,6 +135,7 @@ QVariantMap SelectionAction::toVariantMap() const
 
     _pixelSelectionAction.insertIntoVariantMap(variantMap);
     _showRegionAction.insertIntoVariantMap(variantMap);
+    _rasterizerAction.insertIntoVariantMap(variantMap);
 
     return variantMap;
 }
\ No newline at end of file
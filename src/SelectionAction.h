@@ -1,6 +1,7 @@
 #pragma once
 
 #include <actions/ToggleAction.h>
+#include <actions/OptionAction.h>
 #include <actions/GroupAction.h>
 #include <actions/PixelSelectionAction.h>
 #include <actions/TriggerAction.h>
@@ -78,6 +79,7 @@ public: // Action getters
 
     PixelSelectionAction& getPixelSelectionAction() { return _pixelSelectionAction; }
     ToggleAction& getShowRegionAction() { return _showRegionAction; }
+    OptionAction& getRasterizerAction() { return _rasterizerAction; }
 
 protected:
     Layer*                  _layer;                     /** Pointer to owning layer */
@@ -85,6 +87,7 @@ protected:
     PixelSelectionAction    _pixelSelectionAction;      /** Pixel selection action */
     PixelSelectionTool*     _pixelSelectionTool;        /** Pointer to pixel selection tool */
     ToggleAction            _showRegionAction;          /** Show region action */
+    OptionAction            _rasterizerAction;          /** Rasterizer action (GPU: off-screen shader, CPU: scanline rasterizer, Validate: both and compare) */
 };
 
 Q_DECLARE_METATYPE(SelectionAction)
@@ -0,0 +1,295 @@
+#include "SelectionBitmap.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SELECTION_BITMAP_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace {
+
+    /**
+     * Combine \p count words of \p source into \p target with \p operation
+     * @param target Target words
+     * @param source Source words
+     * @param count Number of words
+     * @param operation Word operation (applied to the remainder that does not fill a vector register)
+     * @param vectorOperation Vector operation
+     */
+    template<typename WordOperation, typename VectorOperation>
+    void combineWords(SelectionBitmap::Word* target, const SelectionBitmap::Word* source, std::size_t count, WordOperation operation, VectorOperation vectorOperation)
+    {
+        std::size_t wordIndex = 0;
+
+#ifdef SELECTION_BITMAP_SSE2
+        for (; wordIndex + 2 <= count; wordIndex += 2) {
+            const auto targetVector = _mm_loadu_si128(reinterpret_cast<const __m128i*>(target + wordIndex));
+            const auto sourceVector = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + wordIndex));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(target + wordIndex), vectorOperation(targetVector, sourceVector));
+        }
+#endif
+
+        for (; wordIndex < count; wordIndex++)
+            target[wordIndex] = operation(target[wordIndex], source[wordIndex]);
+    }
+}
+
+SelectionBitmap::SelectionBitmap(std::size_t numberOfBits /*= 0*/) :
+    _numberOfBits(0),
+    _words()
+{
+    resize(numberOfBits);
+}
+
+void SelectionBitmap::resize(std::size_t numberOfBits)
+{
+    _numberOfBits = numberOfBits;
+
+    _words.assign((numberOfBits + bitsPerWord - 1) / bitsPerWord, Word(0));
+}
+
+void SelectionBitmap::clear()
+{
+    std::fill(_words.begin(), _words.end(), Word(0));
+}
+
+void SelectionBitmap::clear(std::size_t offset, std::size_t count)
+{
+    const auto end = std::min(offset + count, _numberOfBits);
+
+    if (offset >= end)
+        return;
+
+    const auto lastWordIndex = (end - 1) / bitsPerWord;
+
+    for (std::size_t wordIndex = offset / bitsPerWord; wordIndex <= lastWordIndex; wordIndex++)
+        _words[wordIndex] &= ~getRangeMask(wordIndex, offset, end);
+}
+
+bool SelectionBitmap::any() const
+{
+    return std::any_of(_words.begin(), _words.end(), [](const Word& word) { return word != 0; });
+}
+
+std::size_t SelectionBitmap::count() const
+{
+    std::size_t numberOfSetBits = 0;
+
+    for (const auto& word : _words)
+        numberOfSetBits += static_cast<std::size_t>(std::popcount(word));
+
+    return numberOfSetBits;
+}
+
+void SelectionBitmap::assignIndices(const std::vector<std::uint32_t>& indices)
+{
+    clear();
+
+    for (const auto& index : indices)
+        if (index < _numberOfBits)
+            set(index);
+}
+
+void SelectionBitmap::toIndices(std::vector<std::uint32_t>& indices) const
+{
+    indices.clear();
+    indices.reserve(count());
+
+    forEachSetBit([&indices](std::size_t index) {
+        indices.push_back(static_cast<std::uint32_t>(index));
+    });
+}
+
+void SelectionBitmap::packBytes(std::size_t offset, const std::uint8_t* bytes, std::size_t count, std::ptrdiff_t step /*= 1*/)
+{
+    if (offset + count > _numberOfBits)
+        throw std::out_of_range("Packed bytes exceed the selection bitmap size");
+
+    std::size_t bitIndex = offset;
+
+    const auto end = offset + count;
+
+    // Pack bits individually until the next word boundary
+    for (; bitIndex < end && (bitIndex % bitsPerWord) != 0; bitIndex++, bytes += step) {
+        if (*bytes)
+            set(bitIndex);
+        else
+            reset(bitIndex);
+    }
+
+    // Pack whole words
+    for (; bitIndex + bitsPerWord <= end; bitIndex += bitsPerWord) {
+        Word word = 0;
+
+        for (std::size_t bit = 0; bit < bitsPerWord; bit++, bytes += step)
+            word |= static_cast<Word>(*bytes != 0) << bit;
+
+        _words[bitIndex / bitsPerWord] = word;
+    }
+
+    // Pack the remainder
+    for (; bitIndex < end; bitIndex++, bytes += step) {
+        if (*bytes)
+            set(bitIndex);
+        else
+            reset(bitIndex);
+    }
+}
+
+void SelectionBitmap::apply(const SelectionBitmap& other, const Operation& operation)
+{
+    if (other._numberOfBits != _numberOfBits)
+        throw std::invalid_argument("Selection bitmap sizes do not match");
+
+    auto target         = _words.data();
+    const auto source   = other._words.data();
+    const auto count    = _words.size();
+
+    switch (operation)
+    {
+        case Operation::Replace:
+        {
+            std::copy(other._words.begin(), other._words.end(), _words.begin());
+            break;
+        }
+
+#ifdef SELECTION_BITMAP_SSE2
+        case Operation::Add:
+            combineWords(target, source, count, [](Word a, Word b) { return a | b; }, [](__m128i a, __m128i b) { return _mm_or_si128(a, b); });
+            break;
+
+        case Operation::Subtract:
+            combineWords(target, source, count, [](Word a, Word b) { return a & ~b; }, [](__m128i a, __m128i b) { return _mm_andnot_si128(b, a); });
+            break;
+
+        case Operation::Intersect:
+            combineWords(target, source, count, [](Word a, Word b) { return a & b; }, [](__m128i a, __m128i b) { return _mm_and_si128(a, b); });
+            break;
+#else
+        case Operation::Add:
+            combineWords(target, source, count, [](Word a, Word b) { return a | b; }, nullptr);
+            break;
+
+        case Operation::Subtract:
+            combineWords(target, source, count, [](Word a, Word b) { return a & ~b; }, nullptr);
+            break;
+
+        case Operation::Intersect:
+            combineWords(target, source, count, [](Word a, Word b) { return a & b; }, nullptr);
+            break;
+#endif
+
+        default:
+            break;
+    }
+
+    clearPadding();
+}
+
+void SelectionBitmap::apply(const SelectionBitmap& other, const Operation& operation, std::size_t offset, std::size_t count)
+{
+    if (other._numberOfBits != _numberOfBits)
+        throw std::invalid_argument("Selection bitmap sizes do not match");
+
+    const auto end = std::min(offset + count, _numberOfBits);
+
+    if (offset >= end)
+        return;
+
+    const auto firstWordIndex   = offset / bitsPerWord;
+    const auto lastWordIndex    = (end - 1) / bitsPerWord;
+
+    const auto combine = [&operation](Word a, Word b) -> Word {
+        switch (operation)
+        {
+            case Operation::Replace:
+                return b;
+
+            case Operation::Add:
+                return a | b;
+
+            case Operation::Subtract:
+                return a & ~b;
+
+            case Operation::Intersect:
+                return a & b;
+
+            default:
+                break;
+        }
+
+        return a;
+    };
+
+    // Partially covered boundary words only take the combined bits inside the range
+    const auto combineMasked = [this, &other, &combine, offset, end](std::size_t wordIndex) -> void {
+        const auto mask = getRangeMask(wordIndex, offset, end);
+
+        _words[wordIndex] = (_words[wordIndex] & ~mask) | (combine(_words[wordIndex], other._words[wordIndex]) & mask);
+    };
+
+    combineMasked(firstWordIndex);
+
+    if (lastWordIndex == firstWordIndex)
+        return;
+
+    combineMasked(lastWordIndex);
+
+    // Whole words in between are combined like the full bitmap
+    const auto numberOfInnerWords = lastWordIndex - firstWordIndex - 1;
+
+    if (numberOfInnerWords == 0)
+        return;
+
+    auto target         = _words.data() + firstWordIndex + 1;
+    const auto source   = other._words.data() + firstWordIndex + 1;
+
+    switch (operation)
+    {
+        case Operation::Replace:
+        {
+            std::copy(source, source + numberOfInnerWords, target);
+            break;
+        }
+
+#ifdef SELECTION_BITMAP_SSE2
+        case Operation::Add:
+            combineWords(target, source, numberOfInnerWords, [](Word a, Word b) { return a | b; }, [](__m128i a, __m128i b) { return _mm_or_si128(a, b); });
+            break;
+
+        case Operation::Subtract:
+            combineWords(target, source, numberOfInnerWords, [](Word a, Word b) { return a & ~b; }, [](__m128i a, __m128i b) { return _mm_andnot_si128(b, a); });
+            break;
+
+        case Operation::Intersect:
+            combineWords(target, source, numberOfInnerWords, [](Word a, Word b) { return a & b; }, [](__m128i a, __m128i b) { return _mm_and_si128(a, b); });
+            break;
+#else
+        case Operation::Add:
+            combineWords(target, source, numberOfInnerWords, [](Word a, Word b) { return a | b; }, nullptr);
+            break;
+
+        case Operation::Subtract:
+            combineWords(target, source, numberOfInnerWords, [](Word a, Word b) { return a & ~b; }, nullptr);
+            break;
+
+        case Operation::Intersect:
+            combineWords(target, source, numberOfInnerWords, [](Word a, Word b) { return a & b; }, nullptr);
+            break;
+#endif
+
+        default:
+            break;
+    }
+}
+
+void SelectionBitmap::clearPadding()
+{
+    const auto remainder = _numberOfBits % bitsPerWord;
+
+    if (remainder != 0 && !_words.empty())
+        _words.back() &= (Word(1) << remainder) - 1;
+}
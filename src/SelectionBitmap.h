@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Selection bitmap class
+ *
+ * Dense bit vector for selection algebra on pixel (or cluster) indices. Set
+ * operations (replace, add, subtract and intersect) are performed a word at a
+ * time (two words at a time when SSE2 is available) so that combining selections
+ * scales with the number of pixels divided by 64 instead of with tree insertions.
+ */
+class SelectionBitmap
+{
+public:
+
+    using Word = std::uint64_t;
+
+    static constexpr std::size_t bitsPerWord = 64;
+
+    /** Set operations between two bitmaps of equal size */
+    enum class Operation {
+        Replace,        /** Target becomes a copy of the operand */
+        Add,            /** Target becomes the union of target and operand */
+        Subtract,       /** Bits set in the operand are cleared in the target */
+        Intersect       /** Target becomes the intersection of target and operand */
+    };
+
+public: // Construction
+
+    /**
+     * Construct with \p numberOfBits (all cleared)
+     * @param numberOfBits Number of bits
+     */
+    explicit SelectionBitmap(std::size_t numberOfBits = 0);
+
+public: // Size
+
+    /** Get the number of bits */
+    std::size_t size() const { return _numberOfBits; }
+
+    /** Get the number of words */
+    std::size_t getNumberOfWords() const { return _words.size(); }
+
+    /**
+     * Resize to \p numberOfBits and clear all bits
+     * @param numberOfBits Number of bits
+     */
+    void resize(std::size_t numberOfBits);
+
+public: // Bit access
+
+    /** Clear all bits */
+    void clear();
+
+    /**
+     * Clear the \p count bits starting at bit \p offset
+     * @param offset First bit index of the range
+     * @param count Number of bits in the range
+     */
+    void clear(std::size_t offset, std::size_t count);
+
+    /**
+     * Set bit at \p index
+     * @param index Bit index
+     */
+    void set(std::size_t index) { _words[index / bitsPerWord] |= Word(1) << (index % bitsPerWord); }
+
+    /**
+     * Clear bit at \p index
+     * @param index Bit index
+     */
+    void reset(std::size_t index) { _words[index / bitsPerWord] &= ~(Word(1) << (index % bitsPerWord)); }
+
+    /**
+     * Get whether bit at \p index is set
+     * @param index Bit index
+     * @return Whether the bit is set
+     */
+    bool test(std::size_t index) const { return (_words[index / bitsPerWord] >> (index % bitsPerWord)) & Word(1); }
+
+    /** Get whether any bit is set */
+    bool any() const;
+
+    /** Get the number of set bits */
+    std::size_t count() const;
+
+    /** Get pointer to the raw words */
+    const Word* getWords() const { return _words.data(); }
+
+    /** Get pointer to the raw words */
+    Word* getWords() { return _words.data(); }
+
+public: // Conversion
+
+    /**
+     * Clear the bitmap and set the bits in \p indices (out-of-range indices are ignored)
+     * @param indices Indices to set
+     */
+    void assignIndices(const std::vector<std::uint32_t>& indices);
+
+    /**
+     * Convert set bits to a sorted list of \p indices
+     * @param indices Output indices (overwritten)
+     */
+    void toIndices(std::vector<std::uint32_t>& indices) const;
+
+    /**
+     * Pack \p count bytes into bits starting at bit \p offset, a bit is set when the byte is non-zero
+     * @param offset First bit index to write
+     * @param bytes Pointer to the first byte
+     * @param count Number of bytes (bits) to pack
+     * @param step Distance in bytes between two consecutive samples (may be negative)
+     */
+    void packBytes(std::size_t offset, const std::uint8_t* bytes, std::size_t count, std::ptrdiff_t step = 1);
+
+public: // Set algebra
+
+    /**
+     * Apply set \p operation with \p other (sizes must match)
+     * @param other Operand bitmap
+     * @param operation Set operation
+     */
+    void apply(const SelectionBitmap& other, const Operation& operation);
+
+    /**
+     * Apply set \p operation with \p other to the \p count bits starting at bit \p offset (sizes must match), bits outside the range are left unchanged
+     * @param other Operand bitmap
+     * @param operation Set operation
+     * @param offset First bit index of the range
+     * @param count Number of bits in the range
+     */
+    void apply(const SelectionBitmap& other, const Operation& operation, std::size_t offset, std::size_t count);
+
+    /**
+     * Replace with \p other
+     * @param other Operand bitmap
+     */
+    void replace(const SelectionBitmap& other) { apply(other, Operation::Replace); }
+
+    /**
+     * Union with \p other
+     * @param other Operand bitmap
+     */
+    void add(const SelectionBitmap& other) { apply(other, Operation::Add); }
+
+    /**
+     * Remove bits that are set in \p other
+     * @param other Operand bitmap
+     */
+    void subtract(const SelectionBitmap& other) { apply(other, Operation::Subtract); }
+
+    /**
+     * Intersect with \p other
+     * @param other Operand bitmap
+     */
+    void intersect(const SelectionBitmap& other) { apply(other, Operation::Intersect); }
+
+public: // Iteration
+
+    /**
+     * Invoke \p callback for every set bit in ascending order
+     * @param callback Callable with signature void(std::size_t index)
+     */
+    template<typename Callback>
+    void forEachSetBit(Callback callback) const
+    {
+        forEachSetBit(callback, 0, _numberOfBits);
+    }
+
+    /**
+     * Invoke \p callback for every set bit in the \p count bits starting at bit \p offset in ascending order
+     * @param callback Callable with signature void(std::size_t index)
+     * @param offset First bit index of the range
+     * @param count Number of bits in the range
+     */
+    template<typename Callback>
+    void forEachSetBit(Callback callback, std::size_t offset, std::size_t count) const
+    {
+        const auto end = std::min(offset + count, _numberOfBits);
+
+        if (offset >= end)
+            return;
+
+        const auto lastWordIndex = (end - 1) / bitsPerWord;
+
+        for (std::size_t wordIndex = offset / bitsPerWord; wordIndex <= lastWordIndex; wordIndex++) {
+            auto word = _words[wordIndex] & getRangeMask(wordIndex, offset, end);
+
+            while (word != 0) {
+                callback(wordIndex * bitsPerWord + static_cast<std::size_t>(std::countr_zero(word)));
+
+                word &= word - 1;
+            }
+        }
+    }
+
+private:
+
+    /** Clear the unused bits in the last word so that counting and conversion stay exact */
+    void clearPadding();
+
+    /**
+     * Get the mask of the bits of word \p wordIndex that lie in the bit range [\p begin, \p end)
+     * @param wordIndex Word index
+     * @param begin First bit index of the range
+     * @param end One past the last bit index of the range
+     * @return Word mask
+     */
+    static Word getRangeMask(std::size_t wordIndex, std::size_t begin, std::size_t end)
+    {
+        const auto wordBegin    = wordIndex * bitsPerWord;
+        const auto first        = begin > wordBegin ? begin - wordBegin : 0;
+        const auto last         = std::min(end - wordBegin, bitsPerWord);
+
+        const auto upperMask = last == bitsPerWord ? ~Word(0) : (Word(1) << last) - 1;
+
+        return upperMask & ~((Word(1) << first) - 1);
+    }
+
+private:
+    std::size_t         _numberOfBits;      /** Number of bits */
+    std::vector<Word>   _words;             /** Bit storage */
+};
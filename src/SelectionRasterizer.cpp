@@ -0,0 +1,473 @@
+#include "SelectionRasterizer.h"
+
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+    /** Polygon edge that is not horizontal */
+    struct Edge {
+        double          _top;       /** Top of the edge (smallest y) */
+        double          _bottom;    /** Bottom of the edge (largest y) */
+        double          _x;         /** X at the top of the edge */
+        double          _slope;     /** Change in x per unit y */
+        std::int32_t    _winding;   /** Direction of the edge (1: downwards, -1: upwards) */
+    };
+
+    /**
+     * Narrow [\p low, \p high] to the x for which \p minimum < \p slope * x + \p offset < \p maximum
+     * @param low Lower bound (updated)
+     * @param high Upper bound (updated)
+     * @param slope Slope of the linear function
+     * @param offset Offset of the linear function
+     * @param minimum Exclusive minimum of the linear function
+     * @param maximum Exclusive maximum of the linear function
+     */
+    void intersectLinear(double& low, double& high, double slope, double offset, double minimum, double maximum)
+    {
+        if (std::abs(slope) < 1e-12) {
+            if (!(minimum < offset && offset < maximum)) {
+                low     = std::numeric_limits<double>::infinity();
+                high    = -std::numeric_limits<double>::infinity();
+            }
+
+            return;
+        }
+
+        auto first  = (minimum - offset) / slope;
+        auto second = (maximum - offset) / slope;
+
+        if (slope < 0.0)
+            std::swap(first, second);
+
+        low     = std::max(low, first);
+        high    = std::min(high, second);
+    }
+
+    /**
+     * Clamp \p value to a pixel index in [\p minimum - 1, \p maximum + 1]
+     * @param value Value
+     * @param minimum Minimum pixel index
+     * @param maximum Maximum pixel index
+     * @return Pixel index
+     */
+    std::int32_t toPixel(double value, std::int32_t minimum, std::int32_t maximum)
+    {
+        return static_cast<std::int32_t>(std::clamp(value, static_cast<double>(minimum) - 1.0, static_cast<double>(maximum) + 1.0));
+    }
+
+    /**
+     * Move the end points of the span [\p first, \p last] onto the pixels where \p inside changes (the span is clipped to [\p minimum, \p maximum])
+     * The analytic span end points might be off by one pixel due to rounding, testing them with the predicate of the shader gives identical results
+     * @param first First pixel of the span (updated)
+     * @param last Last pixel of the span (updated)
+     * @param minimum Minimum pixel index
+     * @param maximum Maximum pixel index
+     * @param inside Predicate with signature bool(std::int32_t pixel)
+     */
+    template<typename Inside>
+    void refineSpan(std::int32_t& first, std::int32_t& last, std::int32_t minimum, std::int32_t maximum, Inside inside)
+    {
+        first   = std::clamp(first, minimum, maximum + 1);
+        last    = std::clamp(last, minimum - 1, maximum);
+
+        while (first > minimum && inside(first - 1))
+            first--;
+
+        while (first <= last && !inside(first))
+            first++;
+
+        while (last < maximum && inside(last + 1))
+            last++;
+
+        while (last >= first && !inside(last))
+            last--;
+    }
+}
+
+SelectionRasterizer::SelectionRasterizer() :
+    _size(),
+    _buffer(),
+    _dirtyRectangle(),
+    _threadPool()
+{
+}
+
+void SelectionRasterizer::resize(const QSize& size)
+{
+    _size = size;
+
+    _buffer.assign(static_cast<std::size_t>(std::max(0, size.width())) * std::max(0, size.height()), 0);
+
+    _dirtyRectangle = QRect();
+}
+
+QRect SelectionRasterizer::clear()
+{
+    const auto previousDirtyRectangle = _dirtyRectangle;
+
+    clearRectangle(previousDirtyRectangle);
+
+    _dirtyRectangle = QRect();
+
+    return previousDirtyRectangle;
+}
+
+QRect SelectionRasterizer::rasterizeRectangle(const QRectF& rectangle)
+{
+    const auto previousDirtyRectangle = clear();
+
+    const auto width    = static_cast<float>(_size.width());
+    const auto height   = static_cast<float>(_size.height());
+
+    // Same tests as the shader, in normalized image coordinates
+    const auto left     = static_cast<float>(rectangle.left());
+    const auto right    = static_cast<float>(rectangle.right());
+    const auto top      = static_cast<float>(rectangle.top());
+    const auto bottom   = static_cast<float>(rectangle.bottom());
+
+    auto firstColumn    = toPixel(std::ceil(rectangle.left() * _size.width() - 0.5), 0, _size.width() - 1);
+    auto lastColumn     = toPixel(std::ceil(rectangle.right() * _size.width() - 0.5) - 1.0, 0, _size.width() - 1);
+    auto firstRow       = toPixel(std::ceil(rectangle.top() * _size.height() - 0.5), 0, _size.height() - 1);
+    auto lastRow        = toPixel(std::ceil(rectangle.bottom() * _size.height() - 0.5) - 1.0, 0, _size.height() - 1);
+
+    refineSpan(firstColumn, lastColumn, 0, _size.width() - 1, [width, left, right](std::int32_t column) -> bool {
+        const auto u = (static_cast<float>(column) + 0.5f) / width;
+
+        return u >= left && u < right;
+    });
+
+    refineSpan(firstRow, lastRow, 0, _size.height() - 1, [height, top, bottom](std::int32_t row) -> bool {
+        const auto v = (static_cast<float>(row) + 0.5f) / height;
+
+        return v >= top && v < bottom;
+    });
+
+    if (firstColumn > lastColumn || firstRow > lastRow)
+        return previousDirtyRectangle;
+
+    forEachRowBand(firstRow, lastRow, [this, firstColumn, lastColumn](std::int32_t bandTop, std::int32_t bandBottom) -> void {
+        for (auto row = bandTop; row <= bandBottom; row++)
+            fillSpan(row, firstColumn, lastColumn);
+    });
+
+    _dirtyRectangle = QRect(QPoint(firstColumn, firstRow), QPoint(lastColumn, lastRow));
+
+    return previousDirtyRectangle.united(_dirtyRectangle);
+}
+
+QRect SelectionRasterizer::rasterizeRegion(const QRectF& region)
+{
+    const auto previousDirtyRectangle = clear();
+
+    const auto width    = static_cast<float>(_size.width());
+    const auto height   = static_cast<float>(_size.height());
+
+    // Same tests as the shader, in normalized image coordinates
+    const auto left     = static_cast<float>(region.left());
+    const auto right    = static_cast<float>(region.right());
+    const auto top      = static_cast<float>(region.top());
+    const auto bottom   = static_cast<float>(region.bottom());
+
+    auto firstColumn    = toPixel(std::ceil(region.left() * _size.width() - 0.5), 0, _size.width() - 1);
+    auto lastColumn     = toPixel(std::floor(region.right() * _size.width() - 0.5), 0, _size.width() - 1);
+    auto firstRow       = toPixel(std::ceil(region.top() * _size.height() - 0.5), 0, _size.height() - 1);
+    auto lastRow        = toPixel(std::floor(region.bottom() * _size.height() - 0.5), 0, _size.height() - 1);
+
+    refineSpan(firstColumn, lastColumn, 0, _size.width() - 1, [width, left, right](std::int32_t column) -> bool {
+        const auto u = (static_cast<float>(column) + 0.5f) / width;
+
+        return u >= left && u <= right;
+    });
+
+    refineSpan(firstRow, lastRow, 0, _size.height() - 1, [height, top, bottom](std::int32_t row) -> bool {
+        const auto v = (static_cast<float>(row) + 0.5f) / height;
+
+        return v >= top && v <= bottom;
+    });
+
+    if (firstColumn > lastColumn || firstRow > lastRow)
+        return previousDirtyRectangle;
+
+    forEachRowBand(firstRow, lastRow, [this, firstColumn, lastColumn](std::int32_t bandTop, std::int32_t bandBottom) -> void {
+        for (auto row = bandTop; row <= bandBottom; row++)
+            fillSpan(row, firstColumn, lastColumn);
+    });
+
+    _dirtyRectangle = QRect(QPoint(firstColumn, firstRow), QPoint(lastColumn, lastRow));
+
+    return previousDirtyRectangle.united(_dirtyRectangle);
+}
+
+QRect SelectionRasterizer::rasterizeSample(const QPointF& position)
+{
+    const auto previousDirtyRectangle = clear();
+
+    // The pixel center floors to the same pixel as the sample position
+    const auto pixel = QPoint(static_cast<std::int32_t>(std::floor(position.x())), static_cast<std::int32_t>(std::floor(position.y())));
+
+    if (!QRect(QPoint(0, 0), _size).contains(pixel))
+        return previousDirtyRectangle;
+
+    fillSpan(pixel.y(), pixel.x(), pixel.x());
+
+    _dirtyRectangle = QRect(pixel, pixel);
+
+    return previousDirtyRectangle.united(_dirtyRectangle);
+}
+
+QRect SelectionRasterizer::rasterizePolygon(const QPolygonF& polygon, const FillRule& fillRule)
+{
+    const auto previousDirtyRectangle = clear();
+
+    if (polygon.size() < 3)
+        return previousDirtyRectangle;
+
+    std::vector<Edge> edges;
+
+    edges.reserve(static_cast<std::size_t>(polygon.size()));
+
+    for (qsizetype pointIndex = 0; pointIndex < polygon.size(); pointIndex++) {
+        const auto& start   = polygon[pointIndex];
+        const auto& end     = polygon[(pointIndex + 1) % polygon.size()];
+
+        // Horizontal edges never cross a row center
+        if (start.y() == end.y())
+            continue;
+
+        const auto& upper = start.y() < end.y() ? start : end;
+        const auto& lower = start.y() < end.y() ? end : start;
+
+        edges.push_back(Edge{ upper.y(), lower.y(), upper.x(), (lower.x() - upper.x()) / (lower.y() - upper.y()), start.y() < end.y() ? 1 : -1 });
+    }
+
+    std::sort(edges.begin(), edges.end(), [](const Edge& lhs, const Edge& rhs) -> bool {
+        return lhs._top < rhs._top;
+    });
+
+    const auto boundingRectangle    = polygon.boundingRect();
+    const auto rows                 = getRows(boundingRectangle.top(), boundingRectangle.bottom());
+
+    if (rows.x() > rows.y())
+        return previousDirtyRectangle;
+
+    forEachRowBand(rows.x(), rows.y(), [this, &edges, fillRule](std::int32_t bandTop, std::int32_t bandBottom) -> void {
+        std::vector<const Edge*> activeEdges;
+        std::vector<std::pair<double, std::int32_t>> crossings;
+
+        std::size_t nextEdgeIndex = 0;
+
+        for (auto row = bandTop; row <= bandBottom; row++) {
+            const auto rowCenter = static_cast<double>(row) + 0.5;
+
+            // An edge crosses the row center when top <= center < bottom
+            while (nextEdgeIndex < edges.size() && edges[nextEdgeIndex]._top <= rowCenter) {
+                if (edges[nextEdgeIndex]._bottom > rowCenter)
+                    activeEdges.push_back(&edges[nextEdgeIndex]);
+
+                nextEdgeIndex++;
+            }
+
+            activeEdges.erase(std::remove_if(activeEdges.begin(), activeEdges.end(), [rowCenter](const Edge* edge) -> bool {
+                return edge->_bottom <= rowCenter;
+            }), activeEdges.end());
+
+            crossings.clear();
+
+            for (const auto& activeEdge : activeEdges)
+                crossings.emplace_back(activeEdge->_x + (rowCenter - activeEdge->_top) * activeEdge->_slope, activeEdge->_winding);
+
+            std::sort(crossings.begin(), crossings.end());
+
+            // Pixels of which the center lies in [start, end) are inside
+            const auto fillInterval = [this, row](double start, double end) -> void {
+                const auto first    = toPixel(std::ceil(start - 0.5), 0, _size.width() - 1);
+                const auto last     = toPixel(std::ceil(end - 0.5) - 1.0, 0, _size.width() - 1);
+
+                fillSpan(row, first, last);
+            };
+
+            if (fillRule == FillRule::EvenOdd) {
+                for (std::size_t crossingIndex = 0; crossingIndex + 1 < crossings.size(); crossingIndex += 2)
+                    fillInterval(crossings[crossingIndex].first, crossings[crossingIndex + 1].first);
+            }
+            else {
+                std::int32_t winding = 0;
+
+                for (std::size_t crossingIndex = 0; crossingIndex + 1 < crossings.size(); crossingIndex++) {
+                    winding += crossings[crossingIndex].second;
+
+                    if (winding != 0)
+                        fillInterval(crossings[crossingIndex].first, crossings[crossingIndex + 1].first);
+                }
+            }
+        }
+    });
+
+    const auto firstColumn  = toPixel(std::floor(boundingRectangle.left()), 0, _size.width() - 1);
+    const auto lastColumn   = toPixel(std::ceil(boundingRectangle.right()), 0, _size.width() - 1);
+
+    _dirtyRectangle = QRect(QPoint(firstColumn, rows.x()), QPoint(lastColumn, rows.y())).intersected(QRect(QPoint(0, 0), _size));
+
+    return previousDirtyRectangle.united(_dirtyRectangle);
+}
+
+QRect SelectionRasterizer::rasterizeBrushStroke(const QVector2D& previousCenter, const QVector2D& currentCenter, float radius)
+{
+    if (radius <= 0.0f)
+        return {};
+
+    // Same test as the shader: within the radius of the current center or of the segment between the centers
+    const auto inBrush = [&previousCenter, &currentCenter, radius](std::int32_t column, std::int32_t row) -> bool {
+        const auto position = QVector2D(static_cast<float>(column) + 0.5f, static_cast<float>(row) + 0.5f);
+
+        if ((position - currentCenter).length() < radius)
+            return true;
+
+        if (currentCenter != previousCenter) {
+            const auto segment              = currentCenter - previousCenter;
+            const auto segmentDirection     = segment.normalized();
+            const auto projection           = QVector2D::dotProduct(position - previousCenter, segmentDirection);
+
+            if (projection > 0.0f && projection < segment.length()) {
+                if ((position - (previousCenter + projection * segmentDirection)).length() < radius)
+                    return true;
+            }
+        }
+
+        return false;
+    };
+
+    const auto strokeRectangle  = QRectF(previousCenter.toPointF(), currentCenter.toPointF()).normalized().adjusted(-radius, -radius, radius, radius);
+    const auto rows             = getRows(strokeRectangle.top(), strokeRectangle.bottom());
+
+    if (rows.x() > rows.y())
+        return {};
+
+    forEachRowBand(rows.x(), rows.y(), [this, &previousCenter, &currentCenter, radius, &inBrush](std::int32_t bandTop, std::int32_t bandBottom) -> void {
+        const auto segment          = QVector2D(currentCenter - previousCenter);
+        const auto segmentLength    = static_cast<double>(segment.length());
+
+        for (auto row = bandTop; row <= bandBottom; row++) {
+            const auto rowCenter = static_cast<double>(row) + 0.5;
+
+            auto low    = std::numeric_limits<double>::infinity();
+            auto high   = -std::numeric_limits<double>::infinity();
+
+            // Disk around the current center
+            const auto deltaY = rowCenter - currentCenter.y();
+
+            if (std::abs(deltaY) < radius) {
+                const auto halfWidth = std::sqrt(static_cast<double>(radius) * radius - deltaY * deltaY);
+
+                low     = currentCenter.x() - halfWidth;
+                high    = currentCenter.x() + halfWidth;
+            }
+
+            // Rectangle swept along the segment (together with the disk at its end it is convex, so the union on the row is a single interval)
+            if (segmentLength > 0.0) {
+                const auto direction    = QVector2D(segment / segment.length());
+                const auto normal       = QVector2D(-direction.y(), direction.x());
+
+                auto bodyLow    = -std::numeric_limits<double>::infinity();
+                auto bodyHigh   = std::numeric_limits<double>::infinity();
+
+                intersectLinear(bodyLow, bodyHigh, direction.x(), -previousCenter.x() * direction.x() + (rowCenter - previousCenter.y()) * direction.y(), 0.0, segmentLength);
+                intersectLinear(bodyLow, bodyHigh, normal.x(), -previousCenter.x() * normal.x() + (rowCenter - previousCenter.y()) * normal.y(), -radius, radius);
+
+                if (bodyLow < bodyHigh) {
+                    low     = std::min(low, bodyLow);
+                    high    = std::max(high, bodyHigh);
+                }
+            }
+
+            if (!(low < high))
+                continue;
+
+            // Pixels of which the center lies in (low, high)
+            auto first  = toPixel(std::floor(low - 0.5) + 1.0, 0, _size.width() - 1);
+            auto last   = toPixel(std::ceil(high - 0.5) - 1.0, 0, _size.width() - 1);
+
+            refineSpan(first, last, 0, _size.width() - 1, [&inBrush, row](std::int32_t column) -> bool {
+                return inBrush(column, row);
+            });
+
+            fillSpan(row, first, last);
+        }
+    });
+
+    const auto firstColumn  = toPixel(std::floor(strokeRectangle.left()), 0, _size.width() - 1);
+    const auto lastColumn   = toPixel(std::ceil(strokeRectangle.right()), 0, _size.width() - 1);
+    const auto strokeRegion = QRect(QPoint(firstColumn, rows.x()), QPoint(lastColumn, rows.y())).intersected(QRect(QPoint(0, 0), _size));
+
+    // Strokes accumulate
+    _dirtyRectangle = _dirtyRectangle.united(strokeRegion);
+
+    return strokeRegion;
+}
+
+void SelectionRasterizer::clearRectangle(const QRect& rectangle)
+{
+    const auto clippedRectangle = rectangle.intersected(QRect(QPoint(0, 0), _size));
+
+    if (clippedRectangle.isEmpty())
+        return;
+
+    for (auto row = clippedRectangle.top(); row <= clippedRectangle.bottom(); row++)
+        std::memset(_buffer.data() + static_cast<std::size_t>(row) * _size.width() + (_size.width() - 1 - clippedRectangle.right()), 0, static_cast<std::size_t>(clippedRectangle.width()));
+}
+
+void SelectionRasterizer::fillSpan(std::int32_t row, std::int32_t left, std::int32_t right)
+{
+    left    = std::max(left, 0);
+    right   = std::min(right, _size.width() - 1);
+
+    if (row < 0 || row >= _size.height() || left > right)
+        return;
+
+    // Columns are mirrored, so the span is stored from right to left
+    std::memset(_buffer.data() + static_cast<std::size_t>(row) * _size.width() + (_size.width() - 1 - right), 255, static_cast<std::size_t>(right - left + 1));
+}
+
+void SelectionRasterizer::forEachRowBand(std::int32_t top, std::int32_t bottom, const std::function<void(std::int32_t, std::int32_t)>& rasterizeBand)
+{
+    const auto numberOfRows = bottom - top + 1;
+
+    if (numberOfRows <= 0)
+        return;
+
+    const auto numberOfBands = std::max(1, std::min(QThread::idealThreadCount(), numberOfRows / minimumRowsPerBand));
+
+    // Small shapes are not worth the synchronization
+    if (numberOfBands == 1 || static_cast<std::int64_t>(numberOfRows) * _size.width() < minimumNumberOfPixelsForThreads) {
+        rasterizeBand(top, bottom);
+        return;
+    }
+
+    const auto numberOfRowsPerBand = (numberOfRows + numberOfBands - 1) / numberOfBands;
+
+    // Bands write disjoint rows, the calling thread rasterizes the first band
+    for (auto bandTop = top + numberOfRowsPerBand; bandTop <= bottom; bandTop += numberOfRowsPerBand) {
+        const auto bandBottom = std::min(bandTop + numberOfRowsPerBand - 1, bottom);
+
+        _threadPool.start([&rasterizeBand, bandTop, bandBottom]() -> void {
+            rasterizeBand(bandTop, bandBottom);
+        });
+    }
+
+    rasterizeBand(top, std::min(top + numberOfRowsPerBand - 1, bottom));
+
+    _threadPool.waitForDone();
+}
+
+QPoint SelectionRasterizer::getRows(float top, float bottom) const
+{
+    const auto firstRow = std::max(toPixel(std::ceil(static_cast<double>(top) - 0.5), 0, _size.height() - 1), 0);
+    const auto lastRow  = std::min(toPixel(std::floor(static_cast<double>(bottom) - 0.5), 0, _size.height() - 1), _size.height() - 1);
+
+    return { firstRow, lastRow };
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <QPolygonF>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+#include <QThreadPool>
+#include <QVector2D>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * Selection rasterizer class
+ *
+ * Rasterizes the pixel selection tool shapes on the CPU into a byte per pixel selection buffer (non-zero: selected)
+ * The buffer has the layout of the off-screen selection buffer (image rows, mirrored columns), so it can be uploaded to the selection buffer texture as is
+ *
+ * Shapes are filled span by span per image row: rectangles and regions of interest analytically, brush strokes as capsules and polygons with a scanline
+ * (active edge table) fill, so there is no limit on the number of polygon vertices. Span end points are tested with the same predicates as the
+ * selection tool off-screen fragment shader, pixels are sampled at their center.
+ *
+ * Large shapes are rasterized by multiple threads, each filling a band of rows
+ */
+class SelectionRasterizer
+{
+public:
+
+    /** Polygon fill rules */
+    enum class FillRule {
+        EvenOdd,        /** A pixel is inside when a ray from it crosses the outline an odd number of times */
+        NonZero         /** A pixel is inside when the outline winds around it */
+    };
+
+    /** Minimum number of rows per band when rasterizing with multiple threads */
+    static constexpr std::int32_t minimumRowsPerBand = 64;
+
+    /** Shapes that cover fewer pixels are rasterized by the calling thread only */
+    static constexpr std::int64_t minimumNumberOfPixelsForThreads = 256 * 1024;
+
+public: // Construction
+
+    /** Default constructor */
+    SelectionRasterizer();
+
+    /**
+     * Resize the selection buffer to \p size and clear it
+     * @param size Image size in pixels
+     */
+    void resize(const QSize& size);
+
+public: // Selection buffer
+
+    /** Get the image size in pixels */
+    QSize getSize() const { return _size; }
+
+    /** Get pointer to the selection buffer (image rows, mirrored columns) */
+    const std::uint8_t* getData() const { return _buffer.data(); }
+
+    /** Get the region that contains selected pixels (in image coordinates) */
+    QRect getDirtyRectangle() const { return _dirtyRectangle; }
+
+    /**
+     * Clear the selected pixels
+     * @return Region of which the pixels changed (in image coordinates)
+     */
+    QRect clear();
+
+public: // Shapes (replace the selection)
+
+    /**
+     * Select the pixels of which the center lies in \p rectangle (left and top inclusive, right and bottom exclusive)
+     * @param rectangle Rectangle in normalized image coordinates
+     * @return Region of which the pixels changed (in image coordinates)
+     */
+    QRect rasterizeRectangle(const QRectF& rectangle);
+
+    /**
+     * Select the pixels of which the center lies in \p region (all edges inclusive)
+     * @param region Region of interest in normalized image coordinates
+     * @return Region of which the pixels changed (in image coordinates)
+     */
+    QRect rasterizeRegion(const QRectF& region);
+
+    /**
+     * Select the pixel that contains \p position
+     * @param position Position in image coordinates
+     * @return Region of which the pixels changed (in image coordinates)
+     */
+    QRect rasterizeSample(const QPointF& position);
+
+    /**
+     * Select the pixels of which the center lies inside \p polygon
+     * @param polygon Polygon in image coordinates (implicitly closed, at least three vertices)
+     * @param fillRule Fill rule
+     * @return Region of which the pixels changed (in image coordinates)
+     */
+    QRect rasterizePolygon(const QPolygonF& polygon, const FillRule& fillRule);
+
+public: // Strokes (accumulate)
+
+    /**
+     * Add the pixels of which the center lies within \p radius of the segment from \p previousCenter to \p currentCenter to the selection
+     * @param previousCenter Previous brush center in image coordinates
+     * @param currentCenter Current brush center in image coordinates
+     * @param radius Brush radius in image coordinates
+     * @return Region of which the pixels changed (in image coordinates)
+     */
+    QRect rasterizeBrushStroke(const QVector2D& previousCenter, const QVector2D& currentCenter, float radius);
+
+private:
+
+    /**
+     * Clear the pixels of \p rectangle
+     * @param rectangle Rectangle in image coordinates
+     */
+    void clearRectangle(const QRect& rectangle);
+
+    /**
+     * Select the pixels in [\p left, \p right] of image \p row (clipped to the image)
+     * @param row Image row
+     * @param left First image column
+     * @param right Last image column
+     */
+    void fillSpan(std::int32_t row, std::int32_t left, std::int32_t right);
+
+    /**
+     * Invoke \p rasterizeBand for bands of the rows in [\p top, \p bottom], bands are rasterized concurrently when the shape is large
+     * @param top First row
+     * @param bottom Last row
+     * @param rasterizeBand Callable that rasterizes the rows of a band (first and last row)
+     */
+    void forEachRowBand(std::int32_t top, std::int32_t bottom, const std::function<void(std::int32_t, std::int32_t)>& rasterizeBand);
+
+    /**
+     * Get the image rows of which the center lies in [\p top, \p bottom] (clipped to the image)
+     * @param top Top in image coordinates
+     * @param bottom Bottom in image coordinates
+     * @return First (x) and last (y) row
+     */
+    QPoint getRows(float top, float bottom) const;
+
+private:
+    QSize                           _size;              /** Image size in pixels */
+    std::vector<std::uint8_t>       _buffer;            /** Selection buffer (image rows, mirrored columns) */
+    QRect                           _dirtyRectangle;    /** Region that contains selected pixels (in image coordinates) */
+    QThreadPool                     _threadPool;        /** Worker threads that rasterize row bands */
+};
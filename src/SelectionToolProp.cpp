@@ -1,4 +1,5 @@
 #include "SelectionToolProp.h"
+#include "ImageProp.h"
 #include "QuadShape.h"
 #include "LayersModel.h"
 #include "LayersRenderer.h"
@@ -11,8 +12,11 @@
 
 #include <QDebug>
 #include <QOpenGLContext>
-#include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
+#include <QPolygonF>
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 using namespace mv::util;
@@ -20,12 +24,25 @@ using namespace mv::util;
 SelectionToolProp::SelectionToolProp(Layer& layer, const QString& name) :
     Prop(layer, name),
     _layer(layer),
-    _fbo()
+    _bufferSize(),
+    _framebuffer(0),
+    _dirtyRectangle(),
+    _pixelPackBuffers{ 0, 0, 0 },
+    _readBackFences{ nullptr, nullptr, nullptr },
+    _readBackRectangles(),
+    _readBackCapacities{ 0, 0, 0 },
+    _readBackIndex(-1),
+    _pinnedIndex(-1),
+    _mappedIndex(-1),
+    _rasterizer(),
+    _rasterized(false),
+    _offScreen(true)
 {
     addShape<QuadShape>("Quad");
 
-    addShaderProgram("SelectionTool");
-    addShaderProgram("SelectionToolOffScreen");
+    // Add off-screen selection buffer texture
+    addTexture("SelectionBuffer", QOpenGLTexture::Target2D);
+
     initialize();
 }
 
@@ -35,15 +52,18 @@ void SelectionToolProp::initialize()
     {
         Prop::initialize();
 
-        getRenderer().bindOpenGLContext();
-        {
-            // Load shader programs
-            loadSelectionToolShaderProgram();
-            loadSelectionToolOffScreenShaderProgram();
+        // Number of shader programs that still have to be linked
+        auto numberOfPendingShaderPrograms = std::make_shared<std::int32_t>(2);
 
-            _initialized = true;
-        }
-        getRenderer().releaseOpenGLContext();
+        // The prop is ready when both shader programs are linked
+        const auto shaderProgramLoaded = [this, numberOfPendingShaderPrograms]() -> void {
+            if (--(*numberOfPendingShaderPrograms) == 0)
+                _initialized = true;
+        };
+
+        // Load shader programs (in the background)
+        loadSelectionToolShaderProgram(shaderProgramLoaded);
+        loadSelectionToolOffScreenShaderProgram(shaderProgramLoaded);
     }
     catch (std::exception& e)
     {
@@ -54,25 +74,65 @@ void SelectionToolProp::initialize()
     }
 }
 
+void SelectionToolProp::destroy()
+{
+    Prop::destroy();
+
+    destroySelectionBuffer();
+}
+
+void SelectionToolProp::destroySelectionBuffer()
+{
+    auto functions = getRenderer().getOpenGLContext()->extraFunctions();
+
+    // Unmap the pixel pack buffer when it is still mapped
+    unmapPixelPackBuffer();
+
+    for (auto& readBackFence : _readBackFences) {
+        if (readBackFence != nullptr)
+            functions->glDeleteSync(readBackFence);
+
+        readBackFence = nullptr;
+    }
+
+    if (_pixelPackBuffers[0] != 0)
+        functions->glDeleteBuffers(static_cast<GLsizei>(_pixelPackBuffers.size()), _pixelPackBuffers.data());
+
+    _pixelPackBuffers.fill(0);
+
+    if (_framebuffer != 0)
+        functions->glDeleteFramebuffers(1, &_framebuffer);
+
+    _framebuffer = 0;
+
+    getTextureByName("SelectionBuffer")->destroy();
+
+    _readBackRectangles.fill(QRect());
+    _readBackCapacities.fill(0);
+
+    _readBackIndex  = -1;
+    _pinnedIndex    = -1;
+}
+
 void SelectionToolProp::render(const QMatrix4x4& modelViewProjectionMatrix)
 {
     try {
 
-        if (!canRender())
+        if (!canRender() || !_offScreen)
             return;
 
         const auto shape                        = getShapeByName<QuadShape>("Quad");
         const auto selectionToolShaderProgram   = getShaderProgramByName("SelectionTool");
 
-        // Bind shader program
-        if (_fbo.isNull())
-            throw std::runtime_error("FBO not initialized");
+        // Check whether the off-screen selection buffer exists
+        if (_framebuffer == 0)
+            throw std::runtime_error("Selection buffer not initialized");
 
         // Bind shader program
         if (!selectionToolShaderProgram->bind())
             throw std::runtime_error("Unable to bind quad shader program");
 
-        glBindTexture(GL_TEXTURE_2D, _fbo->texture());
+        getTextureByName("SelectionBuffer")->bind();
 
         // Get reference to selection action
         auto& selectionAction = _layer.getSelectionAction();
@@ -88,6 +148,9 @@ void SelectionToolProp::render(const QMatrix4x4& modelViewProjectionMatrix)
 
         // Release the shader program
         selectionToolShaderProgram->release();
+
+        // Release the selection buffer texture
+        getTextureByName("SelectionBuffer")->release();
     }
     catch (std::exception& e)
     {
@@ -125,9 +188,16 @@ void SelectionToolProp::setGeometry(const QRectF& imageRectangle)
             // Assign model matrix
             setModelMatrix(modelMatrix);
 
-            // Create FBO when none exists
-            if (_fbo.isNull())
-                _fbo.reset(new QOpenGLFramebufferObject(imageRectangle.width(), imageRectangle.height()));
+            // Streamed images might not fit in a texture, so they are only rasterized on the CPU
+            const auto offScreen = !_layer.getPropByName<ImageProp>("ImageProp")->isTiled();
+
+            // Create the off-screen selection buffer when none exists or when the image size changed
+            if ((offScreen && _framebuffer == 0) || offScreen != _offScreen || _bufferSize != imageRectangle.size().toSize()) {
+                _bufferSize = imageRectangle.size().toSize();
+                _offScreen  = offScreen;
+
+                createSelectionBuffer();
+            }
         }
         getRenderer().releaseOpenGLContext();
     }
@@ -143,335 +213,854 @@ void SelectionToolProp::setGeometry(const QRectF& imageRectangle)
 void SelectionToolProp::compute(const QVector<QPoint>& mousePositions)
 {
     try {
+        const auto rasterizer = getRasterizer();
+
         getRenderer().bindOpenGLContext();
         {
-            // Check if FBO is created
-            if (_fbo.isNull())
-                throw std::runtime_error("FBO not created");
+            // Check if the off-screen selection buffer is created
+            if (_offScreen && _framebuffer == 0)
+                throw std::runtime_error("Selection buffer not created");
 
-            // Check if FBO is valid
-            if (!_fbo->isValid())
-                throw std::runtime_error("FBO not valid");
+            if (rasterizer != Rasterizer::Cpu)
+                rasterizeOnGpu(mousePositions);
 
-            // Bind FBO for off-screen rendering
-            if (!_fbo->bind())
-                throw std::runtime_error("Unable to bind FBO");
+            if (rasterizer != Rasterizer::Gpu) {
+                const auto changedRectangle = rasterizeOnCpu(mousePositions);
 
-            // Get quad shape and compute the model-view-matrix
-            const auto quadShape        = getShapeByName<QuadShape>("Quad");
-            const auto quadRectangle    = quadShape->getRectangle();
-            const auto modelViewMatrix  = _layer.getRenderer()->getViewMatrix() * _renderable.getModelMatrix() * getModelMatrix();
+                // When validating, the selection buffer texture and the read back keep the result of the shader
+                if (rasterizer == Rasterizer::Cpu) {
 
-            // Create viewport with the same size as the FBO a
-            glViewport(0.0f, 0.0f, _fbo->width(), _fbo->height());
+                    // The texture might still contain a selection of the shader (when the rasterizer was switched), which is overwritten as well
+                    uploadRasterizedSelection(_rasterized ? changedRectangle : changedRectangle.united(_dirtyRectangle));
 
-            QMatrix4x4 transform;
+                    _dirtyRectangle = _rasterizer.getDirtyRectangle();
+                }
+            }
 
-            // Create orthogonal transformation matrix
-            transform.ortho(0.0f, _fbo->width(), 0.0f, _fbo->height(), -1.0f, +1.0f);
+            _rasterized = rasterizer == Rasterizer::Cpu;
+        }
+        getRenderer().releaseOpenGLContext();
 
-            // Get reference to selection action
-            auto& selectionAction = _layer.getSelectionAction();
+        if (rasterizer == Rasterizer::Validate)
+            validateRasterizedSelection();
+    }
+    catch (std::exception& e)
+    {
+        exceptionMessageBox("Selection prop off-screen image buffer computation failed", e);
+    }
+    catch (...) {
+        exceptionMessageBox("Selection prop off-screen image buffer computation failed");
+    }
+}
 
-            // Get shader program for the off-screen rendering
-            const auto selectionToolOffScreenShaderProgram = getShaderProgramByName("SelectionToolOffScreen");
+void SelectionToolProp::resetOffScreenSelectionBuffer()
+{
+    try {
+        getRenderer().bindOpenGLContext();
+        {
+            // Clear the region of the off-screen buffer touched since the last reset, the remainder is cleared already
+            if (_offScreen) {
 
-            // Bind the quad vertex array object buffer
-            quadShape->getVAO().bind();
+                // Check if the off-screen selection buffer is created
+                if (_framebuffer == 0)
+                    throw std::runtime_error("Selection buffer not created");
 
-            // Bind shader program
-            if (!selectionToolOffScreenShaderProgram->bind())
-                throw std::runtime_error("Unable to bind off screen shader program");
+                auto functions = getRenderer().getOpenGLContext()->extraFunctions();
 
-            // Bind the FBO texture for off-screen rendering
-            glBindTexture(GL_TEXTURE_2D, _fbo->texture());
+                // Bind the FBO
+                functions->glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
 
-            // Get selection type and brush radius
-            const auto selectionType    = selectionAction.getPixelSelectionAction().getTypeAction().getCurrentIndex();
-            const auto brushRadius      = selectionAction.getPixelSelectionAction().getBrushRadiusAction().getValue();
+                const auto clearRectangle = _dirtyRectangle.intersected(QRect(QPoint(0, 0), _bufferSize));
 
-            // Get the FBO size in floating point
-            const auto fboSize = QSizeF(static_cast<float>(_fbo->size().width()), static_cast<float>(_fbo->size().height()));
+                if (!clearRectangle.isEmpty()) {
+                    const auto scissorEnabled = glIsEnabled(GL_SCISSOR_TEST);
 
-            // Configure shader program
-            selectionToolOffScreenShaderProgram->setUniformValue("pixelSelectionTexture", 0);
-            selectionToolOffScreenShaderProgram->setUniformValue("transform", transform);
-            selectionToolOffScreenShaderProgram->setUniformValue("selectionType", selectionType);
-            selectionToolOffScreenShaderProgram->setUniformValue("imageSize", fboSize.width(), fboSize.height());
+                    GLint scissorBox[4] = { 0, 0, 0, 0 };
 
-            // Get number of mouse positions
-            const auto numberOfMousePositions = mousePositions.size();
+                    glGetIntegerv(GL_SCISSOR_BOX, scissorBox);
 
-            switch (static_cast<PixelSelectionType>(selectionType))
-            {
-                case PixelSelectionType::Rectangle:
-                {
-                    if (numberOfMousePositions < 2)
-                        break;
+                    // Image columns are mirrored with respect to the off-screen buffer columns
+                    glEnable(GL_SCISSOR_TEST);
+                    glScissor(_bufferSize.width() - 1 - clearRectangle.right(), clearRectangle.top(), clearRectangle.width(), clearRectangle.height());
+                    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+                    glClear(GL_COLOR_BUFFER_BIT);
+                    glScissor(scissorBox[0], scissorBox[1], scissorBox[2], scissorBox[3]);
 
-                    const auto rectangleTopLeft = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, mousePositions.first());
-                    const auto rectangleBottomRight = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, mousePositions.last());
-                    const auto rectangleTopLeftUV       = QVector2D(rectangleTopLeft.x() / fboSize.width(), rectangleTopLeft.y() / fboSize.height());
-                    const auto rectangleBottomRightUV   = QVector2D(rectangleBottomRight.x() / fboSize.width(), rectangleBottomRight.y() / fboSize.height());
-                    const auto rectangle                = QRectF(QPointF(rectangleTopLeftUV.x(), rectangleTopLeftUV.y()), QPointF(rectangleBottomRightUV.x(), rectangleBottomRightUV.y())).normalized();
+                    if (!scissorEnabled)
+                        glDisable(GL_SCISSOR_TEST);
+                }
+            }
 
-                    selectionToolOffScreenShaderProgram->setUniformValue("rectangleTopLeft", rectangle.topLeft());
-                    selectionToolOffScreenShaderProgram->setUniformValue("rectangleBottomRight", rectangle.bottomRight());
+            // Nothing is selected anymore
+            _dirtyRectangle = QRect();
 
-                    // Draw off-screen 
-                    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+            _rasterizer.clear();
 
-                    break;
-                }
+            if (_offScreen) {
+                auto functions = getRenderer().getOpenGLContext()->extraFunctions();
 
-                case PixelSelectionType::Brush:
-                {
-                    if (numberOfMousePositions <= 0)
-                        break;
+                readBackSelectionBuffer();
 
-                    const auto brushCenter      = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, QPoint(0.0f, 0.0f));
-                    const auto brushPerimeter   = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, QPoint(brushRadius, 0.0f));
-                    const auto brushRadiusWorld = (brushPerimeter - brushCenter).length();
+                // Release the FBO
+                functions->glBindFramebuffer(GL_FRAMEBUFFER, getRenderer().getOpenGLContext()->defaultFramebufferObject());
+            }
+        }
+        getRenderer().releaseOpenGLContext();
+    }
+    catch (std::exception& e)
+    {
+        exceptionMessageBox("Selection prop off-screen image buffer reset failed", e);
+    }
+    catch (...) {
+        exceptionMessageBox("Selection prop off-screen image buffer reset failed");
+    }
+}
 
-                    selectionToolOffScreenShaderProgram->setUniformValue("brushRadius", brushRadiusWorld);
+void SelectionToolProp::pinSelectionBuffer()
+{
+    _pinnedIndex = _readBackIndex;
+}
 
-                    if (numberOfMousePositions == 1) {
-                        const auto brushCenter = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, mousePositions.last()).toVector2D();
+bool SelectionToolProp::isSelectionBufferReady()
+{
+    const auto readBackIndex = _pinnedIndex >= 0 ? _pinnedIndex : _readBackIndex;
 
-                        selectionToolOffScreenShaderProgram->setUniformValue("previousBrushCenter", brushCenter);
-                        selectionToolOffScreenShaderProgram->setUniformValue("currentBrushCenter", brushCenter);
-                    }
+    // The rasterized selection already resides in client memory
+    if (_rasterized || readBackIndex < 0 || _readBackFences[readBackIndex] == nullptr)
+        return true;
 
-                    if (numberOfMousePositions > 1) {
-                        const auto previousBrushCenter  = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, mousePositions[numberOfMousePositions - 2]).toVector2D();
-                        const auto currentBrushCenter   = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, mousePositions.last()).toVector2D();
+    auto readBackComplete = false;
 
-                        selectionToolOffScreenShaderProgram->setUniformValue("previousBrushCenter", previousBrushCenter);
-                        selectionToolOffScreenShaderProgram->setUniformValue("currentBrushCenter", currentBrushCenter);
-                    }
+    getRenderer().bindOpenGLContext();
+    {
+        readBackComplete = isReadBackComplete(readBackIndex);
+    }
+    getRenderer().releaseOpenGLContext();
 
-                    // Draw off-screen 
-                    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    return readBackComplete;
+}
 
-                    break;
-                }
+SelectionToolProp::SelectionBuffer SelectionToolProp::mapSelectionBuffer()
+{
+    SelectionBuffer selectionBuffer;
 
-                case PixelSelectionType::Lasso:
-                case PixelSelectionType::Polygon:
-                {
-                    if (numberOfMousePositions < 2)
-                        break;
+    // The rasterized selection already resides in client memory
+    if (_rasterized) {
+        const auto rasterizedRectangle = _rasterizer.getDirtyRectangle();
 
-                    QList<QVector2D> points;
+        if (rasterizedRectangle.isEmpty())
+            return selectionBuffer;
 
-                    points.reserve(static_cast<std::int32_t>(numberOfMousePositions));
+        selectionBuffer._data       = _rasterizer.getData() + static_cast<std::size_t>(rasterizedRectangle.top()) * _bufferSize.width() + (_bufferSize.width() - 1 - rasterizedRectangle.right());
+        selectionBuffer._stride     = _bufferSize.width();
+        selectionBuffer._rectangle  = rasterizedRectangle;
 
-                    for (const auto& mousePosition : mousePositions)
-                        points.push_back(getRenderer().getScreenPointToWorldPosition(modelViewMatrix, mousePosition).toVector2D());
+        return selectionBuffer;
+    }
 
-                    selectionToolOffScreenShaderProgram->setUniformValueArray("points", &points[0], static_cast<std::int32_t>(points.size()));
-                    selectionToolOffScreenShaderProgram->setUniformValue("noPoints", static_cast<int>(points.size()));
+    getRenderer().bindOpenGLContext();
+    {
+        selectionBuffer = mapReadBack(_pinnedIndex >= 0 ? _pinnedIndex : _readBackIndex);
+    }
+    getRenderer().releaseOpenGLContext();
 
-                    // Draw off-screen 
-                    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    return selectionBuffer;
+}
 
-                    break;
-                }
+void SelectionToolProp::unmapSelectionBuffer()
+{
+    _pinnedIndex = -1;
 
-                case PixelSelectionType::Sample:
-                {
-                    if (numberOfMousePositions <= 0)
-                        break;
+    if (_mappedIndex < 0)
+        return;
 
-                    // Convert sample 2D screen position to world position
-                    QList<QVector2D> points{ getRenderer().getScreenPointToWorldPosition(modelViewMatrix, mousePositions.first()).toVector2D() };
+    getRenderer().bindOpenGLContext();
+    {
+        unmapPixelPackBuffer();
+    }
+    getRenderer().releaseOpenGLContext();
+}
 
-                    // Assign sample point to shader
-                    selectionToolOffScreenShaderProgram->setUniformValueArray("points", &points[0], static_cast<std::int32_t>(points.size()));
+QRect SelectionToolProp::getDirtyRectangle() const
+{
+    return _dirtyRectangle;
+}
 
-                    // Draw off-screen 
-                    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+void SelectionToolProp::createSelectionBuffer()
+{
+    // The rasterizer buffer has the same layout as the render target
+    _rasterizer.resize(_bufferSize);
 
-                    break;
-                }
+    _dirtyRectangle = QRect();
+    _rasterized     = false;
 
-                case PixelSelectionType::ROI:
-                {
-                    // Compute UV coordinates of viewing rectangle
-                    const auto roiTopLeft       = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, QPoint(0, getRenderer().getParentWidgetSize().height()));
-                    const auto roiBottomRight   = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, QPoint(getRenderer().getParentWidgetSize().width(), 0));
-                    const auto roiTopLeftUV     = QVector2D(roiTopLeft.x() / fboSize.width(), roiTopLeft.y() / fboSize.height());
-                    const auto roiBottomRightUV = QVector2D(roiBottomRight.x() / fboSize.width(), roiBottomRight.y() / fboSize.height());
+    // Streamed images are only rasterized on the CPU, so the off-screen buffer is not allocated (it might exceed the maximum texture size)
+    if (!_offScreen) {
+        destroySelectionBuffer();
+        return;
+    }
 
-                    QList<QVector2D> points {
-                        roiTopLeftUV,
-                        roiBottomRightUV
-                    };
+    auto functions = getRenderer().getOpenGLContext()->extraFunctions();
 
-                    // Assign sample point to shader
-                    selectionToolOffScreenShaderProgram->setUniformValueArray("points", &points[0], static_cast<std::int32_t>(points.size()));
+    // Single channel render target, one byte per pixel
+    auto& texture = getTextureByName("SelectionBuffer");
 
-                    // Draw off-screen 
-                    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    if (texture->isCreated())
+        texture->destroy();
 
-                    break;
-                }
+    texture->create();
+    texture->setSize(_bufferSize.width(), _bufferSize.height());
+    texture->setFormat(QOpenGLTexture::R8_UNorm);
+    texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+    texture->setMinMagFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
+    texture->allocateStorage();
 
-                default:
-                    break;
-            }
+    if (_framebuffer == 0)
+        functions->glGenFramebuffers(1, &_framebuffer);
 
-            // Release the shader program
-            selectionToolOffScreenShaderProgram->release();
+    functions->glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+    functions->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->textureId(), 0);
 
-            // And shape VAO
-            quadShape->getVAO().release();
+    if (functions->glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("Selection buffer FBO not complete");
 
-            // Release the FBO
-            _fbo->release();
-        }
-        getRenderer().releaseOpenGLContext();
+    // Start with an empty selection
+    glViewport(0, 0, _bufferSize.width(), _bufferSize.height());
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    functions->glBindFramebuffer(GL_FRAMEBUFFER, getRenderer().getOpenGLContext()->defaultFramebufferObject());
+
+    // Create the pixel pack buffers, these are (re)allocated on demand to fit the dirty region
+    if (_pixelPackBuffers[0] == 0)
+        functions->glGenBuffers(static_cast<GLsizei>(_pixelPackBuffers.size()), _pixelPackBuffers.data());
+
+    _readBackRectangles.fill(QRect());
+    _readBackCapacities.fill(0);
+
+    _readBackIndex  = -1;
+    _pinnedIndex    = -1;
+}
+
+QRect SelectionToolProp::getPixelRectangle(const QRectF& rectangle) const
+{
+    const auto normalizedRectangle = rectangle.normalized();
+
+    // Pixel (x, y) is covered when its center (x + 0.5, y + 0.5) lies inside the rectangle, allow one pixel of slack for rounding
+    const auto topLeft      = QPoint(static_cast<int>(std::floor(normalizedRectangle.left())) - 1, static_cast<int>(std::floor(normalizedRectangle.top())) - 1);
+    const auto bottomRight  = QPoint(static_cast<int>(std::ceil(normalizedRectangle.right())), static_cast<int>(std::ceil(normalizedRectangle.bottom())));
+
+    return QRect(topLeft, bottomRight).intersected(QRect(QPoint(0, 0), _bufferSize));
+}
+
+void SelectionToolProp::unmapPixelPackBuffer()
+{
+    if (_mappedIndex < 0)
+        return;
+
+    auto functions = getRenderer().getOpenGLContext()->extraFunctions();
+
+    functions->glBindBuffer(GL_PIXEL_PACK_BUFFER, _pixelPackBuffers[_mappedIndex]);
+    functions->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    functions->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    _mappedIndex = -1;
+}
+
+void SelectionToolProp::readBackSelectionBuffer()
+{
+    auto functions = getRenderer().getOpenGLContext()->extraFunctions();
+
+    const auto numberOfPixelPackBuffers = static_cast<std::int32_t>(_pixelPackBuffers.size());
+
+    // Cycle through the pixel pack buffers so that a read back never has to wait for a previous one, the pinned read back is kept until it is mapped
+    auto readBackIndex = (_readBackIndex + 1) % numberOfPixelPackBuffers;
+
+    if (readBackIndex == _pinnedIndex)
+        readBackIndex = (readBackIndex + 1) % numberOfPixelPackBuffers;
+
+    if (readBackIndex == _mappedIndex)
+        unmapPixelPackBuffer();
+
+    if (_readBackFences[readBackIndex] != nullptr) {
+        functions->glDeleteSync(_readBackFences[readBackIndex]);
+
+        _readBackFences[readBackIndex] = nullptr;
     }
-    catch (std::exception& e)
+
+    _readBackRectangles[readBackIndex]  = _dirtyRectangle;
+    _readBackIndex                      = readBackIndex;
+
+    // No need to transfer anything when the buffer is empty
+    if (_dirtyRectangle.isEmpty())
+        return;
+
+    const auto numberOfBytes = static_cast<GLsizeiptr>(_dirtyRectangle.width()) * _dirtyRectangle.height();
+
+    functions->glBindBuffer(GL_PIXEL_PACK_BUFFER, _pixelPackBuffers[readBackIndex]);
+
+    // Grow the pixel pack buffer when the dirty region does not fit
+    if (_readBackCapacities[readBackIndex] < numberOfBytes) {
+        functions->glBufferData(GL_PIXEL_PACK_BUFFER, numberOfBytes, nullptr, GL_STREAM_READ);
+
+        _readBackCapacities[readBackIndex] = numberOfBytes;
+    }
+
+    // Image columns are mirrored with respect to the off-screen buffer columns
+    functions->glReadBuffer(GL_COLOR_ATTACHMENT0);
+    functions->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    functions->glReadPixels(_bufferSize.width() - 1 - _dirtyRectangle.right(), _dirtyRectangle.top(), _dirtyRectangle.width(), _dirtyRectangle.height(), GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    functions->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    functions->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // Signal when the transfer is complete
+    _readBackFences[readBackIndex] = functions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool SelectionToolProp::isReadBackComplete(std::int32_t readBackIndex)
+{
+    auto& readBackFence = _readBackFences[readBackIndex];
+
+    if (readBackFence == nullptr)
+        return true;
+
+    auto functions = getRenderer().getOpenGLContext()->extraFunctions();
+
+    // Poll only, the read back is consumed later when the transfer is still in flight
+    const auto waitResult = functions->glClientWaitSync(readBackFence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+    if (waitResult == GL_TIMEOUT_EXPIRED)
+        return false;
+
+    functions->glDeleteSync(readBackFence);
+
+    readBackFence = nullptr;
+
+    if (waitResult == GL_WAIT_FAILED)
+        throw std::runtime_error("Unable to poll the selection buffer read back");
+
+    return true;
+}
+
+SelectionToolProp::SelectionBuffer SelectionToolProp::mapReadBack(std::int32_t readBackIndex)
+{
+    SelectionBuffer selectionBuffer;
+
+    // Nothing was read back yet
+    if (readBackIndex < 0 || _readBackRectangles[readBackIndex].isEmpty())
+        return selectionBuffer;
+
+    if (_mappedIndex >= 0)
+        throw std::runtime_error("Selection buffer is already mapped");
+
+    if (!isReadBackComplete(readBackIndex))
+        throw std::runtime_error("Selection buffer read back is not complete");
+
+    auto functions = getRenderer().getOpenGLContext()->extraFunctions();
+
+    const auto& readBackRectangle = _readBackRectangles[readBackIndex];
+
+    // Map the pixel pack buffer into client memory
+    functions->glBindBuffer(GL_PIXEL_PACK_BUFFER, _pixelPackBuffers[readBackIndex]);
+
+    const auto data = functions->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(readBackRectangle.width()) * readBackRectangle.height(), GL_MAP_READ_BIT);
+
+    functions->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (data == nullptr)
+        throw std::runtime_error("Unable to map the selection buffer");
+
+    _mappedIndex = readBackIndex;
+
+    selectionBuffer._data       = static_cast<const std::uint8_t*>(data);
+    selectionBuffer._stride     = readBackRectangle.width();
+    selectionBuffer._rectangle  = readBackRectangle;
+
+    return selectionBuffer;
+}
+
+void SelectionToolProp::rasterizeOnGpu(const QVector<QPoint>& mousePositions)
+{
+    auto functions = getRenderer().getOpenGLContext()->extraFunctions();
+
+    // Bind FBO for off-screen rendering
+    functions->glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+
+    // Get quad shape and compute the model-view-matrix
+    const auto quadShape        = getShapeByName<QuadShape>("Quad");
+    const auto quadRectangle    = quadShape->getRectangle();
+    const auto modelViewMatrix  = _layer.getRenderer()->getViewMatrix() * _renderable.getModelMatrix() * getModelMatrix();
+
+    // Create viewport with the same size as the FBO
+    glViewport(0, 0, _bufferSize.width(), _bufferSize.height());
+
+    QMatrix4x4 transform;
+
+    // Create orthogonal transformation matrix
+    transform.ortho(0.0f, _bufferSize.width(), 0.0f, _bufferSize.height(), -1.0f, +1.0f);
+
+    // Get reference to selection action
+    auto& selectionAction = _layer.getSelectionAction();
+
+    // Get shader program for the off-screen rendering
+    const auto selectionToolOffScreenShaderProgram = getShaderProgramByName("SelectionToolOffScreen");
+
+    // Bind the quad vertex array object buffer
+    quadShape->getVAO().bind();
+
+    // Bind shader program
+    if (!selectionToolOffScreenShaderProgram->bind())
+        throw std::runtime_error("Unable to bind off screen shader program");
+
+    // Get selection type and brush radius
+    const auto selectionType    = selectionAction.getPixelSelectionAction().getTypeAction().getCurrentIndex();
+    const auto brushRadius      = selectionAction.getPixelSelectionAction().getBrushRadiusAction().getValue();
+
+    // Get the FBO size in floating point
+    const auto fboSize = QSizeF(static_cast<float>(_bufferSize.width()), static_cast<float>(_bufferSize.height()));
+
+    // Configure shader program
+    selectionToolOffScreenShaderProgram->setUniformValue("transform", transform);
+    selectionToolOffScreenShaderProgram->setUniformValue("selectionType", selectionType);
+    selectionToolOffScreenShaderProgram->setUniformValue("imageSize", fboSize.width(), fboSize.height());
+
+    // Get number of mouse positions
+    const auto numberOfMousePositions = mousePositions.size();
+
+    // Image region covered by the tool and whether the buffer was drawn
+    QRect toolRectangle;
+    bool drawn = false;
+
+    // Draws the quad, only the fragments in image \p region are shaded (the remainder of the selection buffer is left untouched)
+    const auto drawOffScreen = [this](const QRect& region) -> void {
+        if (region.isEmpty())
+            return;
+
+        const auto scissorEnabled = glIsEnabled(GL_SCISSOR_TEST);
+
+        GLint scissorBox[4] = { 0, 0, 0, 0 };
+
+        glGetIntegerv(GL_SCISSOR_BOX, scissorBox);
+
+        // Image columns are mirrored with respect to the off-screen buffer columns
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(_bufferSize.width() - 1 - region.right(), region.top(), region.width(), region.height());
+
+        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+
+        glScissor(scissorBox[0], scissorBox[1], scissorBox[2], scissorBox[3]);
+
+        if (!scissorEnabled)
+            glDisable(GL_SCISSOR_TEST);
+    };
+
+    switch (static_cast<PixelSelectionType>(selectionType))
     {
-        exceptionMessageBox("Selection prop off-screen image buffer computation failed", e);
+        case PixelSelectionType::Rectangle:
+        {
+            if (numberOfMousePositions < 2)
+                break;
+
+            const auto rectangleTopLeft = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, mousePositions.first());
+            const auto rectangleBottomRight = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, mousePositions.last());
+            const auto rectangleTopLeftUV       = QVector2D(rectangleTopLeft.x() / fboSize.width(), rectangleTopLeft.y() / fboSize.height());
+            const auto rectangleBottomRightUV   = QVector2D(rectangleBottomRight.x() / fboSize.width(), rectangleBottomRight.y() / fboSize.height());
+            const auto rectangle                = QRectF(QPointF(rectangleTopLeftUV.x(), rectangleTopLeftUV.y()), QPointF(rectangleBottomRightUV.x(), rectangleBottomRightUV.y())).normalized();
+
+            selectionToolOffScreenShaderProgram->setUniformValue("rectangleTopLeft", rectangle.topLeft());
+            selectionToolOffScreenShaderProgram->setUniformValue("rectangleBottomRight", rectangle.bottomRight());
+
+            toolRectangle   = getPixelRectangle(QRectF(rectangle.left() * fboSize.width(), rectangle.top() * fboSize.height(), rectangle.width() * fboSize.width(), rectangle.height() * fboSize.height()));
+            drawn           = true;
+
+            // Draw off-screen (the previous rectangle is cleared as well)
+            drawOffScreen(toolRectangle.united(_dirtyRectangle));
+
+            break;
+        }
+
+        case PixelSelectionType::Brush:
+        {
+            if (numberOfMousePositions <= 0)
+                break;
+
+            const auto brushCenter      = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, QPoint(0.0f, 0.0f));
+            const auto brushPerimeter   = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, QPoint(brushRadius, 0.0f));
+            const auto brushRadiusWorld = (brushPerimeter - brushCenter).length();
+
+            selectionToolOffScreenShaderProgram->setUniformValue("brushRadius", brushRadiusWorld);
+
+            const auto previousBrushCenter  = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, mousePositions[numberOfMousePositions > 1 ? numberOfMousePositions - 2 : 0]).toVector2D();
+            const auto currentBrushCenter   = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, mousePositions.last()).toVector2D();
+
+            selectionToolOffScreenShaderProgram->setUniformValue("previousBrushCenter", previousBrushCenter);
+            selectionToolOffScreenShaderProgram->setUniformValue("currentBrushCenter", currentBrushCenter);
+
+            // Image region covered by the stroke segment (the capsule around it)
+            const auto strokeRectangle  = QRectF(previousBrushCenter.toPointF(), currentBrushCenter.toPointF()).normalized().adjusted(-brushRadiusWorld, -brushRadiusWorld, brushRadiusWorld, brushRadiusWorld);
+            const auto strokeRegion     = getPixelRectangle(strokeRectangle);
+
+            // The brush accumulates, so combine the stroke with the existing selection buffer content by taking the maximum
+            const auto blendEnabled = glIsEnabled(GL_BLEND);
+
+            GLint blendEquationRGB = GL_FUNC_ADD, blendEquationAlpha = GL_FUNC_ADD;
+
+            glGetIntegerv(GL_BLEND_EQUATION_RGB, &blendEquationRGB);
+            glGetIntegerv(GL_BLEND_EQUATION_ALPHA, &blendEquationAlpha);
+
+            glEnable(GL_BLEND);
+            functions->glBlendEquation(GL_MAX);
+
+            // Draw off-screen, only the stroke segment is shaded so that brushing scales with the brush size instead of with the image size
+            drawOffScreen(strokeRegion);
+
+            functions->glBlendEquationSeparate(blendEquationRGB, blendEquationAlpha);
+
+            if (!blendEnabled)
+                glDisable(GL_BLEND);
+
+            toolRectangle   = _dirtyRectangle.united(strokeRegion);
+            drawn           = true;
+
+            break;
+        }
+
+        case PixelSelectionType::Lasso:
+        case PixelSelectionType::Polygon:
+        {
+            if (numberOfMousePositions < 2)
+                break;
+
+            QList<QVector2D> points;
+
+            points.reserve(static_cast<std::int32_t>(numberOfMousePositions));
+
+            QPolygonF polygon;
+
+            for (const auto& mousePosition : mousePositions) {
+                points.push_back(getRenderer().getScreenPointToWorldPosition(modelViewMatrix, mousePosition).toVector2D());
+                polygon << points.last().toPointF();
+            }
+
+            selectionToolOffScreenShaderProgram->setUniformValueArray("points", &points[0], static_cast<std::int32_t>(points.size()));
+            selectionToolOffScreenShaderProgram->setUniformValue("noPoints", static_cast<int>(points.size()));
+
+            toolRectangle   = getPixelRectangle(polygon.boundingRect());
+            drawn           = true;
+
+            // Draw off-screen (the previous polygon is cleared as well)
+            drawOffScreen(toolRectangle.united(_dirtyRectangle));
+
+            break;
+        }
+
+        case PixelSelectionType::Sample:
+        {
+            if (numberOfMousePositions <= 0)
+                break;
+
+            // Convert sample 2D screen position to world position
+            QList<QVector2D> points{ getRenderer().getScreenPointToWorldPosition(modelViewMatrix, mousePositions.first()).toVector2D() };
+
+            // Assign sample point to shader
+            selectionToolOffScreenShaderProgram->setUniformValueArray("points", &points[0], static_cast<std::int32_t>(points.size()));
+
+            toolRectangle   = getPixelRectangle(QRectF(points.first().toPointF(), QSizeF()));
+            drawn           = true;
+
+            // Draw off-screen (the previous sample is cleared as well)
+            drawOffScreen(toolRectangle.united(_dirtyRectangle));
+
+            break;
+        }
+
+        case PixelSelectionType::ROI:
+        {
+            // Compute UV coordinates of viewing rectangle
+            const auto roiTopLeft       = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, QPoint(0, getRenderer().getParentWidgetSize().height()));
+            const auto roiBottomRight   = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, QPoint(getRenderer().getParentWidgetSize().width(), 0));
+            const auto roiTopLeftUV     = QVector2D(roiTopLeft.x() / fboSize.width(), roiTopLeft.y() / fboSize.height());
+            const auto roiBottomRightUV = QVector2D(roiBottomRight.x() / fboSize.width(), roiBottomRight.y() / fboSize.height());
+
+            QList<QVector2D> points {
+                roiTopLeftUV,
+                roiBottomRightUV
+            };
+
+            // Assign sample point to shader
+            selectionToolOffScreenShaderProgram->setUniformValueArray("points", &points[0], static_cast<std::int32_t>(points.size()));
+
+            toolRectangle   = getPixelRectangle(QRectF(roiTopLeft.toPointF(), roiBottomRight.toPointF()));
+            drawn           = true;
+
+            // Draw off-screen (the previous region is cleared as well)
+            drawOffScreen(toolRectangle.united(_dirtyRectangle));
+
+            break;
+        }
+
+        default:
+            break;
     }
-    catch (...) {
-        exceptionMessageBox("Selection prop off-screen image buffer computation failed");
+
+    // Release the shader program
+    selectionToolOffScreenShaderProgram->release();
+
+    // And shape VAO
+    quadShape->getVAO().release();
+
+    // Read back the region touched by the tool asynchronously
+    if (drawn) {
+        _dirtyRectangle = toolRectangle;
+
+        readBackSelectionBuffer();
     }
+
+    // Release the FBO
+    functions->glBindFramebuffer(GL_FRAMEBUFFER, getRenderer().getOpenGLContext()->defaultFramebufferObject());
 }
 
-void SelectionToolProp::resetOffScreenSelectionBuffer()
+SelectionToolProp::Rasterizer SelectionToolProp::getRasterizer() const
 {
-    try {
-        getRenderer().bindOpenGLContext();
+    // Without off-screen buffer there is nothing to render into
+    if (!_offScreen)
+        return Rasterizer::Cpu;
+
+    return static_cast<Rasterizer>(std::clamp(_layer.getSelectionAction().getRasterizerAction().getCurrentIndex(), 0, static_cast<std::int32_t>(Rasterizer::Validate)));
+}
+
+QRect SelectionToolProp::rasterizeOnCpu(const QVector<QPoint>& mousePositions)
+{
+    const auto modelViewMatrix = _layer.getRenderer()->getViewMatrix() * _renderable.getModelMatrix() * getModelMatrix();
+
+    // Get reference to pixel selection action
+    auto& pixelSelectionAction = _layer.getSelectionAction().getPixelSelectionAction();
+
+    // Get selection type and brush radius
+    const auto selectionType    = pixelSelectionAction.getTypeAction().getCurrentIndex();
+    const auto brushRadius      = pixelSelectionAction.getBrushRadiusAction().getValue();
+
+    // Get the buffer size in floating point
+    const auto bufferSize = QSizeF(static_cast<float>(_bufferSize.width()), static_cast<float>(_bufferSize.height()));
+
+    // Convert screen position to (single precision) world position, in the same way as for the off-screen shader
+    const auto toWorldPosition = [this, &modelViewMatrix](const QPoint& screenPoint) -> QVector2D {
+        return getRenderer().getScreenPointToWorldPosition(modelViewMatrix, screenPoint).toVector2D();
+    };
+
+    // Convert world position to normalized image coordinates
+    const auto toUV = [&bufferSize](const QVector2D& worldPosition) -> QPointF {
+        return QVector2D(worldPosition.x() / bufferSize.width(), worldPosition.y() / bufferSize.height()).toPointF();
+    };
+
+    // Get number of mouse positions
+    const auto numberOfMousePositions = mousePositions.size();
+
+    switch (static_cast<PixelSelectionType>(selectionType))
+    {
+        case PixelSelectionType::Rectangle:
         {
-            // Bind the FBO
-            if (!_fbo->bind())
-                throw std::runtime_error("Unable to bind FBO");
-
-            // Clear the FBO
-            glViewport(0, 0, _fbo->width(), _fbo->height());
-            glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-            glClear(GL_COLOR_BUFFER_BIT);
-            glFlush();
-
-            // Release the FBO
-            _fbo->release();
+            if (numberOfMousePositions < 2)
+                break;
+
+            return _rasterizer.rasterizeRectangle(QRectF(toUV(toWorldPosition(mousePositions.first())), toUV(toWorldPosition(mousePositions.last()))).normalized());
         }
-        getRenderer().releaseOpenGLContext();
+
+        case PixelSelectionType::Brush:
+        {
+            if (numberOfMousePositions <= 0)
+                break;
+
+            const auto brushCenter      = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, QPoint(0.0f, 0.0f));
+            const auto brushPerimeter   = getRenderer().getScreenPointToWorldPosition(modelViewMatrix, QPoint(brushRadius, 0.0f));
+            const auto brushRadiusWorld = (brushPerimeter - brushCenter).length();
+
+            const auto previousBrushCenter  = toWorldPosition(mousePositions[numberOfMousePositions > 1 ? numberOfMousePositions - 2 : 0]);
+            const auto currentBrushCenter   = toWorldPosition(mousePositions.last());
+
+            return _rasterizer.rasterizeBrushStroke(previousBrushCenter, currentBrushCenter, brushRadiusWorld);
+        }
+
+        case PixelSelectionType::Lasso:
+        case PixelSelectionType::Polygon:
+        {
+            if (numberOfMousePositions < 2)
+                break;
+
+            QPolygonF polygon;
+
+            polygon.reserve(numberOfMousePositions);
+
+            for (const auto& mousePosition : mousePositions)
+                polygon << toWorldPosition(mousePosition).toPointF();
+
+            return _rasterizer.rasterizePolygon(polygon, SelectionRasterizer::FillRule::EvenOdd);
+        }
+
+        case PixelSelectionType::Sample:
+        {
+            if (numberOfMousePositions <= 0)
+                break;
+
+            return _rasterizer.rasterizeSample(toWorldPosition(mousePositions.first()).toPointF());
+        }
+
+        case PixelSelectionType::ROI:
+        {
+            // The corners are not normalized, like in the shader
+            const auto roiTopLeft       = toWorldPosition(QPoint(0, getRenderer().getParentWidgetSize().height()));
+            const auto roiBottomRight   = toWorldPosition(QPoint(getRenderer().getParentWidgetSize().width(), 0));
+
+            return _rasterizer.rasterizeRegion(QRectF(toUV(roiTopLeft), toUV(roiBottomRight)));
+        }
+
+        default:
+            break;
     }
-    catch (std::exception& e)
+
+    return {};
+}
+
+void SelectionToolProp::uploadRasterizedSelection(const QRect& rectangle)
+{
+    const auto uploadRectangle = rectangle.intersected(QRect(QPoint(0, 0), _bufferSize));
+
+    if (uploadRectangle.isEmpty() || !getTextureByName("SelectionBuffer")->isCreated())
+        return;
+
+    auto functions = getRenderer().getOpenGLContext()->extraFunctions();
+
+    auto& texture = getTextureByName("SelectionBuffer");
+
+    // Image columns are mirrored with respect to the selection buffer columns, so the region starts at the right-most image column
+    const auto textureX = _bufferSize.width() - 1 - uploadRectangle.right();
+
+    texture->bind();
     {
-        exceptionMessageBox("Selection prop off-screen image buffer reset failed", e);
-    }
-    catch (...) {
-        exceptionMessageBox("Selection prop off-screen image buffer reset failed");
+        functions->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        functions->glPixelStorei(GL_UNPACK_ROW_LENGTH, _bufferSize.width());
+        functions->glTexSubImage2D(GL_TEXTURE_2D, 0, textureX, uploadRectangle.top(), uploadRectangle.width(), uploadRectangle.height(), GL_RED, GL_UNSIGNED_BYTE, _rasterizer.getData() + static_cast<std::size_t>(uploadRectangle.top()) * _bufferSize.width() + textureX);
+        functions->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        functions->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     }
+    texture->release();
 }
 
-QImage SelectionToolProp::getSelectionImage()
+void SelectionToolProp::validateRasterizedSelection()
 {
-    // Return empty image when the FBO is invalid
-    if (_fbo.isNull())
-        return QImage();
-
     getRenderer().bindOpenGLContext();
+    {
+        // The shader result was read back last, it is compared once the transfer completed
+        if (_readBackIndex < 0 || isReadBackComplete(_readBackIndex)) {
+            const auto selectionBuffer = mapReadBack(_readBackIndex);
+
+            const auto readBackRectangle    = selectionBuffer.isEmpty() ? QRect() : selectionBuffer.getRectangle();
+            const auto comparedRectangle    = readBackRectangle.united(_rasterizer.getDirtyRectangle());
+            const auto rasterizedData       = _rasterizer.getData();
+
+            std::size_t numberOfMismatches = 0;
+
+            // Both buffers are cleared outside their region
+            for (std::int32_t pixelY = comparedRectangle.top(); pixelY <= comparedRectangle.bottom(); pixelY++) {
+                for (std::int32_t pixelX = comparedRectangle.left(); pixelX <= comparedRectangle.right(); pixelX++) {
+                    const auto selectedByShader     = readBackRectangle.contains(pixelX, pixelY) && selectionBuffer.getScanLine(pixelY)[(pixelX - readBackRectangle.left()) * SelectionBuffer::pixelStep] != 0;
+                    const auto selectedByRasterizer = rasterizedData[static_cast<std::size_t>(pixelY) * _bufferSize.width() + (_bufferSize.width() - 1 - pixelX)] != 0;
+
+                    if (selectedByShader != selectedByRasterizer)
+                        numberOfMismatches++;
+                }
+            }
+
+            unmapPixelPackBuffer();
 
-    // Convert the FBO to image and return
-    return _fbo->toImage();
+            if (numberOfMismatches > 0)
+                qWarning() << "Rasterized pixel selection differs from the off-screen shader result in" << numberOfMismatches << "pixels of" << comparedRectangle;
+        }
+        else {
+            getRenderer().requestIdleTask(&_layer, "ValidateSelection", [this]() -> void {
+                validateRasterizedSelection();
+            });
+        }
+    }
+    getRenderer().releaseOpenGLContext();
 }
 
-void SelectionToolProp::loadSelectionToolShaderProgram()
+void SelectionToolProp::loadSelectionToolShaderProgram(const std::function<void()>& loaded)
 {
     // Load vertex/fragment shaders from resources
     const auto vertexShader     = loadFileContents(":Shaders/SelectionToolVertex.glsl");
     const auto fragmentShader   = loadFileContents(":Shaders/SelectionToolFragment.glsl");
 
-    // Get selection tool shader program
-    const auto selectionToolShaderProgram = getShaderProgramByName("SelectionTool");
-
-    // Assign vertex shader to shader program
-    if (!selectionToolShaderProgram->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader))
-        throw std::runtime_error("Unable to compile selection tool prop vertex shader");
-
-    // Assign fragment shader to shader program
-    if (!selectionToolShaderProgram->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader))
-        throw std::runtime_error("Unable to compile selection tool prop fragment shader");
+    loadShaderProgram("SelectionTool", vertexShader, fragmentShader, [this, loaded]() -> void {
 
-    // Link the shader program
-    if (!selectionToolShaderProgram->link())
-        throw std::runtime_error("Unable to link selection tool prop shader program");
+        // Get shader program
+        const auto selectionToolShaderProgram = getShaderProgramByName("SelectionTool");
 
-    // Number of bytes per stride
-    const auto stride = 5 * sizeof(GLfloat);
+        // Number of bytes per stride
+        const auto stride = 5 * sizeof(GLfloat);
 
-    // Get quad shape
-    auto shape = getShapeByName<QuadShape>("Quad");
+        // Get quad shape
+        auto shape = getShapeByName<QuadShape>("Quad");
 
-    // Bind the shader program
-    if (!selectionToolShaderProgram->bind())
-        throw std::runtime_error("Unable to bind selection tool shader program");
+        // Bind the shader program
+        if (!selectionToolShaderProgram->bind())
+            throw std::runtime_error("Unable to bind selection tool shader program");
 
-    shape->getVAO().bind();
-    {
-        shape->getVBO().bind();
+        shape->getVAO().bind();
         {
-            // Configure shader program
-            selectionToolShaderProgram->enableAttributeArray(QuadShape::_vertexAttribute);
-            selectionToolShaderProgram->enableAttributeArray(QuadShape::_textureAttribute);
-            selectionToolShaderProgram->setAttributeBuffer(QuadShape::_vertexAttribute, GL_FLOAT, 0, 3, stride);
-            selectionToolShaderProgram->setAttributeBuffer(QuadShape::_textureAttribute, GL_FLOAT, 3 * sizeof(GLfloat), 2, stride);
-            selectionToolShaderProgram->release();
+            shape->getVBO().bind();
+            {
+                // Configure shader program
+                selectionToolShaderProgram->enableAttributeArray(QuadShape::_vertexAttribute);
+                selectionToolShaderProgram->enableAttributeArray(QuadShape::_textureAttribute);
+                selectionToolShaderProgram->setAttributeBuffer(QuadShape::_vertexAttribute, GL_FLOAT, 0, 3, stride);
+                selectionToolShaderProgram->setAttributeBuffer(QuadShape::_textureAttribute, GL_FLOAT, 3 * sizeof(GLfloat), 2, stride);
+                selectionToolShaderProgram->release();
+            }
+            shape->getVAO().release();
         }
-        shape->getVAO().release();
-    }
-    shape->getVBO().release();
+        shape->getVBO().release();
+
+        loaded();
+    });
 }
 
-void SelectionToolProp::loadSelectionToolOffScreenShaderProgram()
+void SelectionToolProp::loadSelectionToolOffScreenShaderProgram(const std::function<void()>& loaded)
 {
     // Load vertex/fragment shaders from resources
     const auto vertexShader     = loadFileContents(":Shaders/SelectionToolOffScreenVertex.glsl");
     const auto fragmentShader   = loadFileContents(":Shaders/SelectionToolOffScreenFragment.glsl");
 
-    // Get selection tool off-screen shader program
-    const auto selectionToolOffScreenShaderProgram = getShaderProgramByName("SelectionToolOffScreen");
-
-    // Assign vertex shader to shader program
-    if (!selectionToolOffScreenShaderProgram->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader))
-        throw std::runtime_error("Unable to compile selection tool off-screen vertex shader");
+    loadShaderProgram("SelectionToolOffScreen", vertexShader, fragmentShader, [this, loaded]() -> void {
 
-    // Assign fragment shader to shader program
-    if (!selectionToolOffScreenShaderProgram->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader))
-        throw std::runtime_error("Unable to compile selection tool off-screen fragment shader");
+        // Get shader program
+        const auto selectionToolOffScreenShaderProgram = getShaderProgramByName("SelectionToolOffScreen");
 
-    // Link the shader program
-    if (!selectionToolOffScreenShaderProgram->link())
-        throw std::runtime_error("Unable to link selection tool off-screen shader program");
+        // Number of bytes per stride
+        const auto stride = 5 * sizeof(GLfloat);
 
-    // Number of bytes per stride
-    const auto stride = 5 * sizeof(GLfloat);
+        // Get quad shape
+        auto shape = getShapeByName<QuadShape>("Quad");
 
-    // Get quad shape
-    auto shape = getShapeByName<QuadShape>("Quad");
-
-    // Bind the shader program
-    if (!selectionToolOffScreenShaderProgram->bind())
-        throw std::runtime_error("Unable to bind selection tool off-screen shader program");
+        // Bind the shader program
+        if (!selectionToolOffScreenShaderProgram->bind())
+            throw std::runtime_error("Unable to bind selection tool off-screen shader program");
 
-    shape->getVAO().bind();
-    {
-        shape->getVBO().bind();
+        shape->getVAO().bind();
         {
-            // Configure shader program
-            selectionToolOffScreenShaderProgram->enableAttributeArray(QuadShape::_vertexAttribute);
-            selectionToolOffScreenShaderProgram->enableAttributeArray(QuadShape::_textureAttribute);
-            selectionToolOffScreenShaderProgram->setAttributeBuffer(QuadShape::_vertexAttribute, GL_FLOAT, 0, 3, stride);
-            selectionToolOffScreenShaderProgram->setAttributeBuffer(QuadShape::_textureAttribute, GL_FLOAT, 3 * sizeof(GLfloat), 2, stride);
-            selectionToolOffScreenShaderProgram->release();
+            shape->getVBO().bind();
+            {
+                // Configure shader program
+                selectionToolOffScreenShaderProgram->enableAttributeArray(QuadShape::_vertexAttribute);
+                selectionToolOffScreenShaderProgram->enableAttributeArray(QuadShape::_textureAttribute);
+                selectionToolOffScreenShaderProgram->setAttributeBuffer(QuadShape::_vertexAttribute, GL_FLOAT, 0, 3, stride);
+                selectionToolOffScreenShaderProgram->setAttributeBuffer(QuadShape::_textureAttribute, GL_FLOAT, 3 * sizeof(GLfloat), 2, stride);
+                selectionToolOffScreenShaderProgram->release();
+            }
+            shape->getVAO().release();
         }
-        shape->getVAO().release();
-    }
-    shape->getVBO().release();
+        shape->getVBO().release();
+
+        loaded();
+    });
 }
\ No newline at end of file
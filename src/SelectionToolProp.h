@@ -1,8 +1,14 @@
 #pragma once
 
 #include "Prop.h"
+#include "SelectionRasterizer.h"
 
-#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QRect>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
 
 class Layer;
 
@@ -15,6 +21,52 @@ class Layer;
  */
 class SelectionToolProp : public Prop
 {
+public:
+
+    /**
+     * Selection buffer class
+     *
+     * Read-only view on the region of the off-screen (or rasterized) selection buffer that was touched by the selection tool
+     * Pixels are stored in OpenGL order (columns are mirrored with respect to the image), use
+     * getScanLine() and pixelStep to walk a row in image order without mirroring the data
+     */
+    class SelectionBuffer
+    {
+    public:
+
+        /** Distance in bytes between two horizontally adjacent pixels in image order */
+        static constexpr std::ptrdiff_t pixelStep = -1;
+
+        /** Returns whether the buffer contains no pixels */
+        bool isEmpty() const { return _data == nullptr || _rectangle.isEmpty(); }
+
+        /** Returns the buffer region in image coordinates */
+        QRect getRectangle() const { return _rectangle; }
+
+        /**
+         * Get pointer to the left-most pixel of the buffer region in image row \p pixelY
+         * @param pixelY Image row (must lie within the buffer region)
+         * @return Pointer to the left-most pixel byte, successive pixels are at multiples of pixelStep
+         */
+        const std::uint8_t* getScanLine(std::int32_t pixelY) const {
+            return _data + static_cast<std::ptrdiff_t>(pixelY - _rectangle.top()) * _stride + (_rectangle.width() - 1);
+        }
+
+    private:
+        const std::uint8_t*     _data = nullptr;    /** Pointer to the mapped pixel data */
+        std::ptrdiff_t          _stride = 0;        /** Distance in bytes between two rows */
+        QRect                   _rectangle;         /** Buffer region in image coordinates */
+
+        friend class SelectionToolProp;
+    };
+
+    /** Pixel selection rasterizers (in the order of the selection action rasterizer options) */
+    enum class Rasterizer {
+        Gpu,        /** Off-screen fragment shader */
+        Cpu,        /** Scanline rasterizer (see SelectionRasterizer) */
+        Validate    /** Both, the shader result is used and differences are reported */
+    };
+
 public:
 
     /**
@@ -32,6 +84,9 @@ public:
     /** Initializes the prop */
     void initialize() override;
 
+    /** Destroys the prop */
+    void destroy() override;
+
     /**
      * Renders the prop
      * @param modelViewProjectionMatrix Model view projection matrix
@@ -51,6 +106,7 @@ public: // Pixel selection
 
     /** 
      * Computes the pixel selection (based on the tool) and stores the result in an off-screen pixel selection buffer
+     * Depending on the selection action rasterizer, the selection is rendered by a shader, rasterized on the CPU or both (for validation)
      * @param mousePositions Mouse positions
      */
     void compute(const QVector<QPoint>& mousePositions);
@@ -58,18 +114,117 @@ public: // Pixel selection
     /** Resets the off-screen pixel selection buffer */
     void resetOffScreenSelectionBuffer();
 
-    /** Returns the pixel selection in image format */
-    QImage getSelectionImage();
+    /** Pins the most recent read back of the off-screen selection buffer so that it is not overwritten until it is mapped (supersedes a previously pinned read back) */
+    void pinSelectionBuffer();
+
+    /**
+     * Polls (without waiting) whether the transfer of the pinned (or else the most recent) read back completed
+     * @return Whether mapSelectionBuffer() can be called
+     */
+    bool isSelectionBufferReady();
+
+    /**
+     * Maps the pinned (or else the most recent) read back of the off-screen selection buffer into client memory
+     * The transfer must be complete (see isSelectionBufferReady()), unmapSelectionBuffer() must be called once the buffer is consumed
+     * @return Selection buffer view on the touched region (empty when nothing is selected)
+     */
+    SelectionBuffer mapSelectionBuffer();
+
+    /** Unmaps the selection buffer that was mapped with mapSelectionBuffer() and unpins the read back */
+    void unmapSelectionBuffer();
+
+    /** Returns the region of the off-screen selection buffer touched by the selection tool since the last reset (in image coordinates) */
+    QRect getDirtyRectangle() const;
+
+private: // Selection buffer
+
+    /** Creates the off-screen selection buffer render target and pixel pack buffers for the current image size (only the rasterizer buffer when off-screen rendering is disabled) */
+    void createSelectionBuffer();
+
+    /** Deletes the off-screen selection buffer render target and pixel pack buffers (assumes a current OpenGL context) */
+    void destroySelectionBuffer();
+
+    /**
+     * Convert \p rectangle in image world coordinates to the (conservative) rectangle of pixels that it may cover
+     * @param rectangle Rectangle in image world coordinates
+     * @return Rectangle in image pixel coordinates, clipped to the image
+     */
+    QRect getPixelRectangle(const QRectF& rectangle) const;
+
+    /** Unmaps the mapped pixel pack buffer (assumes a current OpenGL context) */
+    void unmapPixelPackBuffer();
+
+    /** Starts an asynchronous read back of the dirty region of the selection buffer into the next pixel pack buffer */
+    void readBackSelectionBuffer();
+
+    /**
+     * Polls (without waiting) whether the transfer into pixel pack buffer \p readBackIndex completed (assumes a current OpenGL context)
+     * @param readBackIndex Index of the pixel pack buffer
+     * @return Whether the transfer completed
+     */
+    bool isReadBackComplete(std::int32_t readBackIndex);
+
+    /**
+     * Maps pixel pack buffer \p readBackIndex into client memory, the transfer must be complete (assumes a current OpenGL context)
+     * @param readBackIndex Index of the pixel pack buffer (-1 if none)
+     * @return Selection buffer view on the read back region (empty when nothing was read back)
+     */
+    SelectionBuffer mapReadBack(std::int32_t readBackIndex);
+
+private: // Rasterization
+
+    /** Get the rasterizer that is selected in the selection action */
+    Rasterizer getRasterizer() const;
+
+    /**
+     * Renders the pixel selection into the off-screen selection buffer and starts the read back (assumes a current OpenGL context)
+     * @param mousePositions Mouse positions
+     */
+    void rasterizeOnGpu(const QVector<QPoint>& mousePositions);
+
+    /**
+     * Rasterizes the pixel selection into the client-side selection buffer
+     * @param mousePositions Mouse positions
+     * @return Region of which the pixels changed (in image coordinates)
+     */
+    QRect rasterizeOnCpu(const QVector<QPoint>& mousePositions);
+
+    /**
+     * Uploads \p rectangle of the rasterized selection to the selection buffer texture (assumes a current OpenGL context)
+     * @param rectangle Region in image coordinates
+     */
+    void uploadRasterizedSelection(const QRect& rectangle);
+
+    /** Compares the read back of the off-screen selection buffer with the rasterized selection and reports the number of differing pixels (polls again in the next refresh interval when the read back is not complete) */
+    void validateRasterizedSelection();
 
 private: // Shader programs
 
-    /** Loads the shader program for the selection tool rendering */
-    void loadSelectionToolShaderProgram();
+    /**
+     * Loads the shader program for the selection tool rendering
+     * @param loaded Invoked once the shader program is linked and the quad vertex array is configured
+     */
+    void loadSelectionToolShaderProgram(const std::function<void()>& loaded);
 
-    /** Loads the shader program for the selection tool off-screen rendering */
-    void loadSelectionToolOffScreenShaderProgram();
+    /**
+     * Loads the shader program for the selection tool off-screen rendering
+     * @param loaded Invoked once the shader program is linked and the quad vertex array is configured
+     */
+    void loadSelectionToolOffScreenShaderProgram(const std::function<void()>& loaded);
 
 private:
-    Layer&                                      _layer;     /** Reference to layer */
-    QScopedPointer<QOpenGLFramebufferObject>    _fbo;       /** Frame Buffer Object for off screen pixel selection tools */
+    Layer&                      _layer;                 /** Reference to layer */
+    QSize                       _bufferSize;            /** Size of the off-screen selection buffer */
+    GLuint                      _framebuffer;           /** Frame Buffer Object for off screen pixel selection tools (single channel R8 color attachment) */
+    QRect                       _dirtyRectangle;        /** Region touched by the selection tool since the last reset (in image coordinates) */
+    std::array<GLuint, 3>       _pixelPackBuffers;      /** Pixel pack buffers for asynchronous read back (the most recent, the pinned and the next read back) */
+    std::array<GLsync, 3>       _readBackFences;        /** Fences that signal completion of the read back into the pixel pack buffers */
+    std::array<QRect, 3>        _readBackRectangles;    /** Image regions stored in the pixel pack buffers */
+    std::array<GLsizeiptr, 3>   _readBackCapacities;    /** Allocated sizes of the pixel pack buffers */
+    std::int32_t                _readBackIndex;         /** Index of the pixel pack buffer with the most recent read back (-1 if none) */
+    std::int32_t                _pinnedIndex;           /** Index of the pixel pack buffer that is pinned for mapping (-1 if none) */
+    std::int32_t                _mappedIndex;           /** Index of the pixel pack buffer that is mapped into client memory (-1 if none) */
+    SelectionRasterizer         _rasterizer;            /** Client-side selection rasterizer */
+    bool                        _rasterized;            /** Whether the current selection was rasterized on the CPU (it is mapped from the rasterizer then) */
+    bool                        _offScreen;             /** Whether the off-screen selection buffer is used (disabled for streamed images, which might exceed the maximum texture size) */
 };
\ No newline at end of file
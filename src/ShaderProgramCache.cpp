@@ -0,0 +1,372 @@
+#include "ShaderProgramCache.h"
+#include "GLLoader.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QPointer>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+ShaderProgramCache::ShaderProgramCache(GLLoader& loader, QObject* parent /*= nullptr*/) :
+    QObject(parent),
+    _loader(loader),
+    _entries(),
+    _binaryCache(std::make_shared<BinaryCache>())
+{
+    _binaryCache->_directory        = QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("ShaderPrograms");
+    _binaryCache->_numberOfHits     = 0;
+    _binaryCache->_numberOfMisses   = 0;
+}
+
+ShaderProgramCache::ShaderProgram ShaderProgramCache::acquire(const QString& vertexShader, const QString& fragmentShader, const QStringList& defines /*= QStringList()*/)
+{
+    const auto specializedVertexShader      = specializeShaderSource(vertexShader, defines);
+    const auto specializedFragmentShader    = specializeShaderSource(fragmentShader, defines);
+    const auto key                          = getKey(specializedVertexShader, specializedFragmentShader);
+
+    auto& entry = _entries[key];
+
+    // Share the program when it is still in use
+    if (auto shaderProgram = entry._shaderProgram.toStrongRef())
+        return shaderProgram;
+
+    // Drop the entries of programs that are no longer in use
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        if (it.key() != key && it->_shaderProgram.isNull() && !it->_compiling)
+            it = _entries.erase(it);
+        else
+            ++it;
+    }
+
+    auto shaderProgram = ShaderProgram::create();
+
+    _entries[key] = { shaderProgram, specializedVertexShader, specializedFragmentShader, false, false, {} };
+
+    return shaderProgram;
+}
+
+void ShaderProgramCache::load(const ShaderProgram& shaderProgram, QObject* receiver, const Loaded& loaded)
+{
+    auto entry = findEntry(shaderProgram);
+
+    if (entry == nullptr)
+        return;
+
+    QPointer<QObject> guardedReceiver(receiver);
+
+    const auto guardedLoaded = [guardedReceiver, loaded]() -> void {
+        if (!guardedReceiver.isNull())
+            loaded();
+    };
+
+    // Compiled already (possibly without success), no need to compile again
+    if (!entry->_compiling && entry->_compiled) {
+        guardedLoaded();
+        return;
+    }
+
+    entry->_waiting.push_back(guardedLoaded);
+
+    // Another prop requested the program already
+    if (entry->_compiling)
+        return;
+
+    const auto vertexShader     = entry->_vertexShader;
+    const auto fragmentShader   = entry->_fragmentShader;
+    const auto key              = getKey(vertexShader, fragmentShader);
+    const auto binaryCache      = _binaryCache;
+    const auto compiled         = std::make_shared<std::atomic<bool>>(false);
+
+    // Compiles in the loader context (the job does not run when the loader context cannot be made current)
+    const auto compileJob = [shaderProgram, binaryCache, vertexShader, fragmentShader, compiled]() -> void {
+        compileShaderProgram(*shaderProgram, *binaryCache, vertexShader, fragmentShader);
+
+        *compiled = true;
+    };
+
+    // Notifies the waiting props on the GUI thread
+    const auto finished = [this, key, compiled]() -> void {
+        emit binaryCacheStatisticsChanged();
+
+        if (!_entries.contains(key))
+            return;
+
+        auto& entry = _entries[key];
+
+        entry._compiling    = false;
+        entry._compiled     = compiled->load();
+
+        const auto waiting = std::move(entry._waiting);
+
+        entry._waiting.clear();
+
+        for (const auto& loaded : waiting)
+            loaded();
+    };
+
+    entry->_compiling = true;
+
+    // Without a loader, the waiting props compile the program in the viewer context
+    if (!_loader.enqueue(this, compileJob, finished))
+        finished();
+}
+
+bool ShaderProgramCache::compile(const ShaderProgram& shaderProgram)
+{
+    auto entry = findEntry(shaderProgram);
+
+    if (entry == nullptr || entry->_compiling)
+        return false;
+
+    if (!entry->_compiled) {
+        compileShaderProgram(*shaderProgram, *_binaryCache, entry->_vertexShader, entry->_fragmentShader);
+
+        entry->_compiled = true;
+
+        emit binaryCacheStatisticsChanged();
+    }
+
+    return shaderProgram->isLinked();
+}
+
+bool ShaderProgramCache::isCompiling(const ShaderProgram& shaderProgram) const
+{
+    for (const auto& entry : _entries)
+        if (entry._shaderProgram == shaderProgram)
+            return entry._compiling;
+
+    return false;
+}
+
+std::int32_t ShaderProgramCache::getNumberOfShaderPrograms() const
+{
+    std::int32_t numberOfShaderPrograms = 0;
+
+    for (const auto& entry : _entries)
+        if (!entry._shaderProgram.isNull())
+            numberOfShaderPrograms++;
+
+    return numberOfShaderPrograms;
+}
+
+std::int32_t ShaderProgramCache::getNumberOfBinaryCacheHits() const
+{
+    return _binaryCache->_numberOfHits;
+}
+
+std::int32_t ShaderProgramCache::getNumberOfBinaryCacheMisses() const
+{
+    return _binaryCache->_numberOfMisses;
+}
+
+QString ShaderProgramCache::getBinaryCacheDirectory() const
+{
+    return _binaryCache->_directory;
+}
+
+QString ShaderProgramCache::specializeShaderSource(const QString& shaderSource, const QStringList& defines)
+{
+    if (defines.isEmpty())
+        return shaderSource;
+
+    QString definitions;
+
+    for (const auto& define : defines)
+        definitions += QString("#define %1\n").arg(define);
+
+    // The version directive has to remain the first statement
+    const auto versionEnd = shaderSource.startsWith("#version") ? shaderSource.indexOf('\n') + 1 : 0;
+
+    return QString(shaderSource).insert(versionEnd, definitions);
+}
+
+void ShaderProgramCache::compileShaderProgram(QOpenGLShaderProgram& shaderProgram, BinaryCache& binaryCache, const QString& vertexShader, const QString& fragmentShader)
+{
+    auto functions = QOpenGLContext::currentContext()->extraFunctions();
+
+    if (!shaderProgram.create())
+        return;
+
+    GLint numberOfBinaryFormats = 0;
+
+    functions->glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numberOfBinaryFormats);
+
+    // Compile from source when the driver does not support program binaries
+    if (numberOfBinaryFormats <= 0) {
+        linkShaderProgram(shaderProgram, vertexShader, fragmentShader);
+        return;
+    }
+
+    const auto binaryFilePath = getBinaryFilePath(binaryCache, vertexShader, fragmentShader);
+
+    QFile binaryFile(binaryFilePath);
+
+    if (binaryFile.open(QIODevice::ReadOnly)) {
+        QDataStream dataStream(&binaryFile);
+
+        quint32 binaryFormat = 0;
+        QByteArray binary;
+
+        dataStream >> binaryFormat >> binary;
+
+        binaryFile.close();
+
+        if (dataStream.status() == QDataStream::Ok && !binary.isEmpty()) {
+            functions->glProgramBinary(shaderProgram.programId(), binaryFormat, binary.constData(), binary.size());
+
+            GLint linkStatus = GL_FALSE;
+
+            functions->glGetProgramiv(shaderProgram.programId(), GL_LINK_STATUS, &linkStatus);
+
+            // Without shaders, link() only adopts the link status of the program binary
+            if (linkStatus == GL_TRUE && shaderProgram.link()) {
+                binaryCache._numberOfHits++;
+                return;
+            }
+        }
+
+        // The binary is stale (e.g. after a driver update) or corrupt, it is replaced below
+        qDebug() << "Program binary" << binaryFilePath << "was rejected, compiling from source";
+    }
+
+    binaryCache._numberOfMisses++;
+
+    functions->glProgramParameteri(shaderProgram.programId(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    if (!linkShaderProgram(shaderProgram, vertexShader, fragmentShader))
+        return;
+
+    GLint binaryLength = 0;
+
+    functions->glGetProgramiv(shaderProgram.programId(), GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+
+    if (binaryLength <= 0)
+        return;
+
+    GLenum binaryFormat = 0;
+    QByteArray binary(binaryLength, Qt::Uninitialized);
+
+    functions->glGetProgramBinary(shaderProgram.programId(), binaryLength, &binaryLength, &binaryFormat, binary.data());
+
+    binary.resize(binaryLength);
+
+    if (!QDir().mkpath(binaryCache._directory))
+        return;
+
+    // Written atomically, so other viewer instances never read a partial binary
+    QSaveFile saveFile(binaryFilePath);
+
+    if (!saveFile.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream dataStream(&saveFile);
+
+    dataStream << static_cast<quint32>(binaryFormat) << binary;
+
+    if (!saveFile.commit())
+        qDebug() << "Unable to store program binary" << binaryFilePath;
+}
+
+bool ShaderProgramCache::linkShaderProgram(QOpenGLShaderProgram& shaderProgram, const QString& vertexShader, const QString& fragmentShader)
+{
+    auto functions = QOpenGLContext::currentContext()->extraFunctions();
+
+    // QOpenGLShader objects would become children of the program, which lives in the GUI thread
+    const auto compileShader = [functions](GLenum type, const QString& shaderSource) -> GLuint {
+        const auto shader       = functions->glCreateShader(type);
+        const auto sourceCode   = shaderSource.toUtf8();
+        const auto sourceData   = sourceCode.constData();
+
+        functions->glShaderSource(shader, 1, &sourceData, nullptr);
+        functions->glCompileShader(shader);
+
+        GLint compileStatus = GL_FALSE;
+
+        functions->glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
+
+        if (compileStatus == GL_TRUE)
+            return shader;
+
+        GLint logLength = 0;
+
+        functions->glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+
+        QByteArray log(std::max(logLength, 1), '\0');
+
+        functions->glGetShaderInfoLog(shader, log.size(), nullptr, log.data());
+
+        qWarning() << "Unable to compile" << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << "shader:" << log.constData();
+
+        functions->glDeleteShader(shader);
+
+        return 0;
+    };
+
+    const auto vertexShaderId   = compileShader(GL_VERTEX_SHADER, vertexShader);
+    const auto fragmentShaderId = compileShader(GL_FRAGMENT_SHADER, fragmentShader);
+
+    auto linked = false;
+
+    if (vertexShaderId != 0 && fragmentShaderId != 0) {
+        functions->glAttachShader(shaderProgram.programId(), vertexShaderId);
+        functions->glAttachShader(shaderProgram.programId(), fragmentShaderId);
+
+        // Without QOpenGLShader children, link() links the attached shaders and retrieves the link status and log
+        linked = shaderProgram.link();
+
+        functions->glDetachShader(shaderProgram.programId(), vertexShaderId);
+        functions->glDetachShader(shaderProgram.programId(), fragmentShaderId);
+    }
+
+    // Deleting zero is silently ignored
+    functions->glDeleteShader(vertexShaderId);
+    functions->glDeleteShader(fragmentShaderId);
+
+    return linked;
+}
+
+QString ShaderProgramCache::getBinaryFilePath(const BinaryCache& binaryCache, const QString& vertexShader, const QString& fragmentShader)
+{
+    auto functions = QOpenGLContext::currentContext()->functions();
+
+    const auto getString = [functions](GLenum name) -> QByteArray {
+        return QByteArray(reinterpret_cast<const char*>(functions->glGetString(name)));
+    };
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    // Binaries are only valid for the driver that produced them
+    hash.addData(getString(GL_VENDOR));
+    hash.addData(getString(GL_RENDERER));
+    hash.addData(getString(GL_VERSION));
+    hash.addData(getKey(vertexShader, fragmentShader));
+
+    return QDir(binaryCache._directory).filePath(QString("%1.bin").arg(QString::fromLatin1(hash.result().toHex())));
+}
+
+QByteArray ShaderProgramCache::getKey(const QString& vertexShader, const QString& fragmentShader)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    hash.addData(vertexShader.toUtf8());
+    hash.addData(QByteArrayView("\0", 1));
+    hash.addData(fragmentShader.toUtf8());
+
+    return hash.result();
+}
+
+ShaderProgramCache::Entry* ShaderProgramCache::findEntry(const ShaderProgram& shaderProgram)
+{
+    for (auto& entry : _entries)
+        if (entry._shaderProgram == shaderProgram)
+            return &entry;
+
+    return nullptr;
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QSharedPointer>
+#include <QWeakPointer>
+#include <QOpenGLShaderProgram>
+#include <QStringList>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class GLLoader;
+
+/**
+ * Shader program cache class
+ *
+ * Registry of shader programs that are shared by all props of a renderer, keyed by (specialized) shader source code
+ *
+ * Props hold reference-counted handles to the programs, a program is released when the last prop that uses it is destroyed
+ * Programs are compiled once (on the loader thread when available), props that request a program that is still compiling wait for the same compilation
+ *
+ * Linked programs are persisted as program binaries in the user cache directory, keyed by driver (vendor, renderer and version) and shader sources (including the definitions)
+ * Later viewer instances load the binaries instead of compiling the sources, and fall back to compilation when the driver rejects a binary
+ */
+class ShaderProgramCache : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    /** Handle to a shared shader program */
+    using ShaderProgram = QSharedPointer<QOpenGLShaderProgram>;
+
+    /** Invoked on the GUI thread when a shader program finished compiling (it might have failed to link) */
+    using Loaded = std::function<void()>;
+
+public: // Construction
+
+    /**
+     * Construct with \p loader and \p parent object
+     * @param loader Reference to the loader which compiles programs in the background
+     * @param parent Pointer to parent object
+     */
+    ShaderProgramCache(GLLoader& loader, QObject* parent = nullptr);
+
+public: // Shader programs
+
+    /**
+     * Get the shared shader program for \p vertexShader and \p fragmentShader specialized with \p defines (the program is not compiled yet when it is new)
+     * @param vertexShader Vertex shader source code
+     * @param fragmentShader Fragment shader source code
+     * @param defines Preprocessor definitions (inserted after the version directive)
+     * @return Handle to the shared shader program
+     */
+    ShaderProgram acquire(const QString& vertexShader, const QString& fragmentShader, const QStringList& defines = QStringList());
+
+    /**
+     * Compile and link \p shaderProgram on the loader thread unless it is compiled (or compiling) already, and invoke \p loaded when it is done
+     * \p loaded is invoked immediately when the program is compiled already, and not at all when \p receiver is destroyed in the meantime
+     * When there is no loader, \p loaded is invoked right away and the program is compiled by compile()
+     * @param shaderProgram Handle to the shared shader program (acquired from this cache)
+     * @param receiver Receiver object (lives in the GUI thread)
+     * @param loaded Invoked on the GUI thread once the program finished compiling
+     */
+    void load(const ShaderProgram& shaderProgram, QObject* receiver, const Loaded& loaded);
+
+    /**
+     * Compile and link \p shaderProgram in the viewer context unless it is compiled (or compiling) already (the OpenGL context must be bound)
+     * @param shaderProgram Handle to the shared shader program (acquired from this cache)
+     * @return Whether the program is linked
+     */
+    bool compile(const ShaderProgram& shaderProgram);
+
+    /**
+     * Get whether \p shaderProgram is being compiled on the loader thread
+     * @param shaderProgram Handle to the shared shader program
+     * @return Whether the program is compiling
+     */
+    bool isCompiling(const ShaderProgram& shaderProgram) const;
+
+    /** Get the number of shader programs that are in use */
+    std::int32_t getNumberOfShaderPrograms() const;
+
+public: // Program binary cache
+
+    /** Get the number of programs that were loaded from a cached program binary */
+    std::int32_t getNumberOfBinaryCacheHits() const;
+
+    /** Get the number of programs that were compiled from source because no (valid) cached program binary was found */
+    std::int32_t getNumberOfBinaryCacheMisses() const;
+
+    /** Get the directory in which program binaries are stored */
+    QString getBinaryCacheDirectory() const;
+
+    /**
+     * Specialize \p shaderSource with \p defines (inserted after the version directive)
+     * @param shaderSource Shader source code
+     * @param defines Preprocessor definitions
+     * @return Specialized shader source code
+     */
+    static QString specializeShaderSource(const QString& shaderSource, const QStringList& defines);
+
+signals:
+
+    /** Signals that the program binary cache hit or miss count changed */
+    void binaryCacheStatisticsChanged();
+
+protected:
+
+    /** Persisted program binaries (shared with the loader thread) */
+    struct BinaryCache {
+        QString                     _directory;             /** Directory in which the program binaries are stored */
+        std::atomic<std::int32_t>   _numberOfHits;          /** Number of programs loaded from a binary */
+        std::atomic<std::int32_t>   _numberOfMisses;        /** Number of programs compiled from source */
+    };
+
+    /**
+     * Load \p shaderProgram from its cached program binary, or compile and link it in the current context and cache its binary
+     * @param shaderProgram Shader program
+     * @param binaryCache Program binary cache
+     * @param vertexShader Specialized vertex shader source code
+     * @param fragmentShader Specialized fragment shader source code
+     */
+    static void compileShaderProgram(QOpenGLShaderProgram& shaderProgram, BinaryCache& binaryCache, const QString& vertexShader, const QString& fragmentShader);
+
+    /**
+     * Compile \p vertexShader and \p fragmentShader in the current context and link them into \p shaderProgram
+     * The shaders are raw OpenGL objects instead of QOpenGLShader children, so that the program can be compiled on another thread than the one it lives in
+     * @param shaderProgram Shader program (created already)
+     * @param vertexShader Specialized vertex shader source code
+     * @param fragmentShader Specialized fragment shader source code
+     * @return Whether the program is linked
+     */
+    static bool linkShaderProgram(QOpenGLShaderProgram& shaderProgram, const QString& vertexShader, const QString& fragmentShader);
+
+    /**
+     * Get the path of the cached program binary for the driver of the current context
+     * @param binaryCache Program binary cache
+     * @param vertexShader Specialized vertex shader source code
+     * @param fragmentShader Specialized fragment shader source code
+     * @return Path of the program binary file
+     */
+    static QString getBinaryFilePath(const BinaryCache& binaryCache, const QString& vertexShader, const QString& fragmentShader);
+
+    /**
+     * Get the cache key of a shader program
+     * @param vertexShader Specialized vertex shader source code
+     * @param fragmentShader Specialized fragment shader source code
+     * @return Cache key (hash of the shader sources)
+     */
+    static QByteArray getKey(const QString& vertexShader, const QString& fragmentShader);
+
+private:
+
+    /** Cached shader program */
+    struct Entry {
+        QWeakPointer<QOpenGLShaderProgram>      _shaderProgram;     /** Weak reference to the shared program (props own it) */
+        QString                                 _vertexShader;      /** Specialized vertex shader source code */
+        QString                                 _fragmentShader;    /** Specialized fragment shader source code */
+        bool                                    _compiling;         /** Whether the program is being compiled on the loader thread */
+        bool                                    _compiled;          /** Whether the program was compiled (or loaded from a binary) already, possibly without success */
+        std::vector<Loaded>                     _waiting;           /** Invoked once the program finished compiling */
+    };
+
+    /**
+     * Get the entry of \p shaderProgram
+     * @param shaderProgram Handle to the shared shader program
+     * @return Pointer to the entry (nullptr if the program is not cached)
+     */
+    Entry* findEntry(const ShaderProgram& shaderProgram);
+
+private:
+    GLLoader&                       _loader;            /** Compiles programs in the background */
+    QHash<QByteArray, Entry>        _entries;           /** Cached shader programs by key */
+    std::shared_ptr<BinaryCache>    _binaryCache;       /** Persisted program binaries (outlives loader jobs) */
+};
@@ -0,0 +1,70 @@
+#include "TileCache.h"
+
+#include <stdexcept>
+
+TileCache::TileCache(std::int32_t numberOfSlots /*= 0*/) :
+    _numberOfSlots(0),
+    _freeSlots(),
+    _entries(),
+    _lookup()
+{
+    setNumberOfSlots(numberOfSlots);
+}
+
+void TileCache::setNumberOfSlots(std::int32_t numberOfSlots)
+{
+    _numberOfSlots = numberOfSlots;
+
+    clear();
+}
+
+void TileCache::clear()
+{
+    _entries.clear();
+    _lookup.clear();
+    _freeSlots.clear();
+
+    // Hand out the lowest slots first
+    for (std::int32_t slot = _numberOfSlots - 1; slot >= 0; slot--)
+        _freeSlots.push_back(slot);
+}
+
+std::int32_t TileCache::find(const Tile& tile)
+{
+    const auto it = _lookup.find(tile.getKey());
+
+    if (it == _lookup.end())
+        return -1;
+
+    // Move to the front of the recency list
+    _entries.splice(_entries.begin(), _entries, it->second);
+
+    return it->second->_slot;
+}
+
+std::int32_t TileCache::insert(const Tile& tile)
+{
+    if (_numberOfSlots <= 0)
+        throw std::runtime_error("Tile cache has no slots");
+
+    std::int32_t slot = -1;
+
+    if (!_freeSlots.empty()) {
+        slot = _freeSlots.back();
+
+        _freeSlots.pop_back();
+    }
+    else {
+
+        // Evict the least recently used tile
+        slot = _entries.back()._slot;
+
+        _lookup.erase(_entries.back()._key);
+        _entries.pop_back();
+    }
+
+    _entries.push_front({ tile.getKey(), slot });
+    _lookup[tile.getKey()] = _entries.begin();
+
+    return slot;
+}
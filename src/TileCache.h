@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Tile cache class
+ *
+ * Least-recently-used bookkeeping for a fixed number of texture slots in which image pyramid tiles are streamed
+ * The cache only tracks which tile occupies which slot, uploading the tile data is up to the owner
+ */
+class TileCache
+{
+public:
+
+    /** Tile identifier */
+    struct Tile {
+        std::int32_t    _level;     /** Pyramid level */
+        std::int32_t    _x;         /** Tile column */
+        std::int32_t    _y;         /** Tile row */
+
+        /** Get the tile key for hashing */
+        std::uint64_t getKey() const {
+            return (static_cast<std::uint64_t>(_level) << 48) | (static_cast<std::uint64_t>(static_cast<std::uint32_t>(_y) & 0xFFFFFF) << 24) | (static_cast<std::uint32_t>(_x) & 0xFFFFFF);
+        }
+    };
+
+public: // Construction
+
+    /**
+     * Construct with \p numberOfSlots
+     * @param numberOfSlots Number of texture slots
+     */
+    explicit TileCache(std::int32_t numberOfSlots = 0);
+
+public: // Slots
+
+    /** Get the number of slots */
+    std::int32_t getNumberOfSlots() const { return _numberOfSlots; }
+
+    /**
+     * Change the number of slots (evicts all tiles)
+     * @param numberOfSlots Number of texture slots
+     */
+    void setNumberOfSlots(std::int32_t numberOfSlots);
+
+    /** Evict all tiles */
+    void clear();
+
+    /**
+     * Get the slot of \p tile and mark it as most recently used
+     * @param tile Tile
+     * @return Slot index or -1 when the tile is not resident
+     */
+    std::int32_t find(const Tile& tile);
+
+    /**
+     * Assign a slot to \p tile, evicting the least recently used tile when all slots are occupied
+     * @param tile Tile (must not be resident)
+     * @return Slot index into which the tile data should be uploaded
+     */
+    std::int32_t insert(const Tile& tile);
+
+private:
+
+    /** Slot entry in the recency list */
+    struct Entry {
+        std::uint64_t   _key;       /** Tile key */
+        std::int32_t    _slot;      /** Slot index */
+    };
+
+    using Entries = std::list<Entry>;
+
+    std::int32_t                                        _numberOfSlots;     /** Number of texture slots */
+    std::vector<std::int32_t>                           _freeSlots;         /** Unoccupied slots */
+    Entries                                             _entries;           /** Occupied slots, most recently used first */
+    std::unordered_map<std::uint64_t, Entries::iterator> _lookup;           /** Tile key to entry lookup */
+};
@@ -13,7 +13,9 @@ ViewSettingsAction::ViewSettingsAction(QObject* parent, const QString& title) :
     _zoomMarginAction(this, "Zoom margin", 1.0f, 1000.0f, 100.0f),
     _backgroundColorAction(this, "Background color", QColor(50, 50, 50)),
     _animationEnabledAction(this, "Animation", false),
-    _smartZoomAction(this, "Smart zoom", false)
+    _smartZoomAction(this, "Smart zoom", false),
+    _frameBudgetAction(this, "Frame budget", 1, 50, 4),
+    _shaderCacheStatusAction(this, "Shader cache")
 {
     setIconByName("gear");
     setLabelSizingType(LabelSizingType::Auto);
@@ -22,14 +24,23 @@ ViewSettingsAction::ViewSettingsAction(QObject* parent, const QString& title) :
     _backgroundColorAction.setToolTip("Background color of the viewer");
     _animationEnabledAction.setToolTip("Enable animations");
     _smartZoomAction.setToolTip("Automatically zoom when selecting layers");
+    _frameBudgetAction.setToolTip("Time per frame that is spent on deferred work (e.g. publishing the region of interest)");
+    _shaderCacheStatusAction.setToolTip("Number of shader programs that were loaded from the on-disk program binary cache (hits) and compiled from source (misses)");
     
     addAction(&_zoomMarginAction);
     addAction(&_backgroundColorAction);
+    addAction(&_frameBudgetAction);
+    addAction(&_shaderCacheStatusAction);
     //addAction(&_animationEnabledAction);
     //addAction(&_smartZoomAction);
 
     _zoomMarginAction.setSuffix("px");
     _zoomMarginAction.setUpdateDuringDrag(false);
+
+    _frameBudgetAction.setSuffix("ms");
+
+    _shaderCacheStatusAction.setEnabled(false);
+    _shaderCacheStatusAction.setConnectionPermissionsToForceNone();
 }
 
 void ViewSettingsAction::initialize(ImageViewerPlugin* imageViewerPlugin)
@@ -62,9 +73,25 @@ void ViewSettingsAction::initialize(ImageViewerPlugin* imageViewerPlugin)
     
     updateAnimation();
 
+    const auto updateFrameBudget = [this, &imageViewerWidget]() {
+        imageViewerWidget.getRenderer().setFrameBudget(_frameBudgetAction.getValue());
+    };
+
+    updateFrameBudget();
+
+    auto& shaderProgramCache = imageViewerWidget.getRenderer().getShaderProgramCache();
+
+    const auto updateShaderCacheStatus = [this, &shaderProgramCache]() {
+        _shaderCacheStatusAction.setString(QString("%1 hits, %2 misses").arg(QString::number(shaderProgramCache.getNumberOfBinaryCacheHits()), QString::number(shaderProgramCache.getNumberOfBinaryCacheMisses())));
+    };
+
+    updateShaderCacheStatus();
+
     connect(&_zoomMarginAction, &DecimalAction::valueChanged, this, updateZoomMargin);
     connect(&_backgroundColorAction, &ColorAction::colorChanged, this, updateBackgroundColor);
     connect(&_animationEnabledAction, &ToggleAction::toggled, this, updateAnimation);
+    connect(&_frameBudgetAction, &IntegralAction::valueChanged, this, updateFrameBudget);
+    connect(&shaderProgramCache, &ShaderProgramCache::binaryCacheStatisticsChanged, this, updateShaderCacheStatus);
 }
 
 void ViewSettingsAction::connectToPublicAction(WidgetAction* publicAction, bool recursive)
@@ -81,6 +108,7 @@ void ViewSettingsAction::connectToPublicAction(WidgetAction* publicAction, bool
         actions().connectPrivateActionToPublicAction(&_backgroundColorAction, &publicViewSettingsAction->getBackgroundColorAction(), recursive);
         actions().connectPrivateActionToPublicAction(&_animationEnabledAction, &publicViewSettingsAction->getAnimationEnabledAction(), recursive);
         actions().connectPrivateActionToPublicAction(&_smartZoomAction, &publicViewSettingsAction->getSmartZoomAction(), recursive);
+        actions().connectPrivateActionToPublicAction(&_frameBudgetAction, &publicViewSettingsAction->getFrameBudgetAction(), recursive);
     }
 
     GroupAction::connectToPublicAction(publicAction, recursive);
@@ -96,6 +124,7 @@ void ViewSettingsAction::disconnectFromPublicAction(bool recursive)
         actions().disconnectPrivateActionFromPublicAction(&_backgroundColorAction, recursive);
         actions().disconnectPrivateActionFromPublicAction(&_animationEnabledAction, recursive);
         actions().disconnectPrivateActionFromPublicAction(&_smartZoomAction, recursive);
+        actions().disconnectPrivateActionFromPublicAction(&_frameBudgetAction, recursive);
     }
 
     GroupAction::disconnectFromPublicAction(recursive);
@@ -109,6 +138,7 @@ void ViewSettingsAction::fromVariantMap(const QVariantMap& variantMap)
     _backgroundColorAction.fromParentVariantMap(variantMap);
     _animationEnabledAction.fromParentVariantMap(variantMap);
     _smartZoomAction.fromParentVariantMap(variantMap);
+    _frameBudgetAction.fromParentVariantMap(variantMap);
 }
 
 QVariantMap ViewSettingsAction::toVariantMap() const
@@ -119,6 +149,7 @@ QVariantMap ViewSettingsAction::toVariantMap() const
     _backgroundColorAction.insertIntoVariantMap(variantMap);
     _animationEnabledAction.insertIntoVariantMap(variantMap);
     _smartZoomAction.insertIntoVariantMap(variantMap);
+    _frameBudgetAction.insertIntoVariantMap(variantMap);
 
     return variantMap;
 }
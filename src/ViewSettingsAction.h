@@ -4,6 +4,8 @@
 #include <actions/DecimalAction.h>
 #include <actions/ColorAction.h>
 #include <actions/ToggleAction.h>
+#include <actions/IntegralAction.h>
+#include <actions/StringAction.h>
 
 using namespace mv::gui;
 
@@ -70,6 +72,8 @@ public: // Action getters
     ColorAction& getBackgroundColorAction() { return _backgroundColorAction; }
     ToggleAction& getAnimationEnabledAction() { return _animationEnabledAction; }
     ToggleAction& getSmartZoomAction() { return _smartZoomAction; }
+    IntegralAction& getFrameBudgetAction() { return _frameBudgetAction; }
+    StringAction& getShaderCacheStatusAction() { return _shaderCacheStatusAction; }
 
 protected:
     ImageViewerPlugin*  _imageViewerPlugin;         /** Reference to image viewer plugin */
@@ -77,6 +81,8 @@ protected:
     ColorAction         _backgroundColorAction;     /** Background color action action */
     ToggleAction        _animationEnabledAction;    /** Animation on/off action */
     ToggleAction        _smartZoomAction;            /** Automatically zoom when selecting layers action */
+    IntegralAction      _frameBudgetAction;         /** Time budget for deferred (non-visual) work per frame action */
+    StringAction        _shaderCacheStatusAction;   /** Program binary cache hits and misses action (read-only) */
 };
 
 Q_DECLARE_METATYPE(ViewSettingsAction)